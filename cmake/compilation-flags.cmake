@@ -74,25 +74,40 @@ if(NUM_OF_TESTS)
   set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DNUM_OF_TESTS=${NUM_OF_TESTS}")
 endif()
 
-if(LEVEL)
+# MULTI_LEVEL builds the instances of all the levels and variants into one
+# library, and every instance sets the flags of its level and variant (see
+# cmake/multi-level.cmake). LEVEL, BIND_PK_AND_M, and USE_AES_AND_SHA2 select
+# only the instance of the tests and the tools in this case.
+if(LEVEL AND NOT MULTI_LEVEL)
   set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DLEVEL=${LEVEL}")
 endif()
 
+# The decoder of decode: BGF (default), BG or BACKFLIP
+if(DECODER)
+  set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DDECODER_DEFAULT=DECODER_${DECODER}")
+endif()
+
 if(UNIFORM_SAMPLING)
     set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DUNIFORM_SAMPLING=1")
 endif()
 
-if(BIND_PK_AND_M)
+if(BIND_PK_AND_M AND NOT MULTI_LEVEL)
   set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DBIND_PK_AND_M=1")
 endif()
 
+# The latency mode runs parts of a single operation on helper threads
+if(LATENCY_MODE)
+  set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DLATENCY_MODE=1")
+  set(LINK_THREADS 1)
+endif()
+
 # SHA3 is the default in Round-4 BIKE
 if(NOT USE_AES_AND_SHA2)
   set(USE_SHA3_AND_SHAKE ON)
 endif()
 
 # Using SHA3 and SHAKE forces the standalone implementation
-if(USE_SHA3_AND_SHAKE)
+if(USE_SHA3_AND_SHAKE AND NOT MULTI_LEVEL)
   set(STANDALONE_IMPL ON)
 endif()
 
@@ -101,7 +116,10 @@ endif()
 # that uses AES based PRF is not fully portable. However, if SHAKE based
 # PRF is used (USE_SHA3_AND_SHAKE flag is set) then the implementation
 # is fully portable because SHA3 and SHAKE are implemented in pure C.
-if(STANDALONE_IMPL)
+if(MULTI_LEVEL)
+  # The instances of the AES variants use the standalone implementation
+  # if STANDALONE_IMPL is set, and OpenSSL otherwise
+elseif(STANDALONE_IMPL)
   if((NOT X86_64) AND (NOT X86) AND (NOT USE_SHA3_AND_SHAKE))
     message(FATAL_ERROR " Standalone implementation with AES based PRNG works only on x86 systems.")
   endif()
@@ -129,6 +147,61 @@ if(USE_NIST_RAND)
 
 endif()
 
+# The kernels that are built. By default, all the kernels of the architecture
+# are built and the fastest ones are chosen at runtime (see cpu_features.c).
+# BIKE_TARGET_ISA builds only the kernels of one ISA, for fleets of known
+# CPUs: the features are fixed at compile time, the whole library is compiled
+# for the ISA, and the contexts are bound statically, so with LTO the kernels
+# are inlined into their callers. The values are:
+#   portable - no vector kernels (any CPU of the architecture)
+#   avx2     - AVX2 and PCLMULQDQ (x86_64, e.g., Haswell and newer)
+#   avx512   - AVX512-F/BW/DQ/VL/VBMI/VBMI2/BITALG and VPCLMULQDQ
+#              (x86_64, e.g., Ice Lake and newer, Zen 4)
+#   neon     - NEON and PMULL (AArch64 with the cryptographic extension)
+# The binary must run only on CPUs that support its ISA.
+if(BIKE_TARGET_ISA)
+  string(TOUPPER ${BIKE_TARGET_ISA} TARGET_ISA)
+
+  if(TARGET_ISA STREQUAL "PORTABLE")
+    # Only the portable kernels are built
+  elseif(X86_64 AND (TARGET_ISA STREQUAL "AVX2"))
+    set(KERNELS_AVX2 1)
+    set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -mavx2 -mpclmul")
+  elseif(X86_64 AND (TARGET_ISA STREQUAL "AVX512"))
+    set(KERNELS_AVX512 1)
+    set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -mavx2 -mavx512f -mavx512bw -mavx512dq -mavx512vl")
+    set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -mavx512vbmi -mavx512vbmi2 -mavx512bitalg -mvpclmulqdq")
+
+    # Keccak (SHA3 and SHAKE) is about a third slower when it is compiled
+    # with AVX512, and it does not call the kernels
+    set_source_files_properties(${PROJECT_SOURCE_DIR}/src/third_party_src/fips202.c PROPERTIES COMPILE_OPTIONS "-mno-avx512f")
+  elseif(AARCH64 AND (TARGET_ISA STREQUAL "NEON"))
+    set(KERNELS_NEON 1)
+    set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -march=armv8-a+crypto")
+  else()
+    message(FATAL_ERROR "BIKE_TARGET_ISA ${BIKE_TARGET_ISA} is not supported on this architecture")
+  endif()
+
+  set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DBIKE_TARGET_ISA=BIKE_ISA_${TARGET_ISA}")
+
+  # CMP0069 is set in the top-level CMakeLists.txt
+  if(POLICY CMP0069)
+    include(CheckIPOSupported)
+    check_ipo_supported(RESULT IPO_SUPPORTED OUTPUT IPO_OUTPUT)
+  endif()
+
+  if(IPO_SUPPORTED)
+    set(CMAKE_INTERPROCEDURAL_OPTIMIZATION ON)
+  else()
+    message(WARNING "LTO is not supported, the kernels are not inlined across files")
+  endif()
+elseif(X86_64)
+  set(KERNELS_AVX2 1)
+  set(KERNELS_AVX512 1)
+elseif(AARCH64)
+  set(KERNELS_NEON 1)
+endif()
+
 # List all files with avx2 and avx512 suffix
 FILE(GLOB_RECURSE AVX2_SRCS ${PROJECT_SOURCE_DIR}/src/*_avx2.c)
 FILE(GLOB_RECURSE AVX512_SRCS ${PROJECT_SOURCE_DIR}/src/*_avx512.c)
@@ -141,3 +214,11 @@ set_source_files_properties(${AVX512_SRCS} PROPERTIES COMPILE_OPTIONS "${AVX512_
 
 set_source_files_properties(${PROJECT_SOURCE_DIR}/src/gf2x/gf2x_mul_base_pclmul.c PROPERTIES COMPILE_OPTIONS "-mpclmul;")
 set_source_files_properties(${PROJECT_SOURCE_DIR}/src/gf2x/gf2x_mul_base_vpclmul.c PROPERTIES COMPILE_OPTIONS "-mvpclmulqdq;${AVX512_FLAGS}")
+set_source_files_properties(${PROJECT_SOURCE_DIR}/src/gf2x/gf2x_mul_base_vpclmul_avx2.c PROPERTIES COMPILE_OPTIONS "-mvpclmulqdq;-mavx2")
+set_source_files_properties(${PROJECT_SOURCE_DIR}/src/gf2x/gf2x_ksqr_vbmi.c PROPERTIES COMPILE_OPTIONS "-mavx512vbmi;-mavx512bitalg;-mavx512vl;${AVX512_FLAGS}")
+set_source_files_properties(${PROJECT_SOURCE_DIR}/src/gf2x/gf2x_red_vbmi2.c PROPERTIES COMPILE_OPTIONS "-mavx512vbmi2;${AVX512_FLAGS}")
+set_source_files_properties(${PROJECT_SOURCE_DIR}/src/decode/decode_vbmi2.c PROPERTIES COMPILE_OPTIONS "-mavx512vbmi2;${AVX512_FLAGS}")
+
+# NEON is part of the AArch64 baseline, PMULL requires the crypto extension
+# (it is used only if the CPU supports it, see cpu_features.c)
+set_source_files_properties(${PROJECT_SOURCE_DIR}/src/gf2x/gf2x_mul_base_pmull.c PROPERTIES COMPILE_OPTIONS "-march=armv8-a+crypto")
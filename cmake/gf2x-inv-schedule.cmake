@@ -0,0 +1,51 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# The exponentiation schedule of gf2x_mod_inv is generated at build time
+# by searching for a short addition chain for (r - 2), see
+# tools/gf2x_inv_chain.c. The cost weights can be set by the INV_CHAIN_*
+# flags, otherwise the defaults of the tool are used.
+#
+# Note: the custom command must be defined in the same directory as the target
+# that consumes its output.
+set(INV_CHAIN_FLAGS "")
+
+if(INV_CHAIN_MUL_COST)
+  list(APPEND INV_CHAIN_FLAGS -m ${INV_CHAIN_MUL_COST})
+endif()
+
+if(INV_CHAIN_SQR_COST)
+  list(APPEND INV_CHAIN_FLAGS -s ${INV_CHAIN_SQR_COST})
+endif()
+
+if(INV_CHAIN_K_SQR_COST)
+  list(APPEND INV_CHAIN_FLAGS -k ${INV_CHAIN_K_SQR_COST})
+endif()
+
+if(INV_CHAIN_MAX_REGS)
+  list(APPEND INV_CHAIN_FLAGS -g ${INV_CHAIN_MAX_REGS})
+endif()
+
+# Generates the schedule of the block size r (of LEVEL if r is empty) into
+# the header file schedule
+function(add_inv_schedule schedule r)
+  set(flags ${INV_CHAIN_FLAGS})
+  if(r)
+    list(APPEND flags -r ${r})
+  endif()
+
+  add_custom_command(
+    OUTPUT ${schedule}
+    COMMAND bike-inv-chain ${flags} -o ${schedule}
+    DEPENDS bike-inv-chain
+    COMMENT "Generating the inversion schedule"
+  )
+endfunction()
+
+# The instances of MULTI_LEVEL builds generate the schedules of their levels
+# (see cmake/multi-level.cmake)
+if(NOT MULTI_LEVEL)
+  set(GF2X_INV_SCHEDULE ${GENERATED_DIR}/gf2x_inv_schedule.h)
+  add_inv_schedule(${GF2X_INV_SCHEDULE} "")
+  target_sources(${PROJECT_NAME} PRIVATE ${GF2X_INV_SCHEDULE})
+endif()
@@ -0,0 +1,168 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# MULTI_LEVEL builds an instance of BIKE for every level (1, 3, and 5) and
+# every variant of MULTI_VARIANTS into one library. The variants (all of them
+# by default) and the prefixes of the symbols of their instances are:
+#   sha3      - Round-4 BIKE, bike_l<level>_
+#   sha3_bind - BIND_PK_AND_M, bike_l<level>_bind_
+#   aes       - USE_AES_AND_SHA2, bike_l<level>_aes_
+#   aes_bind  - USE_AES_AND_SHA2 and BIND_PK_AND_M, bike_l<level>_aes_bind_
+# Every instance is compiled from the sources of the library with the flags
+# of its level and variant, so it is specialized at compile time like the
+# library of a single level, and its symbols are renamed by bike_namespace.h.
+# The code that does not depend on the level and the variant (the CPU
+# features, the ISA policy, Keccak, and AES and SHA2) is compiled once, and
+# src/kem_multi.c selects the instance at runtime (see include/bike_kem.h).
+#
+# Note: the custom commands of the inversion schedules must be defined in the
+# same directory as the instances that consume them.
+
+if(NOT MULTI_VARIANTS)
+  set(MULTI_VARIANTS sha3 sha3_bind aes aes_bind)
+endif()
+
+# The block size r of the levels (see bike_defs.h)
+set(MULTI_R_BITS_1 12323)
+set(MULTI_R_BITS_3 24659)
+set(MULTI_R_BITS_5 40973)
+
+# The instance of the tests and the tools
+if(LEVEL)
+  set(PRIMARY_LEVEL ${LEVEL})
+else()
+  set(PRIMARY_LEVEL 1)
+endif()
+
+if(USE_AES_AND_SHA2)
+  set(PRIMARY_VARIANT aes)
+else()
+  set(PRIMARY_VARIANT sha3)
+endif()
+
+if(BIND_PK_AND_M)
+  set(PRIMARY_VARIANT ${PRIMARY_VARIANT}_bind)
+endif()
+
+set(MULTI_SHARED_SRCS
+  ${SRC_DIR}/common/cpu_features.c
+  ${SRC_DIR}/common/error.c
+  ${SRC_DIR}/common/isa_policy.c
+  ${SRC_DIR}/common/parallel.c
+  ${SRC_DIR}/third_party_src/fips202.c
+)
+
+set(AES_SHA2_SRCS
+  ${SRC_DIR}/random/sha.c
+  ${SRC_DIR}/random/aes.c
+)
+
+# The sources of the instances are the sources of the library (without the
+# PRFs, which depend on the variant)
+get_target_property(MULTI_INSTANCE_SRCS ${PROJECT_NAME} SOURCES)
+list(REMOVE_ITEM MULTI_INSTANCE_SRCS
+  ${MULTI_SHARED_SRCS}
+  ${AES_SHA2_SRCS}
+  ${SRC_DIR}/random/shake_prf.c
+  ${SRC_DIR}/random/aes_ctr_prf.c
+)
+
+set_property(TARGET ${PROJECT_NAME} PROPERTY SOURCES
+  ${MULTI_SHARED_SRCS}
+  ${SRC_DIR}/kem_multi.c
+)
+
+set(MULTI_INSTANCES "")
+
+foreach(level 1 3 5)
+  set(schedule_dir ${GENERATED_DIR}/l${level})
+  file(MAKE_DIRECTORY ${schedule_dir})
+  add_inv_schedule(${schedule_dir}/gf2x_inv_schedule.h ${MULTI_R_BITS_${level}})
+  add_custom_target(bike-inv-schedule-l${level}
+    DEPENDS ${schedule_dir}/gf2x_inv_schedule.h)
+
+  foreach(variant ${MULTI_VARIANTS})
+    set(defs LEVEL=${level})
+    set(options "")
+    set(srcs ${MULTI_INSTANCE_SRCS})
+
+    if(variant STREQUAL "sha3" OR variant STREQUAL "sha3_bind")
+      list(APPEND defs USE_SHA3_AND_SHAKE=1 STANDALONE_IMPL=1)
+      list(APPEND srcs ${SRC_DIR}/random/shake_prf.c)
+    elseif(variant STREQUAL "aes" OR variant STREQUAL "aes_bind")
+      list(APPEND srcs ${SRC_DIR}/random/aes_ctr_prf.c)
+
+      if(STANDALONE_IMPL)
+        if((NOT X86_64) AND (NOT X86))
+          message(FATAL_ERROR " Standalone implementation with AES based PRNG works only on x86 systems.")
+        endif()
+
+        list(APPEND defs STANDALONE_IMPL=1)
+        set(options -maes -mssse3)
+        set(MULTI_AES_SHA2 1)
+      else()
+        set(MULTI_LINK_OPENSSL 1)
+      endif()
+    else()
+      message(FATAL_ERROR "Unknown variant ${variant} in MULTI_VARIANTS")
+    endif()
+
+    if(variant MATCHES "_bind$")
+      list(APPEND defs BIND_PK_AND_M=1)
+    endif()
+
+    # E.g., bike_l1_ for sha3 and bike_l1_aes_bind_ for aes_bind
+    string(REGEX REPLACE "^sha3_?" "" prefix "${variant}")
+    if(prefix)
+      set(prefix "${prefix}_")
+    endif()
+    set(prefix bike_l${level}_${prefix})
+    list(APPEND defs BIKE_PREFIX=${prefix})
+
+    set(instance ${prefix}instance)
+    add_library(${instance} OBJECT ${srcs})
+    target_compile_definitions(${instance} PRIVATE ${defs})
+    target_compile_options(${instance} PRIVATE ${options})
+    target_include_directories(${instance} BEFORE PRIVATE ${schedule_dir})
+    add_dependencies(${instance} bike-inv-schedule-l${level})
+
+    target_sources(${PROJECT_NAME} PRIVATE $<TARGET_OBJECTS:${instance}>)
+    list(APPEND MULTI_INSTANCES "X(${prefix})")
+
+    if((level EQUAL PRIMARY_LEVEL) AND (variant STREQUAL PRIMARY_VARIANT))
+      set(PRIMARY_DEFS ${defs})
+      set(PRIMARY_OPTIONS ${options})
+    endif()
+  endforeach()
+endforeach()
+
+if(NOT PRIMARY_DEFS)
+  message(FATAL_ERROR "The instance of level ${PRIMARY_LEVEL} and variant ${PRIMARY_VARIANT} is not built (see MULTI_VARIANTS)")
+endif()
+
+if(MULTI_AES_SHA2)
+  target_sources(${PROJECT_NAME} PRIVATE ${AES_SHA2_SRCS})
+  set_source_files_properties(${AES_SHA2_SRCS} PROPERTIES
+    COMPILE_DEFINITIONS STANDALONE_IMPL=1
+    COMPILE_OPTIONS "-maes;-mssse3")
+endif()
+
+if(MULTI_LINK_OPENSSL)
+  find_package(OpenSSL REQUIRED)
+  target_link_libraries(${PROJECT_NAME} OpenSSL::Crypto)
+endif()
+
+# The list of the instances of src/kem_multi.c
+string(REPLACE ";" " " MULTI_INSTANCES "${MULTI_INSTANCES}")
+file(WRITE ${GENERATED_DIR}/bike_instances.h.tmp
+  "// Generated by cmake/multi-level.cmake\n"
+  "#pragma once\n\n"
+  "#define BIKE_INSTANCES(X) ${MULTI_INSTANCES}\n")
+configure_file(${GENERATED_DIR}/bike_instances.h.tmp
+  ${GENERATED_DIR}/bike_instances.h COPYONLY)
+
+# The tests and the tools use the internal API of one instance
+foreach(target bike-test bike-kernels-test bike-tune bike-decoders bike-dfr)
+  target_compile_definitions(${target} PRIVATE ${PRIMARY_DEFS})
+  target_compile_options(${target} PRIVATE ${PRIMARY_OPTIONS})
+endforeach()
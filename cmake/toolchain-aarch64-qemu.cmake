@@ -0,0 +1,31 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+# Cross-compiles for AArch64 Linux with the GNU toolchain, and runs the
+# programs of the build in qemu-aarch64 user mode: the try_run checks, the
+# generator of the inversion schedule, and the tests of CTest, e.g.:
+#   cmake -DCMAKE_TOOLCHAIN_FILE=../cmake/toolchain-aarch64-qemu.cmake \
+#         -DUSE_NIST_RAND=1 ..
+#   make
+#   ctest --output-on-failure
+# On Debian and Ubuntu, the gcc-aarch64-linux-gnu and qemu-user packages
+# provide the tools. USE_NIST_RAND (the KAT tests) also requires OpenSSL for
+# AArch64, which can be set by OPENSSL_ROOT_DIR. The emulated CPU can be set
+# by the QEMU_CPU environment variable of qemu (the default CPU supports the
+# cryptographic extension, so the PMULL kernels are used; a64fx does not).
+# tests/test_aarch64_qemu.sh runs the tests of all the levels on both.
+
+set(CMAKE_SYSTEM_NAME Linux)
+set(CMAKE_SYSTEM_PROCESSOR aarch64)
+
+set(AARCH64_TRIPLET aarch64-linux-gnu)
+set(AARCH64_SYSROOT /usr/${AARCH64_TRIPLET})
+
+set(CMAKE_C_COMPILER ${AARCH64_TRIPLET}-gcc)
+set(CMAKE_CROSSCOMPILING_EMULATOR qemu-aarch64 -L ${AARCH64_SYSROOT})
+
+set(CMAKE_FIND_ROOT_PATH ${AARCH64_SYSROOT})
+set(CMAKE_FIND_ROOT_PATH_MODE_PROGRAM NEVER)
+set(CMAKE_FIND_ROOT_PATH_MODE_LIBRARY ONLY)
+set(CMAKE_FIND_ROOT_PATH_MODE_INCLUDE ONLY)
+set(CMAKE_FIND_ROOT_PATH_MODE_PACKAGE ONLY)
@@ -0,0 +1,48 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// The ISAs (tiers of kernels) of BIKE_TARGET_ISA (see
+// cmake/compilation-flags.cmake) and of the ISA policy
+#define BIKE_ISA_AUTO     (0)
+#define BIKE_ISA_PORTABLE (1)
+#define BIKE_ISA_AVX2     (2)
+#define BIKE_ISA_AVX512   (3)
+#define BIKE_ISA_NEON     (4)
+#define BIKE_ISA_NUM      (5)
+
+// The ISA policy caps the tier of the kernels of every group of operations,
+// e.g., at BIKE_ISA_AVX2 to avoid the frequency drop that AVX512 causes on
+// some Xeon CPUs. Every group uses the best tier of the CPU that does not
+// exceed its cap, and BIKE_ISA_AUTO does not cap it. On AArch64, NEON is the
+// only vector tier, and only BIKE_ISA_PORTABLE caps it.
+// The policy is shared by all the instances of MULTI_LEVEL builds.
+typedef struct bike_isa_policy_s {
+  uint32_t gf2x;
+  uint32_t decode;
+  uint32_t sampling;
+} bike_isa_policy_t;
+
+// Set the ISA policy. Returns 0 (and keeps the current policy) if a cap is not
+// an ISA of the architecture. The policy is initialized from the
+// BIKE_ISA_POLICY environment variable when the library is loaded, e.g.,
+// "avx2" caps all the groups, and "gf2x=avx512,decode=avx2,sampling=avx2"
+// caps every group separately. The policy is replaced atomically, so it can
+// run concurrently with the other functions of the library: every operation
+// that starts after it returns uses the new policy, and the operations that
+// run meanwhile use either the old or the new policy.
+// BIKE_TARGET_ISA builds ignore the policy (and this function returns 0).
+uint32_t bike_set_isa_policy(const bike_isa_policy_t *policy);
+
+// The tiers that the groups use now, for observability (never BIKE_ISA_AUTO).
+void bike_get_isa_tiers(bike_isa_policy_t *tiers);
+
+// The name of the ISA, e.g., "avx2", or NULL if it is unknown.
+const char *bike_isa_name(uint32_t isa);
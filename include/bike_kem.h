@@ -0,0 +1,43 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The front end of MULTI_LEVEL builds (see cmake/multi-level.cmake), whose
+// library contains an instance of BIKE for every level and variant. Every
+// instance is specialized at compile time like the library of a single level,
+// and its symbols carry the prefix bike_l<level>_<variant>_ (e.g.,
+// bike_l3_crypto_kem_enc or bike_l1_aes_bind_crypto_kem_dec). The front end
+// selects an instance at runtime, e.g., to negotiate the parameters.
+
+// The variants are combinations of the flags below. The default variant (0)
+// is Round-4 BIKE, with SHA3 and SHAKE.
+#define BIKE_VARIANT_BIND_PK_AND_M   (1) // Bind the public key and the message
+#define BIKE_VARIANT_USE_AES_AND_SHA2 (2) // AES and SHA2 instead of SHA3/SHAKE
+
+typedef struct bike_kem_s {
+  uint32_t level;
+  uint32_t variant;
+
+  size_t pk_bytes;
+  size_t sk_bytes;
+  size_t ct_bytes;
+  size_t ss_bytes;
+
+  // The NIST API of the instance (see kem.h)
+  int (*keypair)(unsigned char *pk, unsigned char *sk);
+  int (*enc)(unsigned char *ct, unsigned char *ss, const unsigned char *pk);
+  int (*dec)(unsigned char *ss, const unsigned char *ct,
+             const unsigned char *sk);
+} bike_kem_t;
+
+// Returns the instance of the level (1, 3, or 5) and the variant, or NULL if
+// it is not built (see MULTI_VARIANTS).
+const bike_kem_t *bike_kem_get(uint32_t level, uint32_t variant);
@@ -0,0 +1,49 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ */
+
+// This file contains definitions of macros for the NEON intrinsic functions
+// of AArch64, in the same style as x86_64_intrinsic.h.
+
+#pragma once
+
+#if defined(AARCH64)
+#  include <arm_neon.h>
+#endif
+
+#define BYTES_IN_NEON  (16)
+#define QWORDS_IN_NEON (BYTES_IN_NEON / sizeof(uint64_t))
+#define DWORDS_IN_NEON (BYTES_IN_NEON / sizeof(uint32_t))
+#define WORDS_IN_NEON  (BYTES_IN_NEON / sizeof(uint16_t))
+
+// The generic macros that gf2x_mul_neon.c shares with
+// gf2x_mul_avx2.c and gf2x_mul_avx512.c (see x86_64_intrinsic.h).
+#if defined(NEON_INTERNAL)
+
+#  define REG_T uint64x2_t
+
+#  define LOAD(mem)       vld1q_u64((const uint64_t *)(mem))
+#  define STORE(mem, reg) vst1q_u64((uint64_t *)(mem), (reg))
+
+#  define SLLI_I64(a, imm) vshlq_n_u64(a, imm)
+#  define SRLI_I64(a, imm) vshrq_n_u64(a, imm)
+
+// NOLINT is used to avoid the sizeof(T)/sizeof(T) warning
+#  define REG_QWORDS (sizeof(REG_T) / sizeof(uint64_t)) // NOLINT
+
+#  define SET1_I64(a)   vdupq_n_u64(a)
+#  define SET_ZERO      vdupq_n_u64(0)
+#  define ADD_I64(a, b) vaddq_u64(a, b)
+
+// Shift every qword of a by the (signed) count in the qwords of cnt,
+// to the left if the count is positive and to the right otherwise.
+// Shifts by 64 or more give zero.
+#  define SHLV_I64(a, cnt) vshlq_u64(a, cnt)
+
+#  define CMPEQ_I64(a, b)   vceqq_u64(a, b)
+#  define BLEND(mask, a, b) vbslq_u64(mask, a, b)
+
+#endif
@@ -109,9 +109,8 @@
 #define SEED_BYTES (256 / 8)
 
 //////////////////////////////////
-// Parameters for the BGF decoder.
+// Parameters for the decoders.
 //////////////////////////////////
-#define BGF_DECODER
 #define DELTA  3
 #define SLICES (LOG2_MSB(D) + 1)
 
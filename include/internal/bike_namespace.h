@@ -0,0 +1,191 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ */
+
+// MULTI_LEVEL builds link the instances of all the levels and variants into
+// one library (see cmake/multi-level.cmake). Every instance is compiled with
+// its own BIKE_PREFIX (e.g., bike_l1_ or bike_l3_aes_), and its global
+// symbols are renamed here to carry the prefix. Therefore, every global
+// symbol of the instances must be listed below. The symbols of the code that
+// does not depend on the level and the variant, and is linked once (e.g.,
+// cpu_features.c, isa_policy.c, and fips202.c), are not renamed.
+
+#pragma once
+
+#define BIKE_NAMESPACE_CAT_(a, b) a##b
+#define BIKE_NAMESPACE_CAT(a, b)  BIKE_NAMESPACE_CAT_(a, b)
+#define BIKE_NAMESPACE(name)      BIKE_NAMESPACE_CAT(BIKE_PREFIX, name)
+
+// kem.c
+#define crypto_kem_keypair BIKE_NAMESPACE(crypto_kem_keypair)
+#define crypto_kem_enc     BIKE_NAMESPACE(crypto_kem_enc)
+#define crypto_kem_dec     BIKE_NAMESPACE(crypto_kem_dec)
+#define kem_instance       BIKE_NAMESPACE(kem_instance)
+
+// common
+#define dispatch_resolve      BIKE_NAMESPACE(dispatch_resolve)
+#define gf2x_ctx_resolved     BIKE_NAMESPACE(gf2x_ctx_resolved)
+#define decode_ctx_resolved   BIKE_NAMESPACE(decode_ctx_resolved)
+#define sampling_ctx_resolved BIKE_NAMESPACE(sampling_ctx_resolved)
+#define r_bits_vector_weight  BIKE_NAMESPACE(r_bits_vector_weight)
+#define print_LE              BIKE_NAMESPACE(print_LE)
+#define print_BE              BIKE_NAMESPACE(print_BE)
+
+// decode (a function-like macro, so the decode member of bike_isa_policy_t
+// keeps its name)
+#define decode(...)         BIKE_NAMESPACE(decode)(__VA_ARGS__)
+#define compute_syndrome    BIKE_NAMESPACE(compute_syndrome)
+#define decode_multi        BIKE_NAMESPACE(decode_multi)
+#define decode_plan_init    BIKE_NAMESPACE(decode_plan_init)
+#define decode_with_ctx     BIKE_NAMESPACE(decode_with_ctx)
+#define decode_with_plan    BIKE_NAMESPACE(decode_with_plan)
+#define decoders            BIKE_NAMESPACE(decoders)
+#define upc_bit_slice       BIKE_NAMESPACE(upc_bit_slice)
+#define upc_bit_slice_tiled BIKE_NAMESPACE(upc_bit_slice_tiled)
+#define upc_joint_tiled     BIKE_NAMESPACE(upc_joint_tiled)
+
+#define bit_slice_add_const_port    BIKE_NAMESPACE(bit_slice_add_const_port)
+#define bit_slice_full_subtract_port \
+  BIKE_NAMESPACE(bit_slice_full_subtract_port)
+#define bit_sliced_adder_port       BIKE_NAMESPACE(bit_sliced_adder_port)
+#define bit_sliced_adder_tiled_port BIKE_NAMESPACE(bit_sliced_adder_tiled_port)
+#define dup_port                    BIKE_NAMESPACE(dup_port)
+#define rotate_plan_port            BIKE_NAMESPACE(rotate_plan_port)
+#define rotate_right_plan_port      BIKE_NAMESPACE(rotate_right_plan_port)
+#define rotate_right_port           BIKE_NAMESPACE(rotate_right_port)
+#define upc_bytes_port              BIKE_NAMESPACE(upc_bytes_port)
+
+#define bit_slice_add_const_avx2    BIKE_NAMESPACE(bit_slice_add_const_avx2)
+#define bit_slice_full_subtract_avx2 \
+  BIKE_NAMESPACE(bit_slice_full_subtract_avx2)
+#define bit_sliced_adder_avx2       BIKE_NAMESPACE(bit_sliced_adder_avx2)
+#define bit_sliced_adder_tiled_avx2 BIKE_NAMESPACE(bit_sliced_adder_tiled_avx2)
+#define dup_avx2                    BIKE_NAMESPACE(dup_avx2)
+#define rotate_plan_avx2            BIKE_NAMESPACE(rotate_plan_avx2)
+#define rotate_right_avx2           BIKE_NAMESPACE(rotate_right_avx2)
+#define rotate_right_plan_avx2      BIKE_NAMESPACE(rotate_right_plan_avx2)
+
+#define bit_slice_add_const_avx512 BIKE_NAMESPACE(bit_slice_add_const_avx512)
+#define bit_slice_full_subtract_avx512 \
+  BIKE_NAMESPACE(bit_slice_full_subtract_avx512)
+#define bit_sliced_adder_avx512 BIKE_NAMESPACE(bit_sliced_adder_avx512)
+#define bit_sliced_adder_tiled_avx512 \
+  BIKE_NAMESPACE(bit_sliced_adder_tiled_avx512)
+#define dup_avx512               BIKE_NAMESPACE(dup_avx512)
+#define rotate_plan_avx512       BIKE_NAMESPACE(rotate_plan_avx512)
+#define rotate_right_avx512      BIKE_NAMESPACE(rotate_right_avx512)
+#define rotate_right_plan_avx512 BIKE_NAMESPACE(rotate_right_plan_avx512)
+#define upc_bytes_avx512         BIKE_NAMESPACE(upc_bytes_avx512)
+
+#define rotate_right_plan_vbmi2 BIKE_NAMESPACE(rotate_right_plan_vbmi2)
+#define rotate_right_vbmi2      BIKE_NAMESPACE(rotate_right_vbmi2)
+
+#define bit_slice_add_const_neon    BIKE_NAMESPACE(bit_slice_add_const_neon)
+#define bit_slice_full_subtract_neon \
+  BIKE_NAMESPACE(bit_slice_full_subtract_neon)
+#define bit_sliced_adder_neon       BIKE_NAMESPACE(bit_sliced_adder_neon)
+#define bit_sliced_adder_tiled_neon BIKE_NAMESPACE(bit_sliced_adder_tiled_neon)
+#define dup_neon                    BIKE_NAMESPACE(dup_neon)
+#define rotate_right_neon           BIKE_NAMESPACE(rotate_right_neon)
+#define rotate_right_plan_neon      BIKE_NAMESPACE(rotate_right_plan_neon)
+
+// gf2x
+#define gf2x_mod_mul               BIKE_NAMESPACE(gf2x_mod_mul)
+#define gf2x_mod_mul_acc           BIKE_NAMESPACE(gf2x_mod_mul_acc)
+#define gf2x_mod_mul_prepared      BIKE_NAMESPACE(gf2x_mod_mul_prepared)
+#define gf2x_mod_mul_prepared_acc  BIKE_NAMESPACE(gf2x_mod_mul_prepared_acc)
+#define gf2x_mod_mul_prepared_x2   BIKE_NAMESPACE(gf2x_mod_mul_prepared_x2)
+#define gf2x_mod_mul_with_ctx      BIKE_NAMESPACE(gf2x_mod_mul_with_ctx)
+#define gf2x_mod_mul_x2            BIKE_NAMESPACE(gf2x_mod_mul_x2)
+#define gf2x_mod_mul_x4            BIKE_NAMESPACE(gf2x_mod_mul_x4)
+#define gf2x_prepare               BIKE_NAMESPACE(gf2x_prepare)
+#define gf2x_inv_schedule_params   BIKE_NAMESPACE(gf2x_inv_schedule_params)
+#define gf2x_mod_inv               BIKE_NAMESPACE(gf2x_mod_inv)
+#define bike_set_tune_profile      BIKE_NAMESPACE(bike_set_tune_profile)
+#define bike_tune                  BIKE_NAMESPACE(bike_tune)
+#define gf2x_tune_profile          BIKE_NAMESPACE(gf2x_tune_profile)
+
+#define gf2x_red_port         BIKE_NAMESPACE(gf2x_red_port)
+#define karatzuba_add1_port   BIKE_NAMESPACE(karatzuba_add1_port)
+#define karatzuba_add2_port   BIKE_NAMESPACE(karatzuba_add2_port)
+#define karatzuba_add3_port   BIKE_NAMESPACE(karatzuba_add3_port)
+#define karatzuba_red_port    BIKE_NAMESPACE(karatzuba_red_port)
+#define gf2x_mul_base_port    BIKE_NAMESPACE(gf2x_mul_base_port)
+#define gf2x_mul_base_x2_port BIKE_NAMESPACE(gf2x_mul_base_x2_port)
+#define gf2x_sqr_port         BIKE_NAMESPACE(gf2x_sqr_port)
+#define gf2x_sqr_red_k_port   BIKE_NAMESPACE(gf2x_sqr_red_k_port)
+#define gf2x_sqr_red_port     BIKE_NAMESPACE(gf2x_sqr_red_port)
+#define k_sqr_map_init        BIKE_NAMESPACE(k_sqr_map_init)
+#define k_sqr_map_port        BIKE_NAMESPACE(k_sqr_map_port)
+#define k_sqr_port            BIKE_NAMESPACE(k_sqr_port)
+
+#define gf2x_red_avx2           BIKE_NAMESPACE(gf2x_red_avx2)
+#define karatzuba_add1_avx2     BIKE_NAMESPACE(karatzuba_add1_avx2)
+#define karatzuba_add2_avx2     BIKE_NAMESPACE(karatzuba_add2_avx2)
+#define karatzuba_add3_avx2     BIKE_NAMESPACE(karatzuba_add3_avx2)
+#define karatzuba_red_avx2      BIKE_NAMESPACE(karatzuba_red_avx2)
+#define gf2x_mul_base_pclmul    BIKE_NAMESPACE(gf2x_mul_base_pclmul)
+#define gf2x_mul_base_x2_pclmul BIKE_NAMESPACE(gf2x_mul_base_x2_pclmul)
+#define gf2x_sqr_pclmul         BIKE_NAMESPACE(gf2x_sqr_pclmul)
+#define gf2x_sqr_red_k_pclmul   BIKE_NAMESPACE(gf2x_sqr_red_k_pclmul)
+#define gf2x_sqr_red_pclmul     BIKE_NAMESPACE(gf2x_sqr_red_pclmul)
+#define k_sqr_avx2              BIKE_NAMESPACE(k_sqr_avx2)
+#define k_sqr_map_avx2          BIKE_NAMESPACE(k_sqr_map_avx2)
+
+#define gf2x_red_avx512          BIKE_NAMESPACE(gf2x_red_avx512)
+#define karatzuba_add1_avx512    BIKE_NAMESPACE(karatzuba_add1_avx512)
+#define karatzuba_add2_avx512    BIKE_NAMESPACE(karatzuba_add2_avx512)
+#define karatzuba_add3_avx512    BIKE_NAMESPACE(karatzuba_add3_avx512)
+#define karatzuba_red_avx512     BIKE_NAMESPACE(karatzuba_red_avx512)
+#define gf2x_mul_base_vpclmul    BIKE_NAMESPACE(gf2x_mul_base_vpclmul)
+#define gf2x_mul_base_x2_vpclmul BIKE_NAMESPACE(gf2x_mul_base_x2_vpclmul)
+#define gf2x_sqr_red_k_vpclmul   BIKE_NAMESPACE(gf2x_sqr_red_k_vpclmul)
+#define gf2x_sqr_red_vpclmul     BIKE_NAMESPACE(gf2x_sqr_red_vpclmul)
+#define gf2x_sqr_vpclmul         BIKE_NAMESPACE(gf2x_sqr_vpclmul)
+#define k_sqr_avx512             BIKE_NAMESPACE(k_sqr_avx512)
+#define k_sqr_map_avx512         BIKE_NAMESPACE(k_sqr_map_avx512)
+#define k_sqr_map_vbmi           BIKE_NAMESPACE(k_sqr_map_vbmi)
+#define k_sqr_vbmi               BIKE_NAMESPACE(k_sqr_vbmi)
+#define gf2x_red_vbmi2           BIKE_NAMESPACE(gf2x_red_vbmi2)
+#define karatzuba_red_vbmi2      BIKE_NAMESPACE(karatzuba_red_vbmi2)
+
+#define gf2x_mul_base_vpclmul_avx2 BIKE_NAMESPACE(gf2x_mul_base_vpclmul_avx2)
+#define gf2x_mul_base_x2_vpclmul_avx2 \
+  BIKE_NAMESPACE(gf2x_mul_base_x2_vpclmul_avx2)
+#define gf2x_sqr_vpclmul_avx2 BIKE_NAMESPACE(gf2x_sqr_vpclmul_avx2)
+
+#define gf2x_red_neon          BIKE_NAMESPACE(gf2x_red_neon)
+#define karatzuba_red_neon     BIKE_NAMESPACE(karatzuba_red_neon)
+#define gf2x_mul_base_pmull    BIKE_NAMESPACE(gf2x_mul_base_pmull)
+#define gf2x_mul_base_x2_pmull BIKE_NAMESPACE(gf2x_mul_base_x2_pmull)
+#define gf2x_sqr_pmull         BIKE_NAMESPACE(gf2x_sqr_pmull)
+#define gf2x_sqr_red_k_pmull   BIKE_NAMESPACE(gf2x_sqr_red_k_pmull)
+#define gf2x_sqr_red_pmull     BIKE_NAMESPACE(gf2x_sqr_red_pmull)
+#define k_sqr_neon             BIKE_NAMESPACE(k_sqr_neon)
+#define k_sqr_map_neon         BIKE_NAMESPACE(k_sqr_map_neon)
+
+// random
+#define generate_error_vector BIKE_NAMESPACE(generate_error_vector)
+#define generate_secret_key   BIKE_NAMESPACE(generate_secret_key)
+#define generate_indices_mod_z BIKE_NAMESPACE(generate_indices_mod_z)
+#define get_seeds             BIKE_NAMESPACE(get_seeds)
+#define sample_indices_fisher_yates \
+  BIKE_NAMESPACE(sample_indices_fisher_yates)
+#define sample_uniform_r_bits_with_fixed_prf_context \
+  BIKE_NAMESPACE(sample_uniform_r_bits_with_fixed_prf_context)
+#define secure_set_bits_port   BIKE_NAMESPACE(secure_set_bits_port)
+#define secure_set_bits_avx2   BIKE_NAMESPACE(secure_set_bits_avx2)
+#define secure_set_bits_avx512 BIKE_NAMESPACE(secure_set_bits_avx512)
+#define secure_set_bits_neon   BIKE_NAMESPACE(secure_set_bits_neon)
+#define sample_error_vec_indices_port \
+  BIKE_NAMESPACE(sample_error_vec_indices_port)
+#define sample_error_vec_indices_avx2 \
+  BIKE_NAMESPACE(sample_error_vec_indices_avx2)
+#define sample_error_vec_indices_avx512 \
+  BIKE_NAMESPACE(sample_error_vec_indices_avx512)
+#define init_prf_state         BIKE_NAMESPACE(init_prf_state)
+#define get_prf_output         BIKE_NAMESPACE(get_prf_output)
+#define clean_prf_state        BIKE_NAMESPACE(clean_prf_state)
@@ -49,6 +49,8 @@ CLEANUP_FUNC(r, r_t)
 CLEANUP_FUNC(m, m_t)
 CLEANUP_FUNC(e, e_t)
 CLEANUP_FUNC(sk, sk_t)
+CLEANUP_FUNC(decode_plan, decode_plan_t)
+CLEANUP_FUNC(rotate_plan, rotate_plan_t)
 CLEANUP_FUNC(ss, ss_t)
 CLEANUP_FUNC(ct, ct_t)
 CLEANUP_FUNC(pad_r, pad_r_t)
@@ -56,8 +58,13 @@ CLEANUP_FUNC(pad_e, pad_e_t)
 CLEANUP_FUNC(seed, seed_t)
 CLEANUP_FUNC(syndrome, syndrome_t)
 CLEANUP_FUNC(upc, upc_t)
+CLEANUP_FUNC(upc_batch, upc_batch_t)
+CLEANUP_FUNC(upc_joint, upc_joint_t)
+CLEANUP_FUNC(upc_joint_batch, upc_joint_batch_t)
+CLEANUP_FUNC(ttl, ttl_t)
 CLEANUP_FUNC(func_k, func_k_t)
 CLEANUP_FUNC(dbl_pad_r, dbl_pad_r_t)
+CLEANUP_FUNC(gf2x_prepared, gf2x_prepared_t)
 
 #if defined(BIND_PK_AND_M)
   CLEANUP_FUNC(pk_m_bind, pk_m_bind_t)
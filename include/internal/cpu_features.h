@@ -7,11 +7,61 @@
 
 #pragma once
 
+#include "bike_isa.h"
+#include "defs.h"
 #include <stdint.h>
 
+// Detect the features of the CPU and resolve the methods of the gf2x, decode
+// and sampling contexts for them (see dispatch_resolve). This is done when the
+// library is loaded, so the callers do not have to call it, and calling it
+// again only repeats the detection. It must not run concurrently with the
+// other functions of the library.
 void cpu_features_init(void);
 
+// Resolve the methods of the contexts for the detected features and every cap
+// of the ISA policy, called by cpu_features_init.
+void dispatch_resolve(void);
+
+// The current ISA policy, used by the *_ctx_resolved functions. The first
+// call reads it from BIKE_ISA_POLICY, unless bike_set_isa_policy was called
+// before.
+void isa_policy(OUT bike_isa_policy_t *policy);
+
+// Returns 1 if the cap allows the kernels of the tier isa
+_INLINE_ uint32_t isa_allowed(IN const uint32_t cap, IN const uint32_t isa)
+{
+  if(isa == BIKE_ISA_NEON) {
+    return cap != BIKE_ISA_PORTABLE;
+  }
+
+  return (cap == BIKE_ISA_AUTO) || (cap >= isa);
+}
+
+#if defined(BIKE_TARGET_ISA)
+// Only the kernels of the target ISA are built, and the features are fixed at
+// compile time, so the *_ctx_resolve functions bind the methods statically.
+#  define is_avx2_enabled()    (BIKE_TARGET_ISA == BIKE_ISA_AVX2)
+#  define is_avx512_enabled()  (BIKE_TARGET_ISA == BIKE_ISA_AVX512)
+#  define is_pclmul_enabled()  (BIKE_TARGET_ISA == BIKE_ISA_AVX2)
+#  define is_vpclmul_enabled() (BIKE_TARGET_ISA == BIKE_ISA_AVX512)
+#  define is_vbmi_enabled()    (BIKE_TARGET_ISA == BIKE_ISA_AVX512)
+#  define is_vbmi2_enabled()   (BIKE_TARGET_ISA == BIKE_ISA_AVX512)
+#  define is_bitalg_enabled()  (BIKE_TARGET_ISA == BIKE_ISA_AVX512)
+#  define is_neon_enabled()    (BIKE_TARGET_ISA == BIKE_ISA_NEON)
+#  define is_pmull_enabled()   (BIKE_TARGET_ISA == BIKE_ISA_NEON)
+#else
 uint32_t is_avx2_enabled(void);
 uint32_t is_avx512_enabled(void);
 uint32_t is_pclmul_enabled(void);
 uint32_t is_vpclmul_enabled(void);
+uint32_t is_vbmi_enabled(void);
+uint32_t is_vbmi2_enabled(void);
+uint32_t is_bitalg_enabled(void);
+uint32_t is_neon_enabled(void);
+uint32_t is_pmull_enabled(void);
+#endif
+
+// The family, model, and stepping of the CPU (CPUID leaf 1, EAX) on x86,
+// the main ID register (MIDR_EL1) on AArch64 Linux, and 0 otherwise.
+// Used as the key of the tuning profiles.
+uint32_t cpu_signature(void);
@@ -9,4 +9,35 @@
 
 #include "types.h"
 
+// Decode with the decoder that the library was built with (the DECODER build
+// option, BGF by default), see decode_ctx_set_decoder.
 void decode(OUT e_t *e, IN const ct_t *ct, IN const sk_t *sk);
+
+// Compute the decode plan of the secret key: the rotations of the syndrome by
+// all the indices of sk->wlist, as needed by the rotate functions that the
+// decoder uses on this CPU. decode computes the plan once per call, so it
+// can instead be computed once when the key is generated or loaded.
+// The plan must be cleaned like the secret key.
+void decode_plan_init(OUT decode_plan_t *plan, IN const sk_t *sk);
+
+// The same as decode, with the decode plan of sk. The plan is recomputed if
+// it is NULL or if it was computed for other rotate functions (e.g. on a CPU
+// with different features).
+void decode_with_plan(OUT e_t *e,
+                      IN const ct_t *ct,
+                      IN const sk_t *sk,
+                      IN const decode_plan_t *plan);
+
+// Decode the n ciphertexts ct[0..n-1] under the same secret key into
+// e[0..n-1], with the same result as calling decode for every ciphertext.
+// The ciphertexts are decoded in lock-step, in groups of up to
+// DECODE_MULTI_MAX, so every rotation offset of the secret key is processed
+// once per group and the bit-sliced adders run over the counters of
+// the whole group.
+// The working memory of the groups (about 2 MB at Level 5) is allocated on
+// the heap. If the allocation fails, the ciphertexts are decoded one at
+// a time.
+void decode_multi(OUT e_t *e,
+                  IN const ct_t *ct,
+                  IN size_t      n,
+                  IN const sk_t *sk);
@@ -11,6 +11,51 @@
 #include "defs.h"
 #include "types.h"
 
+struct decode_ctx_st;
+
+// The UPC engines compute the Unsatisfied Parity Checks (UPC) counters of the
+// columns of one half of the secret key (given by wlist), and set the bits of
+// ge_thr where the counter is at least threshold, and the bits of
+// ge_thr_delta (if it is not NULL) where the counter is at least
+// (threshold - DELTA).
+//   - upc_bit_slice counts with the bit-sliced adders of the decode context.
+//   - upc_bit_slice_tiled adds batches of UPC_BATCH rotated syndromes to the
+//     bit-sliced counters one column (register) at a time, so every counter
+//     is loaded and stored once per batch instead of once per rotation.
+//   - upc_bytes_* expand every rotated syndrome to a vector of byte counters.
+// All use ctx->rotate_right for the (constant-time) rotations, or the rotation
+// plans of the indices of wlist (rot), when rot is not NULL.
+void upc_bit_slice(OUT pad_r_t *ge_thr,
+                   OUT pad_r_t *ge_thr_delta,
+                   IN const syndrome_t *syndrome,
+                   IN const compressed_idx_d_t *wlist,
+                   IN const rotate_plan_t *rot,
+                   IN uint8_t              threshold,
+                   IN const struct decode_ctx_st *ctx);
+void upc_bit_slice_tiled(OUT pad_r_t *ge_thr,
+                         OUT pad_r_t *ge_thr_delta,
+                         IN const syndrome_t *syndrome,
+                         IN const compressed_idx_d_t *wlist,
+                         IN const rotate_plan_t *rot,
+                         IN uint8_t              threshold,
+                         IN const struct decode_ctx_st *ctx);
+// upc_joint_tiled is the same as upc_bit_slice_tiled for the two halves of
+// the secret key together (wlist holds N0 lists), see upc_joint_t.
+void upc_joint_tiled(OUT pad_e_t *ge_thr,
+                     OUT pad_e_t *ge_thr_delta,
+                     IN const syndrome_t *syndrome,
+                     IN const compressed_idx_d_t *wlist,
+                     IN const rotate_plan_t *rot,
+                     IN uint8_t              threshold,
+                     IN const struct decode_ctx_st *ctx);
+void upc_bytes_port(OUT pad_r_t *ge_thr,
+                    OUT pad_r_t *ge_thr_delta,
+                    IN const syndrome_t *syndrome,
+                    IN const compressed_idx_d_t *wlist,
+                    IN const rotate_plan_t *rot,
+                    IN uint8_t              threshold,
+                    IN const struct decode_ctx_st *ctx);
+
 // Rotate right the first R_BITS of a syndrome.
 // At input, the syndrome is stored as three R_BITS triplicate.
 // (this makes rotation easier to implement)
@@ -19,11 +64,29 @@
 void rotate_right_port(OUT syndrome_t *out,
                        IN const syndrome_t *in,
                        IN uint32_t          bitscount);
+
+// The rotate functions are split into the computation of the rotation plan
+// (the blend masks of the barrel shifter and the remaining small shift),
+// and the rotation by a given plan. The plans of a secret key can therefore
+// be computed once, see decode_plan_t.
+void rotate_plan_port(OUT rotate_plan_t *p, IN uint32_t bitscount);
+void rotate_right_plan_port(OUT syndrome_t *out,
+                            IN const syndrome_t *in,
+                            IN const rotate_plan_t *p);
 void dup_port(IN OUT syndrome_t *s);
 void bit_sliced_adder_port(OUT upc_t *upc,
                            IN OUT syndrome_t *rotated_syndrome,
                            IN const size_t    num_of_slices);
-void bit_slice_full_subtract_port(OUT upc_t *upc, IN uint8_t val);
+void bit_slice_full_subtract_port(OUT uint64_t *upc,
+                                  IN uint8_t val,
+                                  IN size_t  qwords_len);
+void bit_slice_add_const_port(OUT uint64_t *upc,
+                              IN uint8_t val,
+                              IN size_t  qwords_len);
+void bit_sliced_adder_tiled_port(OUT uint64_t *upc,
+                                 IN const uint64_t *rotated,
+                                 IN size_t          count,
+                                 IN size_t          qwords_len);
 
 #if defined(X86_64)
 void rotate_right_avx2(OUT syndrome_t *out,
@@ -32,6 +95,22 @@ void rotate_right_avx2(OUT syndrome_t *out,
 void rotate_right_avx512(OUT syndrome_t *out,
                          IN const syndrome_t *in,
                          IN uint32_t          bitscount);
+// Requires AVX512-VBMI2
+void rotate_right_vbmi2(OUT syndrome_t *out,
+                        IN const syndrome_t *in,
+                        IN uint32_t          bitscount);
+void rotate_plan_avx2(OUT rotate_plan_t *p, IN uint32_t bitscount);
+void rotate_plan_avx512(OUT rotate_plan_t *p, IN uint32_t bitscount);
+void rotate_right_plan_avx2(OUT syndrome_t *out,
+                            IN const syndrome_t *in,
+                            IN const rotate_plan_t *p);
+void rotate_right_plan_avx512(OUT syndrome_t *out,
+                              IN const syndrome_t *in,
+                              IN const rotate_plan_t *p);
+// Requires AVX512-VBMI2, uses the plans of rotate_plan_avx512
+void rotate_right_plan_vbmi2(OUT syndrome_t *out,
+                             IN const syndrome_t *in,
+                             IN const rotate_plan_t *p);
 void dup_avx2(IN OUT syndrome_t *s);
 void dup_avx512(IN OUT syndrome_t *s);
 
@@ -42,41 +121,315 @@ void bit_sliced_adder_avx512(OUT upc_t *upc,
                              IN OUT syndrome_t *rotated_syndrome,
                              IN const size_t    num_of_slices);
 
-void bit_slice_full_subtract_avx2(OUT upc_t *upc, IN uint8_t val);
-void bit_slice_full_subtract_avx512(OUT upc_t *upc, IN uint8_t val);
+void bit_slice_full_subtract_avx2(OUT uint64_t *upc,
+                                  IN uint8_t val,
+                                  IN size_t  qwords_len);
+void bit_slice_full_subtract_avx512(OUT uint64_t *upc,
+                                    IN uint8_t val,
+                                    IN size_t  qwords_len);
+
+void bit_slice_add_const_avx2(OUT uint64_t *upc,
+                              IN uint8_t val,
+                              IN size_t  qwords_len);
+void bit_slice_add_const_avx512(OUT uint64_t *upc,
+                                IN uint8_t val,
+                                IN size_t  qwords_len);
+
+void bit_sliced_adder_tiled_avx2(OUT uint64_t *upc,
+                                 IN const uint64_t *rotated,
+                                 IN size_t          count,
+                                 IN size_t          qwords_len);
+void bit_sliced_adder_tiled_avx512(OUT uint64_t *upc,
+                                   IN const uint64_t *rotated,
+                                   IN size_t          count,
+                                   IN size_t          qwords_len);
+
+void upc_bytes_avx512(OUT pad_r_t *ge_thr,
+                      OUT pad_r_t *ge_thr_delta,
+                      IN const syndrome_t *syndrome,
+                      IN const compressed_idx_d_t *wlist,
+                      IN const rotate_plan_t *rot,
+                      IN uint8_t              threshold,
+                      IN const struct decode_ctx_st *ctx);
+#endif
+
+#if defined(AARCH64)
+void rotate_right_neon(OUT syndrome_t *out,
+                       IN const syndrome_t *in,
+                       IN uint32_t          bitscount);
+// Uses the plans of rotate_plan_port
+void rotate_right_plan_neon(OUT syndrome_t *out,
+                            IN const syndrome_t *in,
+                            IN const rotate_plan_t *p);
+void dup_neon(IN OUT syndrome_t *s);
+void bit_sliced_adder_neon(OUT upc_t *upc,
+                           IN OUT syndrome_t *rotated_syndrome,
+                           IN const size_t    num_of_slices);
+void bit_slice_full_subtract_neon(OUT uint64_t *upc,
+                                  IN uint8_t val,
+                                  IN size_t  qwords_len);
+void bit_slice_add_const_neon(OUT uint64_t *upc,
+                              IN uint8_t val,
+                              IN size_t  qwords_len);
+void bit_sliced_adder_tiled_neon(OUT uint64_t *upc,
+                                 IN const uint64_t *rotated,
+                                 IN size_t          count,
+                                 IN size_t          qwords_len);
+#endif
+
+// The decoders that can be set by decode_ctx_set_decoder
+#define DECODER_BGF      (0)
+#define DECODER_BG       (1)
+#define DECODER_BACKFLIP (2)
+#define DECODER_NUM      (3)
+
+// The decoder of decode, it can be set with the DECODER build option
+#if !defined(DECODER_DEFAULT)
+#  define DECODER_DEFAULT DECODER_BGF
 #endif
 
+// The iterations and thresholds schedule of a decoder. Every iteration flips
+// the positions whose UPC is at least the threshold of the syndrome weight
+// (see get_threshold), and then:
+//   - the first bg_it iterations flip the black and the gray positions
+//     again if their UPC is at least bg_threshold (see find_err2);
+//   - if ttl_short is not zero, the flips of the other iterations expire
+//     (are flipped back) after ttl_long iterations if their UPC was at least
+//     the threshold plus DELTA, and after ttl_short iterations otherwise,
+//     unless they are flipped again before or the syndrome is zero
+//     (Backflip). Both are at most 3, and a zero ttl_long never expires.
+typedef struct decoder_s {
+  const char *name;
+  uint32_t    max_it;
+  uint32_t    bg_it;
+  uint8_t     bg_threshold;
+  uint8_t     ttl_short;
+  uint8_t     ttl_long;
+} decoder_t;
+
+// The registry of the decoders, indexed by their ids (DECODER_*)
+extern const decoder_t decoders[DECODER_NUM];
+
+// The maximal number of iterations of the decoders of the registry
+#define DECODER_MAX_IT (5)
+
+// The weights of the syndrome at the start of every iteration of a decoding,
+// and after the last iteration (weight[decoder->max_it]). The weights depend
+// on the secret key and on the errors vector, so they are recorded only for
+// the analysis of the decoders (e.g., by bike-dfr) when the trace of the
+// context is set.
+typedef struct decode_trace_s {
+  uint32_t weight[DECODER_MAX_IT + 1];
+} decode_trace_t;
+
 // Decode methods struct
 typedef struct decode_ctx_st {
   void (*rotate_right)(OUT syndrome_t *out,
                        IN const syndrome_t *in,
                        IN uint32_t          bitscount);
+  void (*rotate_plan)(OUT rotate_plan_t *p, IN uint32_t bitscount);
+  void (*rotate_right_plan)(OUT syndrome_t *out,
+                            IN const syndrome_t *in,
+                            IN const rotate_plan_t *p);
+  // The block size (in bits) of the plans of rotate_plan
+  uint32_t rotate_block_bits;
   void (*dup)(IN OUT syndrome_t *s);
   void (*bit_sliced_adder)(OUT upc_t *upc,
                            IN OUT syndrome_t *rotated_syndrom,
                            IN const size_t    num_of_slices);
-  void (*bit_slice_full_subtract)(OUT upc_t *upc, IN uint8_t val);
+  void (*bit_slice_full_subtract)(OUT uint64_t *upc,
+                                  IN uint8_t val,
+                                  IN size_t  qwords_len);
+  void (*bit_slice_add_const)(OUT uint64_t *upc,
+                              IN uint8_t val,
+                              IN size_t  qwords_len);
+  void (*bit_sliced_adder_tiled)(OUT uint64_t *upc,
+                                 IN const uint64_t *rotated,
+                                 IN size_t          count,
+                                 IN size_t          qwords_len);
+  void (*count_upc)(OUT pad_r_t *ge_thr,
+                    OUT pad_r_t *ge_thr_delta,
+                    IN const syndrome_t *syndrome,
+                    IN const compressed_idx_d_t *wlist,
+                    IN const rotate_plan_t *rot,
+                    IN uint8_t              threshold,
+                    IN const struct decode_ctx_st *ctx);
+  // Counts the UPCs of both halves at once, or NULL when count_upc is used
+  void (*count_upc_joint)(OUT pad_e_t *ge_thr,
+                          OUT pad_e_t *ge_thr_delta,
+                          IN const syndrome_t *syndrome,
+                          IN const compressed_idx_d_t *wlist,
+                          IN const rotate_plan_t *rot,
+                          IN uint8_t              threshold,
+                          IN const struct decode_ctx_st *ctx);
+  const decoder_t *decoder;
+  // NULL, or the trace of the decodings with this context
+  decode_trace_t *trace;
+  // The cap of the ISA policy that the methods follow
+  uint32_t isa_cap;
 } decode_ctx;
 
-_INLINE_ void decode_ctx_init(decode_ctx *ctx)
+// Rotate the syndrome by the index j of wlist. If rot is not NULL, it holds
+// the rotation plans of the indices of wlist, and the plan of j is used.
+_INLINE_ void rotate_right_idx(OUT syndrome_t *out,
+                               IN const syndrome_t *in,
+                               IN const compressed_idx_d_t *wlist,
+                               IN const rotate_plan_t *rot,
+                               IN const size_t         j,
+                               IN const decode_ctx *ctx)
 {
+  if(rot != NULL) {
+    ctx->rotate_right_plan(out, in, &rot[j]);
+  } else {
+    ctx->rotate_right(out, in, wlist->val[j]);
+  }
+}
+
+// The UPC engines that can be set by decode_ctx_set_upc_engine
+#define DECODE_UPC_BIT_SLICE (0)
+#define DECODE_UPC_BYTES     (1)
+#define DECODE_UPC_TILED     (2)
+#define DECODE_UPC_JOINT     (3)
+
+// Set the UPC engine of the context, returns 0 if the engine is unknown.
+// The byte counters are vectorized only with AVX512 (if the ISA policy allows
+// it), elsewhere the portable implementation is used.
+// The joint engine counts the UPCs of both halves in one sweep, so the
+// halves are not run in parallel with it in LATENCY_MODE.
+_INLINE_ uint32_t decode_ctx_set_upc_engine(decode_ctx *ctx, uint32_t engine)
+{
+  ctx->count_upc_joint = NULL;
+
+  switch(engine) {
+    case DECODE_UPC_BIT_SLICE:
+      ctx->count_upc = upc_bit_slice;
+      return 1;
+    case DECODE_UPC_BYTES:
 #if defined(X86_64)
-  if(is_avx512_enabled()) {
+      if(is_avx512_enabled() && isa_allowed(ctx->isa_cap, BIKE_ISA_AVX512)) {
+        ctx->count_upc = upc_bytes_avx512;
+        return 1;
+      }
+#endif
+      ctx->count_upc = upc_bytes_port;
+      return 1;
+    case DECODE_UPC_TILED:
+      ctx->count_upc = upc_bit_slice_tiled;
+      return 1;
+    case DECODE_UPC_JOINT:
+      // count_upc is still used by the callers that process a single half
+      ctx->count_upc       = upc_bit_slice_tiled;
+      ctx->count_upc_joint = upc_joint_tiled;
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+// Set the decoder of the context, returns 0 if the decoder is unknown.
+_INLINE_ uint32_t decode_ctx_set_decoder(decode_ctx *ctx, uint32_t decoder)
+{
+  if(decoder >= DECODER_NUM) {
+    return 0;
+  }
+
+  ctx->decoder = &decoders[decoder];
+  return 1;
+}
+
+// Set the methods that are the fastest for the features of the CPU, among
+// the tiers that cap allows, and the default UPC engine and decoder.
+// This is done once by cpu_features_init, see decode_ctx_init.
+_INLINE_ void decode_ctx_resolve(decode_ctx *ctx, IN const uint32_t cap)
+{
+  ctx->isa_cap = cap;
+
+#if defined(X86_64)
+  if(is_avx512_enabled() && isa_allowed(cap, BIKE_ISA_AVX512)) {
     ctx->rotate_right            = rotate_right_avx512;
+    ctx->rotate_plan             = rotate_plan_avx512;
+    ctx->rotate_right_plan       = rotate_right_plan_avx512;
+    ctx->rotate_block_bits       = BITS_IN_ZMM;
     ctx->dup                     = dup_avx512;
     ctx->bit_sliced_adder        = bit_sliced_adder_avx512;
     ctx->bit_slice_full_subtract = bit_slice_full_subtract_avx512;
-  } else if(is_avx2_enabled()) {
+    ctx->bit_slice_add_const     = bit_slice_add_const_avx512;
+    ctx->bit_sliced_adder_tiled  = bit_sliced_adder_tiled_avx512;
+
+    if(is_vbmi2_enabled()) {
+      ctx->rotate_right      = rotate_right_vbmi2;
+      ctx->rotate_right_plan = rotate_right_plan_vbmi2;
+    }
+  } else if(is_avx2_enabled() && isa_allowed(cap, BIKE_ISA_AVX2)) {
     ctx->rotate_right            = rotate_right_avx2;
+    ctx->rotate_plan             = rotate_plan_avx2;
+    ctx->rotate_right_plan       = rotate_right_plan_avx2;
+    ctx->rotate_block_bits       = BITS_IN_YMM;
     ctx->dup                     = dup_avx2;
     ctx->bit_sliced_adder        = bit_sliced_adder_avx2;
     ctx->bit_slice_full_subtract = bit_slice_full_subtract_avx2;
+    ctx->bit_slice_add_const     = bit_slice_add_const_avx2;
+    ctx->bit_sliced_adder_tiled  = bit_sliced_adder_tiled_avx2;
+  } else
+#elif defined(AARCH64)
+  if(is_neon_enabled() && isa_allowed(cap, BIKE_ISA_NEON)) {
+    ctx->rotate_right            = rotate_right_neon;
+    ctx->rotate_plan             = rotate_plan_port;
+    ctx->rotate_right_plan       = rotate_right_plan_neon;
+    ctx->rotate_block_bits       = 64;
+    ctx->dup                     = dup_neon;
+    ctx->bit_sliced_adder        = bit_sliced_adder_neon;
+    ctx->bit_slice_full_subtract = bit_slice_full_subtract_neon;
+    ctx->bit_slice_add_const     = bit_slice_add_const_neon;
+    ctx->bit_sliced_adder_tiled  = bit_sliced_adder_tiled_neon;
   } else
 #endif
   {
     ctx->rotate_right            = rotate_right_port;
+    ctx->rotate_plan             = rotate_plan_port;
+    ctx->rotate_right_plan       = rotate_right_plan_port;
+    ctx->rotate_block_bits       = 64;
     ctx->dup                     = dup_port;
     ctx->bit_sliced_adder        = bit_sliced_adder_port;
     ctx->bit_slice_full_subtract = bit_slice_full_subtract_port;
+    ctx->bit_slice_add_const     = bit_slice_add_const_port;
+    ctx->bit_sliced_adder_tiled  = bit_sliced_adder_tiled_port;
+  }
+
+  // The tiled counters are faster when the UPC array
+  // does not fit in the L1 cache (Level 3/5).
+#if(LEVEL == 1)
+  decode_ctx_set_upc_engine(ctx, DECODE_UPC_BIT_SLICE);
+#else
+  decode_ctx_set_upc_engine(ctx, DECODE_UPC_TILED);
+#endif
+
+  decode_ctx_set_decoder(ctx, DECODER_DEFAULT);
+  ctx->trace = NULL;
+}
+
+// The methods resolved by cpu_features_init,
+// or NULL while they are being resolved (see dispatch.c).
+const decode_ctx *decode_ctx_resolved(void);
+
+_INLINE_ void decode_ctx_init(decode_ctx *ctx)
+{
+#if defined(BIKE_TARGET_ISA)
+  // The methods are constants that the compiler can propagate to the calls
+  decode_ctx_resolve(ctx, BIKE_ISA_AUTO);
+#else
+  const decode_ctx *resolved = decode_ctx_resolved();
+  if(resolved != NULL) {
+    *ctx = *resolved;
+  } else {
+    decode_ctx_resolve(ctx, BIKE_ISA_AUTO);
   }
+#endif
 }
+
+// Decode with the methods and the decoder of ctx (and record the trace of
+// ctx if it is set), see decode.
+void decode_with_ctx(OUT e_t *e,
+                     IN const ct_t *ct,
+                     IN const sk_t *sk,
+                     IN const decode_ctx *ctx);
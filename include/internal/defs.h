@@ -7,6 +7,11 @@
 
 #pragma once
 
+// The global symbols of the instances of MULTI_LEVEL builds are prefixed
+#if defined(BIKE_PREFIX)
+#  include "bike_namespace.h"
+#endif
+
 ////////////////////////////////////////////
 //             Basic defs
 ///////////////////////////////////////////
@@ -25,5 +25,47 @@ gf2x_mod_add(OUT pad_r_t *c, IN const pad_r_t *a, IN const pad_r_t *b)
 // c = a*b mod (x^r - 1)
 void gf2x_mod_mul(OUT pad_r_t *c, IN const pad_r_t *a, IN const pad_r_t *b);
 
+// c[i] = a[i]*b[i] mod (x^r - 1), for 0 <= i < 2 (resp. 4).
+// The independent products are computed together, which is faster than
+// computing them one after the other. Any c[i] may alias any a[j] or b[j].
+void gf2x_mod_mul_x2(OUT pad_r_t *const c[2],
+                     IN const pad_r_t *const a[2],
+                     IN const pad_r_t *const b[2]);
+void gf2x_mod_mul_x4(OUT pad_r_t *const c[4],
+                     IN const pad_r_t *const a[4],
+                     IN const pad_r_t *const b[4]);
+
+// c = sum_{i < n} a[i]*b[i] mod (x^r - 1).
+// The products are accumulated before the reduction, which is computed
+// only once. c may alias any a[i] or b[i]. c = 0 if n = 0.
+void gf2x_mod_mul_acc(OUT pad_r_t *c,
+                      IN const pad_r_t *const a[],
+                      IN const pad_r_t *const b[],
+                      IN size_t               n);
+
+// Prepare an operand that is multiplied many times: p holds a copy of a
+// and the Karatsuba half-sums of a, which the multiplications below take
+// from p instead of computing them again. p holds secrets if a does.
+void gf2x_prepare(IN const pad_r_t *a, OUT gf2x_prepared_t *p);
+
+// c = a*b mod (x^r - 1), where p was prepared from a.
+// c may alias b (but not p).
+void gf2x_mod_mul_prepared(OUT pad_r_t *c,
+                           IN const gf2x_prepared_t *p,
+                           IN const pad_r_t *b);
+
+// c[i] = a[i]*b[i] mod (x^r - 1), for 0 <= i < 2, where p[i] was prepared
+// from a[i]. The products are computed together as in gf2x_mod_mul_x2.
+void gf2x_mod_mul_prepared_x2(OUT pad_r_t *const c[2],
+                              IN const gf2x_prepared_t *const p[2],
+                              IN const pad_r_t *const b[2]);
+
+// c = sum_{i < n} a[i]*b[i] mod (x^r - 1), where p[i] was prepared from a[i],
+// see gf2x_mod_mul_acc.
+void gf2x_mod_mul_prepared_acc(OUT pad_r_t *c,
+                               IN const gf2x_prepared_t *const p[],
+                               IN const pad_r_t *const b[],
+                               IN size_t               n);
+
 // c = a^-1 mod (x^r - 1)
 void gf2x_mod_inv(OUT pad_r_t *c, IN const pad_r_t *a);
@@ -11,6 +11,7 @@
 #include <stdlib.h>
 
 #include "cpu_features.h"
+#include "gf2x_tune.h"
 #include "types.h"
 
 // The size in quadwords of the operands in the gf2x_mul_base function
@@ -18,12 +19,49 @@
 #define GF2X_PORT_BASE_QWORDS    (1)
 #define GF2X_PCLMUL_BASE_QWORDS  (8)
 #define GF2X_VPCLMUL_BASE_QWORDS (16)
+#define GF2X_PMULL_BASE_QWORDS   (8)
+
+// The size in quadwords of the halves of the operands at the top level
+// of the Karatsuba multiplication (see gf2x_mod_mul_with_ctx).
+#define GF2X_TOP_HALF_QWORDS (R_PADDED_QWORDS / 2)
+#define GF2X_TOP_PAD_QWORDS  (QWORDS_IN_ZMM)
+
+// The maximal number of independent products that are computed together
+// in gf2x_mul.c (see gf2x_mod_mul_x2 and gf2x_mod_mul_x4).
+#define GF2X_MUL_MAX_BATCH (4)
+
+// The permutation map of the k-squaring function for a specific l_param:
+//     idx[i] = (i * l_param) % r, for 0 <= i < r.
+// The maps depend only on public values, so they can be computed once and
+// reused. All the indices are smaller than 2^16 for the BIKE parameters,
+// which keeps the map compact (2 bytes per bit of the polynomial).
+typedef struct k_sqr_map_s {
+  uint16_t idx[R_BITS];
+} ALIGN(ALIGN_BYTES) k_sqr_map_t;
+
+bike_static_assert((R_BITS <= 65536), k_sqr_map_idx_too_small);
+
+void k_sqr_map_init(OUT k_sqr_map_t *map, IN size_t l_param);
+
+// Write the parameters k and l of (up to max) steps of the inversion schedule
+// (see gf2x_inv.c) to k[] and l[], and return the number of steps. has_map[i]
+// is 1 if step i has a precomputed k-squaring map, and 0 if it generates the
+// map on every call (when k is at most GF2X_DEFAULT_K_SQR_THR).
+// Used for tuning the threshold between squaring and k-squaring.
+size_t gf2x_inv_schedule_params(OUT uint32_t *k,
+                                OUT uint32_t *l,
+                                OUT uint8_t *has_map,
+                                IN size_t    max);
 
 // ------------------ FUNCTIONS NEEDED FOR GF2X MULTIPLICATION ------------------
 // GF2X multiplication of a and b of size GF2X_BASE_QWORDS, c = a * b
 void gf2x_mul_base_port(OUT uint64_t *c,
                         IN const uint64_t *a,
                         IN const uint64_t *b);
+// Two independent multiplications, c[i] = a[i] * b[i] for i = 0, 1
+void gf2x_mul_base_x2_port(OUT uint64_t *const c[2],
+                           IN const uint64_t *const a[2],
+                           IN const uint64_t *const b[2]);
 void karatzuba_add1_port(OUT uint64_t *alah,
                          OUT uint64_t *blbh,
                          IN const uint64_t *a,
@@ -36,6 +74,15 @@ void karatzuba_add2_port(OUT uint64_t *z,
 void karatzuba_add3_port(OUT uint64_t *c,
                          IN const uint64_t *mid,
                          IN const size_t    qwords_len);
+// The final step of the top level of Karatsuba multiplication fused with
+// the reduction, c = (hi*x^(2h) + (mid+lo+hi)*x^h + lo) mod (x^r - 1),
+// where h = GF2X_TOP_HALF_QWORDS, and lo, hi, and mid hold 2h qwords each.
+// All three buffers must be surrounded by (at least) GF2X_TOP_PAD_QWORDS
+// qwords of zeros on both sides.
+void karatzuba_red_port(OUT pad_r_t *c,
+                        IN const uint64_t *lo,
+                        IN const uint64_t *hi,
+                        IN const uint64_t *mid);
 
 // -------------------- FUNCTIONS NEEDED FOR GF2X INVERSION --------------------
 // c = a^2
@@ -43,8 +90,19 @@ void gf2x_sqr_port(OUT dbl_pad_r_t *c, IN const pad_r_t *a);
 // The k-squaring function computes c = a^(2^k) % (x^r - 1),
 // It is required by inversion, where l_param is derived from k.
 void k_sqr_port(OUT pad_r_t *c, IN const pad_r_t *a, IN size_t l_param);
+// The same as k_sqr_port, with a precomputed permutation map.
+void k_sqr_map_port(OUT pad_r_t *c,
+                    IN const pad_r_t *a,
+                    IN const k_sqr_map_t *map);
 // c = a mod (x^r - 1)
 void gf2x_red_port(OUT pad_r_t *c, IN const dbl_pad_r_t *a);
+// c = a^2 mod (x^r - 1), the square is reduced while it is computed.
+void gf2x_sqr_red_port(OUT pad_r_t *c, IN const pad_r_t *a);
+// c = a^(2^num_sqrs) mod (x^r - 1) by num_sqrs fused squarings,
+// c and a must not overlap.
+void gf2x_sqr_red_k_port(OUT pad_r_t *c,
+                         IN const pad_r_t *a,
+                         IN size_t         num_sqrs);
 
 // AVX2 and AVX512 versions of the functions
 #if defined(X86_64)
@@ -55,6 +113,21 @@ void gf2x_mul_base_pclmul(OUT uint64_t *c,
 void gf2x_mul_base_vpclmul(OUT uint64_t *c,
                            IN const uint64_t *a,
                            IN const uint64_t *b);
+// VPCLMULQDQ on ymm registers, for CPUs without AVX512.
+// The operands are of size GF2X_VPCLMUL_BASE_QWORDS.
+void gf2x_mul_base_vpclmul_avx2(OUT uint64_t *c,
+                                IN const uint64_t *a,
+                                IN const uint64_t *b);
+
+void gf2x_mul_base_x2_pclmul(OUT uint64_t *const c[2],
+                             IN const uint64_t *const a[2],
+                             IN const uint64_t *const b[2]);
+void gf2x_mul_base_x2_vpclmul(OUT uint64_t *const c[2],
+                              IN const uint64_t *const a[2],
+                              IN const uint64_t *const b[2]);
+void gf2x_mul_base_x2_vpclmul_avx2(OUT uint64_t *const c[2],
+                                   IN const uint64_t *const a[2],
+                                   IN const uint64_t *const b[2]);
 
 void karatzuba_add1_avx2(OUT uint64_t *alah,
                          OUT uint64_t *blbh,
@@ -84,25 +157,97 @@ void karatzuba_add3_avx512(OUT uint64_t *c,
                            IN const uint64_t *mid,
                            IN const size_t    qwords_len);
 
+void karatzuba_red_avx2(OUT pad_r_t *c,
+                        IN const uint64_t *lo,
+                        IN const uint64_t *hi,
+                        IN const uint64_t *mid);
+void karatzuba_red_avx512(OUT pad_r_t *c,
+                          IN const uint64_t *lo,
+                          IN const uint64_t *hi,
+                          IN const uint64_t *mid);
+// Requires AVX512-VBMI2
+void karatzuba_red_vbmi2(OUT pad_r_t *c,
+                         IN const uint64_t *lo,
+                         IN const uint64_t *hi,
+                         IN const uint64_t *mid);
+
 // -------------------- FUNCTIONS NEEDED FOR GF2X INVERSION --------------------
 // c = a^2
 void gf2x_sqr_pclmul(OUT dbl_pad_r_t *c, IN const pad_r_t *a);
 void gf2x_sqr_vpclmul(OUT dbl_pad_r_t *c, IN const pad_r_t *a);
+void gf2x_sqr_vpclmul_avx2(OUT dbl_pad_r_t *c, IN const pad_r_t *a);
 
 // The k-squaring function computes c = a^(2^k) % (x^r - 1),
 // It is required by inversion, where l_param is derived from k.
 void k_sqr_avx2(OUT pad_r_t *c, IN const pad_r_t *a, IN size_t l_param);
 void k_sqr_avx512(OUT pad_r_t *c, IN const pad_r_t *a, IN size_t l_param);
+void k_sqr_map_avx2(OUT pad_r_t *c,
+                    IN const pad_r_t *a,
+                    IN const k_sqr_map_t *map);
+void k_sqr_map_avx512(OUT pad_r_t *c,
+                      IN const pad_r_t *a,
+                      IN const k_sqr_map_t *map);
+
+// k-squaring on the packed representation, requires AVX512-VBMI and BITALG.
+void k_sqr_vbmi(OUT pad_r_t *c, IN const pad_r_t *a, IN size_t l_param);
+void k_sqr_map_vbmi(OUT pad_r_t *c,
+                    IN const pad_r_t *a,
+                    IN const k_sqr_map_t *map);
 
 // c = a mod (x^r - 1)
 void gf2x_red_avx2(OUT pad_r_t *c, IN const dbl_pad_r_t *a);
 void gf2x_red_avx512(OUT pad_r_t *c, IN const dbl_pad_r_t *a);
+void gf2x_red_vbmi2(OUT pad_r_t *c, IN const dbl_pad_r_t *a);
+
+// c = a^2 mod (x^r - 1) and c = a^(2^num_sqrs) mod (x^r - 1)
+void gf2x_sqr_red_pclmul(OUT pad_r_t *c, IN const pad_r_t *a);
+void gf2x_sqr_red_vpclmul(OUT pad_r_t *c, IN const pad_r_t *a);
+void gf2x_sqr_red_k_pclmul(OUT pad_r_t *c,
+                           IN const pad_r_t *a,
+                           IN size_t         num_sqrs);
+void gf2x_sqr_red_k_vpclmul(OUT pad_r_t *c,
+                            IN const pad_r_t *a,
+                            IN size_t         num_sqrs);
+#endif
+
+// NEON and PMULL versions of the functions
+#if defined(AARCH64)
+// ------------------ FUNCTIONS NEEDED FOR GF2X MULTIPLICATION ------------------
+void gf2x_mul_base_pmull(OUT uint64_t *c,
+                         IN const uint64_t *a,
+                         IN const uint64_t *b);
+void gf2x_mul_base_x2_pmull(OUT uint64_t *const c[2],
+                            IN const uint64_t *const a[2],
+                            IN const uint64_t *const b[2]);
+
+void karatzuba_red_neon(OUT pad_r_t *c,
+                        IN const uint64_t *lo,
+                        IN const uint64_t *hi,
+                        IN const uint64_t *mid);
+
+// -------------------- FUNCTIONS NEEDED FOR GF2X INVERSION --------------------
+void gf2x_sqr_pmull(OUT dbl_pad_r_t *c, IN const pad_r_t *a);
+
+void k_sqr_neon(OUT pad_r_t *c, IN const pad_r_t *a, IN size_t l_param);
+void k_sqr_map_neon(OUT pad_r_t *c,
+                    IN const pad_r_t *a,
+                    IN const k_sqr_map_t *map);
+
+void gf2x_red_neon(OUT pad_r_t *c, IN const dbl_pad_r_t *a);
+
+void gf2x_sqr_red_pmull(OUT pad_r_t *c, IN const pad_r_t *a);
+void gf2x_sqr_red_k_pmull(OUT pad_r_t *c,
+                          IN const pad_r_t *a,
+                          IN size_t         num_sqrs);
 #endif
 
 // GF2X methods struct
 typedef struct gf2x_ctx_st {
   size_t mul_base_qwords;
   void (*mul_base)(OUT uint64_t *c, IN const uint64_t *a, IN const uint64_t *b);
+  void (*mul_base_x2)(OUT uint64_t *const c[2],
+                      IN const uint64_t *const a[2],
+                      IN const uint64_t *const b[2]);
   void (*karatzuba_add1)(OUT uint64_t *alah,
                          OUT uint64_t *blbh,
                          IN const uint64_t *a,
@@ -115,11 +260,24 @@ typedef struct gf2x_ctx_st {
   void (*karatzuba_add3)(OUT uint64_t *c,
                          IN const uint64_t *mid,
                          IN const size_t    qwords_len);
+  void (*karatzuba_red)(OUT pad_r_t *c,
+                        IN const uint64_t *lo,
+                        IN const uint64_t *hi,
+                        IN const uint64_t *mid);
 
   void (*sqr)(OUT dbl_pad_r_t *c, IN const pad_r_t *a);
   void (*k_sqr)(OUT pad_r_t *c, IN const pad_r_t *a, IN size_t l_param);
+  void (*k_sqr_map)(OUT pad_r_t *c,
+                    IN const pad_r_t *a,
+                    IN const k_sqr_map_t *map);
 
   void (*red)(OUT pad_r_t *c, IN const dbl_pad_r_t *a);
+
+  void (*sqr_red)(OUT pad_r_t *c, IN const pad_r_t *a);
+  void (*sqr_red_k)(OUT pad_r_t *c, IN const pad_r_t *a, IN size_t num_sqrs);
+
+  // The cap of the ISA policy that the methods follow
+  uint32_t isa_cap;
 } gf2x_ctx;
 
 // Used in gf2x_inv.c to avoid initializing the context many times.
@@ -128,45 +286,182 @@ void gf2x_mod_mul_with_ctx(OUT pad_r_t *c,
                            IN const pad_r_t *b,
                            IN const gf2x_ctx *ctx);
 
-_INLINE_ void gf2x_ctx_init(gf2x_ctx *ctx)
+// Use the multiplication base kernel mul_base (see gf2x_tune.h), ctx must be
+// initialized. Return 0 (and keep ctx unchanged) if the kernel is not
+// supported by the CPU, by the ISA policy, or by the other functions of ctx.
+_INLINE_ uint32_t gf2x_ctx_set_mul_base(gf2x_ctx *ctx,
+                                        IN const uint32_t mul_base)
 {
+  switch(mul_base) {
 #if defined(X86_64)
-  if(is_avx512_enabled()) {
+    case GF2X_MUL_BASE_VPCLMUL:
+      if(!is_vpclmul_enabled() || !is_avx512_enabled() ||
+         !isa_allowed(ctx->isa_cap, BIKE_ISA_AVX512)) {
+        return 0;
+      }
+      ctx->mul_base_qwords = GF2X_VPCLMUL_BASE_QWORDS;
+      ctx->mul_base        = gf2x_mul_base_vpclmul;
+      ctx->mul_base_x2     = gf2x_mul_base_x2_vpclmul;
+      return 1;
+    case GF2X_MUL_BASE_VPCLMUL_AVX2:
+      if(!is_vpclmul_enabled() || !is_avx2_enabled() ||
+         !isa_allowed(ctx->isa_cap, BIKE_ISA_AVX2)) {
+        return 0;
+      }
+      ctx->mul_base_qwords = GF2X_VPCLMUL_BASE_QWORDS;
+      ctx->mul_base        = gf2x_mul_base_vpclmul_avx2;
+      ctx->mul_base_x2     = gf2x_mul_base_x2_vpclmul_avx2;
+      return 1;
+    case GF2X_MUL_BASE_PCLMUL:
+      if(!is_pclmul_enabled() || !isa_allowed(ctx->isa_cap, BIKE_ISA_AVX2)) {
+        return 0;
+      }
+      ctx->mul_base_qwords = GF2X_PCLMUL_BASE_QWORDS;
+      ctx->mul_base        = gf2x_mul_base_pclmul;
+      ctx->mul_base_x2     = gf2x_mul_base_x2_pclmul;
+      return 1;
+#elif defined(AARCH64)
+    case GF2X_MUL_BASE_PMULL:
+      if(!is_pmull_enabled() || !isa_allowed(ctx->isa_cap, BIKE_ISA_NEON)) {
+        return 0;
+      }
+      ctx->mul_base_qwords = GF2X_PMULL_BASE_QWORDS;
+      ctx->mul_base        = gf2x_mul_base_pmull;
+      ctx->mul_base_x2     = gf2x_mul_base_x2_pmull;
+      return 1;
+#endif
+    case GF2X_MUL_BASE_PORT:
+      // The vectorized Karatsuba additions require larger leaves
+      if(ctx->karatzuba_add1 != karatzuba_add1_port) {
+        return 0;
+      }
+      ctx->mul_base_qwords = GF2X_PORT_BASE_QWORDS;
+      ctx->mul_base        = gf2x_mul_base_port;
+      ctx->mul_base_x2     = gf2x_mul_base_x2_port;
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+// Set the methods that are the fastest for the features of the CPU, among
+// the tiers that cap allows (see bike_isa_policy_t). This is done once by
+// cpu_features_init, see gf2x_ctx_init.
+_INLINE_ void gf2x_ctx_resolve(gf2x_ctx *ctx, IN const uint32_t cap)
+{
+  ctx->isa_cap = cap;
+
+#if defined(X86_64)
+  if(is_avx512_enabled() && isa_allowed(cap, BIKE_ISA_AVX512)) {
     ctx->karatzuba_add1 = karatzuba_add1_avx512;
     ctx->karatzuba_add2 = karatzuba_add2_avx512;
     ctx->karatzuba_add3 = karatzuba_add3_avx512;
+    ctx->karatzuba_red  = karatzuba_red_avx512;
     ctx->k_sqr          = k_sqr_avx512;
+    ctx->k_sqr_map      = k_sqr_map_avx512;
     ctx->red            = gf2x_red_avx512;
-  } else if(is_avx2_enabled()) {
+
+    if(is_vbmi_enabled() && is_bitalg_enabled()) {
+      ctx->k_sqr     = k_sqr_vbmi;
+      ctx->k_sqr_map = k_sqr_map_vbmi;
+    }
+    if(is_vbmi2_enabled()) {
+      ctx->karatzuba_red = karatzuba_red_vbmi2;
+      ctx->red           = gf2x_red_vbmi2;
+    }
+  } else if(is_avx2_enabled() && isa_allowed(cap, BIKE_ISA_AVX2)) {
     ctx->karatzuba_add1 = karatzuba_add1_avx2;
     ctx->karatzuba_add2 = karatzuba_add2_avx2;
     ctx->karatzuba_add3 = karatzuba_add3_avx2;
+    ctx->karatzuba_red  = karatzuba_red_avx2;
     ctx->k_sqr          = k_sqr_avx2;
+    ctx->k_sqr_map      = k_sqr_map_avx2;
     ctx->red            = gf2x_red_avx2;
   } else
+#elif defined(AARCH64)
+  // The Karatsuba additions are left portable: the compiler vectorizes them,
+  // and they must also support the leaves of gf2x_mul_base_port
+  if(is_neon_enabled() && isa_allowed(cap, BIKE_ISA_NEON)) {
+    ctx->karatzuba_add1 = karatzuba_add1_port;
+    ctx->karatzuba_add2 = karatzuba_add2_port;
+    ctx->karatzuba_add3 = karatzuba_add3_port;
+    ctx->karatzuba_red  = karatzuba_red_neon;
+    ctx->k_sqr          = k_sqr_neon;
+    ctx->k_sqr_map      = k_sqr_map_neon;
+    ctx->red            = gf2x_red_neon;
+  } else
 #endif
   {
     ctx->karatzuba_add1 = karatzuba_add1_port;
     ctx->karatzuba_add2 = karatzuba_add2_port;
     ctx->karatzuba_add3 = karatzuba_add3_port;
+    ctx->karatzuba_red  = karatzuba_red_port;
     ctx->k_sqr          = k_sqr_port;
+    ctx->k_sqr_map      = k_sqr_map_port;
     ctx->red            = gf2x_red_port;
   }
 
 #if defined(X86_64)
-  if(is_vpclmul_enabled() && is_avx512_enabled()) {
+  if(is_vpclmul_enabled() && is_avx512_enabled() &&
+     isa_allowed(cap, BIKE_ISA_AVX512)) {
     ctx->mul_base_qwords = GF2X_VPCLMUL_BASE_QWORDS;
     ctx->mul_base        = gf2x_mul_base_vpclmul;
+    ctx->mul_base_x2     = gf2x_mul_base_x2_vpclmul;
     ctx->sqr             = gf2x_sqr_vpclmul;
-  } else if(is_pclmul_enabled()) {
+    ctx->sqr_red         = gf2x_sqr_red_vpclmul;
+    ctx->sqr_red_k       = gf2x_sqr_red_k_vpclmul;
+  } else if(is_vpclmul_enabled() && is_avx2_enabled() &&
+            isa_allowed(cap, BIKE_ISA_AVX2)) {
+    ctx->mul_base_qwords = GF2X_VPCLMUL_BASE_QWORDS;
+    ctx->mul_base        = gf2x_mul_base_vpclmul_avx2;
+    ctx->mul_base_x2     = gf2x_mul_base_x2_vpclmul_avx2;
+    ctx->sqr             = gf2x_sqr_vpclmul_avx2;
+    ctx->sqr_red         = gf2x_sqr_red_pclmul;
+    ctx->sqr_red_k       = gf2x_sqr_red_k_pclmul;
+  } else if(is_pclmul_enabled() && isa_allowed(cap, BIKE_ISA_AVX2)) {
     ctx->mul_base_qwords = GF2X_PCLMUL_BASE_QWORDS;
     ctx->mul_base        = gf2x_mul_base_pclmul;
+    ctx->mul_base_x2     = gf2x_mul_base_x2_pclmul;
     ctx->sqr             = gf2x_sqr_pclmul;
+    ctx->sqr_red         = gf2x_sqr_red_pclmul;
+    ctx->sqr_red_k       = gf2x_sqr_red_k_pclmul;
+  } else
+#elif defined(AARCH64)
+  if(is_pmull_enabled() && isa_allowed(cap, BIKE_ISA_NEON)) {
+    ctx->mul_base_qwords = GF2X_PMULL_BASE_QWORDS;
+    ctx->mul_base        = gf2x_mul_base_pmull;
+    ctx->mul_base_x2     = gf2x_mul_base_x2_pmull;
+    ctx->sqr             = gf2x_sqr_pmull;
+    ctx->sqr_red         = gf2x_sqr_red_pmull;
+    ctx->sqr_red_k       = gf2x_sqr_red_k_pmull;
   } else
 #endif
   {
     ctx->mul_base_qwords = GF2X_PORT_BASE_QWORDS;
     ctx->mul_base        = gf2x_mul_base_port;
+    ctx->mul_base_x2     = gf2x_mul_base_x2_port;
     ctx->sqr             = gf2x_sqr_port;
+    ctx->sqr_red         = gf2x_sqr_red_port;
+    ctx->sqr_red_k       = gf2x_sqr_red_k_port;
   }
 }
+
+// The methods resolved by cpu_features_init, with the mul_base of the tuning
+// profile, or NULL while they are being resolved (see dispatch.c).
+const gf2x_ctx *gf2x_ctx_resolved(void);
+
+_INLINE_ void gf2x_ctx_init(gf2x_ctx *ctx)
+{
+#if defined(BIKE_TARGET_ISA)
+  // Bound statically, so the leaves of the tune profile are not applied
+  gf2x_ctx_resolve(ctx, BIKE_ISA_AUTO);
+#else
+  const gf2x_ctx *resolved = gf2x_ctx_resolved();
+  if(resolved != NULL) {
+    *ctx = *resolved;
+  } else {
+    // The default leaves, which compute the same products
+    gf2x_ctx_resolve(ctx, BIKE_ISA_AUTO);
+  }
+#endif
+}
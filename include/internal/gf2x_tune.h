@@ -0,0 +1,58 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "defs.h"
+
+// A tuning profile holds the choices of the gf2x functions that depend on
+// the relative performance of the kernels on a specific CPU model, rather
+// than on the instructions that the CPU supports:
+//  - k_sqr_thr: gf2x_mod_inv computes f^(2^k) by k squarings when
+//    k <= k_sqr_thr, and by a single k-squaring otherwise.
+//  - mul_base: the kernel at the leaves of the Karatsuba multiplication
+//    (and thereby the leaf size), see gf2x_ctx_init.
+//
+// The profiles are measured by bike_tune (e.g., with the bike-tune tool) and
+// stored in src/gf2x/gf2x_tune_profiles.h, keyed by the CPU signature and R.
+// The profile of the current CPU is loaded on the first call to
+// gf2x_tune_profile, after cpu_features_init. CPUs without a stored profile
+// use the defaults below.
+#define GF2X_DEFAULT_K_SQR_THR (64)
+
+// Identifiers of the multiplication base kernels.
+// GF2X_MUL_BASE_AUTO keeps the default choice of gf2x_ctx_init.
+#define GF2X_MUL_BASE_AUTO         (0)
+#define GF2X_MUL_BASE_PORT         (1)
+#define GF2X_MUL_BASE_PCLMUL       (2)
+#define GF2X_MUL_BASE_VPCLMUL_AVX2 (3)
+#define GF2X_MUL_BASE_VPCLMUL      (4)
+#define GF2X_MUL_BASE_PMULL        (5)
+#define GF2X_MUL_BASE_NUM          (6)
+
+typedef struct gf2x_tune_profile_s {
+  uint32_t cpu_sig;
+  uint32_t r_bits;
+  uint32_t k_sqr_thr;
+  uint32_t mul_base;
+} gf2x_tune_profile_t;
+
+// The profile that is currently used by gf2x_ctx_init and gf2x_mod_inv.
+// Its cpu_sig and r_bits are those of the current CPU and R.
+void gf2x_tune_profile(OUT gf2x_tune_profile_t *profile);
+
+// Replace the current profile, e.g., with one that was measured by bike_tune
+// in an earlier run. The profile is published with one atomic store, so it
+// can also be replaced while other threads run BIKE operations. A mul_base
+// that the CPU does not support is ignored.
+void bike_set_tune_profile(IN const gf2x_tune_profile_t *profile);
+
+// Measure the profile of the current CPU, return it in profile, and use it
+// from now on (see bike_set_tune_profile).
+void bike_tune(OUT gf2x_tune_profile_t *profile);
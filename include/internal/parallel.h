@@ -0,0 +1,39 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include "defs.h"
+
+// Latency mode (LATENCY_MODE compilation flag): independent parts of a single
+// operation, e.g., the three products of the top level of the Karatsuba
+// multiplication, are executed concurrently by a small team of helper threads.
+// The mode reduces the latency of a single decapsulation on a machine with
+// idle cores, and is mostly useful for Level-5. Without the flag, the tasks
+// are executed one after the other by the calling thread.
+// The helpers are created by the first call to par_run of the process (also
+// in the child of fork), and they are pinned to CPUs only if the
+// BIKE_PIN_HELPERS environment variable is set.
+
+// The number of helper threads in the team
+#define PAR_NUM_HELPERS (2)
+
+// The maximal number of tasks in a single call to par_run
+#define PAR_MAX_TASKS (PAR_NUM_HELPERS + 1)
+
+typedef struct par_task_s {
+  void (*func)(void *arg);
+  void *arg;
+} par_task_t;
+
+// Execute tasks[0], ..., tasks[n - 1] and return when all of them complete.
+// The calling thread executes tasks[0], and the helper threads execute the
+// rest. When the team is not available (it is used by another thread, or
+// the latency mode is disabled), the calling thread executes all the tasks.
+void par_run(IN const par_task_t *tasks, IN size_t n);
@@ -44,6 +44,13 @@ ret_t sample_error_vec_indices_avx512(OUT idx_t *out,
 #endif
 #endif
 
+#if defined(AARCH64)
+void secure_set_bits_neon(OUT pad_r_t *r,
+                          IN size_t    first_pos,
+                          IN const idx_t *wlist,
+                          IN size_t       w_size);
+#endif
+
 typedef struct sampling_ctx_st {
   void (*secure_set_bits)(OUT pad_r_t *r,
                           IN size_t    first_pos,
@@ -56,20 +63,30 @@ typedef struct sampling_ctx_st {
 #endif
 } sampling_ctx;
 
-_INLINE_ void sampling_ctx_init(sampling_ctx *ctx)
+// Set the methods that are the fastest for the features of the CPU, among
+// the tiers that cap allows. This is done once by cpu_features_init,
+// see sampling_ctx_init.
+_INLINE_ void sampling_ctx_resolve(sampling_ctx *ctx, IN const uint32_t cap)
 {
 #if defined(X86_64)
-  if(is_avx512_enabled()) {
+  if(is_avx512_enabled() && isa_allowed(cap, BIKE_ISA_AVX512)) {
     ctx->secure_set_bits = secure_set_bits_avx512;
 #if defined(UNIFORM_SAMPLING)
     ctx->sample_error_vec_indices = sample_error_vec_indices_avx512;
 #endif
-  } else if(is_avx2_enabled()) {
+  } else if(is_avx2_enabled() && isa_allowed(cap, BIKE_ISA_AVX2)) {
     ctx->secure_set_bits = secure_set_bits_avx2;
 #if defined(UNIFORM_SAMPLING)
     ctx->sample_error_vec_indices = sample_error_vec_indices_avx2;
 #endif
   } else
+#elif defined(AARCH64)
+  if(is_neon_enabled() && isa_allowed(cap, BIKE_ISA_NEON)) {
+    ctx->secure_set_bits = secure_set_bits_neon;
+#if defined(UNIFORM_SAMPLING)
+    ctx->sample_error_vec_indices = sample_error_vec_indices_port;
+#endif
+  } else
 #endif
   {
     ctx->secure_set_bits = secure_set_bits_port;
@@ -78,3 +95,21 @@ _INLINE_ void sampling_ctx_init(sampling_ctx *ctx)
 #endif
   }
 }
+
+// The methods resolved by cpu_features_init,
+// or NULL while they are being resolved (see dispatch.c).
+const sampling_ctx *sampling_ctx_resolved(void);
+
+_INLINE_ void sampling_ctx_init(sampling_ctx *ctx)
+{
+#if defined(BIKE_TARGET_ISA)
+  sampling_ctx_resolve(ctx, BIKE_ISA_AUTO);
+#else
+  const sampling_ctx *resolved = sampling_ctx_resolved();
+  if(resolved != NULL) {
+    *ctx = *resolved;
+  } else {
+    sampling_ctx_resolve(ctx, BIKE_ISA_AUTO);
+  }
+#endif
+}
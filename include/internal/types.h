@@ -77,6 +77,25 @@ typedef struct sk_s {
 
 typedef ALIGN(sizeof(idx_t)) sk_t aligned_sk_t;
 
+// The rotation of the syndrome by one index of the secret key, as computed by
+// the rotate_plan function of the decode context (see decode_internal.h):
+// the blend masks (0 or all ones) of the levels of the barrel shifter that
+// rotates whole blocks, and the remaining (small) rotation.
+#define ROTATE_PLAN_LEVELS (12)
+
+typedef struct rotate_plan_s {
+  uint64_t mask[ROTATE_PLAN_LEVELS];
+  uint32_t small;
+} rotate_plan_t;
+
+// The decode plan of a secret key holds the rotations of all the indices of
+// sk->wlist, and the block size (in bits) of the rotate functions that it was
+// computed for. The plan is derived from the secret key and is secret.
+typedef struct decode_plan_s {
+  rotate_plan_t rot[N0][D];
+  uint32_t      block_bits;
+} decode_plan_t;
+
 // Pad r to the next Block
 typedef struct pad_r_s {
   r_t     val;
@@ -88,6 +107,28 @@ typedef struct dbl_pad_r_s {
   uint8_t raw[2 * R_PADDED_BYTES];
 } ALIGN(ALIGN_BYTES) dbl_pad_r_t;
 
+// An operand of the multiplication together with its Karatsuba half-sums
+// (a_lo + a_hi) of every recursion level whose operands are larger than
+// GF2X_PREPARED_MIN_QWORDS, see gf2x_prepare. The sums of an operand of
+// n qwords take S(n) = n/2 + 3*S(n/2) qwords (and S(MIN) = 0), that is
+// S(n) = 3^log2(n/MIN) * MIN - n.
+#define GF2X_PREPARED_MIN_QWORDS (16)
+
+// 3^log2(x) for the ratios R_PADDED_QWORDS / GF2X_PREPARED_MIN_QWORDS
+// of the supported levels (checked in gf2x_mul.c)
+#define POW3_LOG2(x) \
+  ((x) == 16 ? 81 : ((x) == 32 ? 243 : ((x) == 64 ? 729 : 0)))
+
+#define GF2X_PREPARED_SUMS_QWORDS                           \
+  ((POW3_LOG2(R_PADDED_QWORDS / GF2X_PREPARED_MIN_QWORDS) * \
+    GF2X_PREPARED_MIN_QWORDS) -                             \
+   R_PADDED_QWORDS)
+
+typedef struct gf2x_prepared_s {
+  pad_r_t  a;
+  uint64_t sums[GF2X_PREPARED_SUMS_QWORDS];
+} ALIGN(ALIGN_BYTES) gf2x_prepared_t;
+
 typedef struct pad_e_s {
   pad_r_t val[N0];
 } ALIGN(ALIGN_BYTES) pad_e_t;
@@ -113,10 +154,14 @@ typedef struct syndrome_s {
   uint64_t qw[3 * R_QWORDS];
 } ALIGN(ALIGN_BYTES) syndrome_t;
 
+// The UPC slices hold only the R_BITS counters, rounded up to whole ZMMs
+// (as processed by the AVX512 kernels), and not R_PADDED_BITS.
+#define UPC_SLICE_QWORDS (R_ZMM * QWORDS_IN_ZMM)
+
 typedef struct upc_slice_s {
   union {
-    pad_r_t  r;
-    uint64_t qw[sizeof(pad_r_t) / sizeof(uint64_t)];
+    r_t      r;
+    uint64_t qw[UPC_SLICE_QWORDS];
   } ALIGN(ALIGN_BYTES) u;
 } ALIGN(ALIGN_BYTES) upc_slice_t;
 
@@ -124,4 +169,46 @@ typedef struct upc_s {
   upc_slice_t slice[SLICES];
 } upc_t;
 
+// A batch of rotated syndromes (only their first R_BITS)
+// that are added together to the UPC slices, see upc_bit_slice_tiled.
+#define UPC_BATCH (8)
+
+typedef struct upc_batch_s {
+  upc_slice_t rotated[UPC_BATCH];
+} upc_batch_t;
+
+// The joint UPC array holds the counters of the two halves of the secret key
+// in every slice, where half i starts at qword (i * R_QWORDS), so both halves
+// are processed in one sweep, see upc_joint_tiled.
+#define UPC_JOINT_QWORDS \
+  (DIVIDE_AND_CEIL(N0 * R_QWORDS, QWORDS_IN_ZMM) * QWORDS_IN_ZMM)
+
+typedef struct upc_joint_s {
+  uint64_t slice[SLICES][UPC_JOINT_QWORDS];
+} ALIGN(ALIGN_BYTES) upc_joint_t;
+
+typedef struct upc_joint_batch_s {
+  uint64_t rotated[UPC_BATCH][UPC_JOINT_QWORDS];
+} ALIGN(ALIGN_BYTES) upc_joint_batch_t;
+
+// The number of ciphertexts that decode_multi decodes together. Every slice
+// of the multi UPC array holds the counters of the ciphertexts side by side,
+// UPC_SLICE_QWORDS qwords each, see upc_multi_tiled.
+#define DECODE_MULTI_MAX (8)
+#define UPC_MULTI_QWORDS (DECODE_MULTI_MAX * UPC_SLICE_QWORDS)
+
+typedef struct upc_multi_s {
+  uint64_t qw[SLICES * UPC_MULTI_QWORDS];
+} ALIGN(ALIGN_BYTES) upc_multi_t;
+
+typedef struct upc_multi_batch_s {
+  uint64_t qw[UPC_BATCH * UPC_MULTI_QWORDS];
+} ALIGN(ALIGN_BYTES) upc_multi_batch_t;
+
+// The time to live (in iterations) of the flips of the Backflip decoder,
+// bit-sliced over two errors vectors (the values are at most 3).
+typedef struct ttl_s {
+  e_t bit[2];
+} ttl_t;
+
 #pragma pack(pop)
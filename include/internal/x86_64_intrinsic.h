@@ -114,6 +114,7 @@
 #  define ADD_I16(a, b)             _mm512_add_epi16(a, b)
 #  define ADD_I32(a, b)             _mm512_add_epi32(a, b)
 #  define ADD_I64(a, b)             _mm512_add_epi64(a, b)
+#  define MADD_I8(src, k, a, b)     _mm512_mask_add_epi8(src, k, a, b)
 #  define MSUB_I16(src, k, a, b)    _mm512_mask_sub_epi16(src, k, a, b)
 #  define MSUB_I32(src, k, a, b)    _mm512_mask_sub_epi32(src, k, a, b)
 #  define SRLI_I16(a, imm)          _mm512_srli_epi16(a, imm)
@@ -122,6 +123,11 @@
 #  define MOR_I64(src, mask, a, b)  _mm512_mask_or_epi64(src, mask, a, b)
 #  define MXOR_I64(src, mask, a, b) _mm512_mask_xor_epi64(src, mask, a, b)
 #  define VALIGN(a, b, count)       _mm512_alignr_epi64(a, b, count)
+#  define TERNLOG_I64(a, b, c, imm) _mm512_ternarylogic_epi64(a, b, c, imm)
+
+// Funnel shifts, require AVX512-VBMI2
+#  define SHRDV_I64(lo, hi, cnt) _mm512_shrdv_epi64(lo, hi, cnt)
+#  define SHLDI_I64(hi, lo, imm) _mm512_shldi_epi64(hi, lo, imm)
 
 #  define CMPM_U8(a, b, cmp_op)  _mm512_cmp_epu8_mask(a, b, cmp_op)
 #  define CMPM_U16(a, b, cmp_op) _mm512_cmp_epu16_mask(a, b, cmp_op)
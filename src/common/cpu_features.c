@@ -9,15 +9,41 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#if defined(BIKE_TARGET_ISA)
+// The features are still detected when the library is built for a single ISA,
+// but the library uses the constants of cpu_features.h instead of them.
+#  undef is_avx2_enabled
+#  undef is_avx512_enabled
+#  undef is_pclmul_enabled
+#  undef is_vpclmul_enabled
+#  undef is_vbmi_enabled
+#  undef is_vbmi2_enabled
+#  undef is_bitalg_enabled
+#  undef is_neon_enabled
+#  undef is_pmull_enabled
+#endif
+
 static uint32_t avx2_flag;
 static uint32_t avx512_flag;
 static uint32_t pclmul_flag;
 static uint32_t vpclmul_flag;
+static uint32_t vbmi_flag;
+static uint32_t vbmi2_flag;
+static uint32_t bitalg_flag;
+static uint32_t neon_flag;
+static uint32_t pmull_flag;
+static uint32_t cpu_sig;
 
 uint32_t is_avx2_enabled(void) { return avx2_flag; }
 uint32_t is_avx512_enabled(void) { return avx512_flag; }
 uint32_t is_pclmul_enabled(void) { return pclmul_flag; }
 uint32_t is_vpclmul_enabled(void) { return vpclmul_flag; }
+uint32_t is_vbmi_enabled(void) { return vbmi_flag; }
+uint32_t is_vbmi2_enabled(void) { return vbmi2_flag; }
+uint32_t is_bitalg_enabled(void) { return bitalg_flag; }
+uint32_t is_neon_enabled(void) { return neon_flag; }
+uint32_t is_pmull_enabled(void) { return pmull_flag; }
+uint32_t cpu_signature(void) { return cpu_sig; }
 
 #if defined(X86_64)
 
@@ -28,8 +54,18 @@ uint32_t is_vpclmul_enabled(void) { return vpclmul_flag; }
 
 #  define EBX_BIT_AVX2    (1 << 5)
 #  define EBX_BIT_AVX512  (1 << 16)
+#  define ECX_BIT_VBMI    (1 << 1)
+#  define ECX_BIT_VBMI2   (1 << 6)
 #  define ECX_BIT_VPCLMUL (1 << 10)
+#  define ECX_BIT_BITALG  (1 << 12)
 #  define ECX_BIT_PCLMUL  (1 << 1)
+#  define ECX_BIT_OSXSAVE (1 << 27)
+
+// The state components of XCR0 that the OS must enable (save and restore on
+// context switches) before the YMM and the ZMM registers can be used:
+// SSE and AVX for YMM, and also the opmask and the ZMM registers for ZMM.
+#  define XCR0_YMM_STATE (0x06)
+#  define XCR0_ZMM_STATE (0xe6)
 
 static uint32_t get_cpuid_count(uint32_t  leaf,
                                 uint32_t  sub_leaf,
@@ -49,33 +85,117 @@ static uint32_t get_cpuid_count(uint32_t  leaf,
   return 1;
 }
 
-void cpu_features_init(void)
+// XGETBV is used through asm, so that the file does not require -mxsave
+static uint64_t get_xcr0(void)
+{
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return ((uint64_t)edx << 32) | eax;
+}
+
+static void detect_features(void)
 {
   uint32_t eax, ebx, ecx, edx;
-  if(!get_cpuid_count(EXTENDED_FEATURES_LEAF, EXTENDED_FEATURES_SUBLEAF_ZERO,
+  if(!get_cpuid_count(1, EXTENDED_FEATURES_SUBLEAF_ZERO,
                       &eax, &ebx, &ecx, &edx)) {
     return;
   }
+  pclmul_flag = ecx & ECX_BIT_PCLMUL;
+  cpu_sig     = eax;
 
-  avx2_flag    = ebx & EBX_BIT_AVX2;
-  avx512_flag  = ebx & EBX_BIT_AVX512;
-  vpclmul_flag = ecx & ECX_BIT_VPCLMUL;
+  // The CPUID bits tell what the CPU supports, XCR0 tells whether the OS
+  // enabled the state of the YMM and the ZMM registers.
+  const uint64_t xcr0   = (ecx & ECX_BIT_OSXSAVE) ? get_xcr0() : 0;
+  const uint32_t ymm_ok = (xcr0 & XCR0_YMM_STATE) == XCR0_YMM_STATE;
+  const uint32_t zmm_ok = (xcr0 & XCR0_ZMM_STATE) == XCR0_ZMM_STATE;
 
-  if(!get_cpuid_count(1, EXTENDED_FEATURES_SUBLEAF_ZERO,
+  if(!get_cpuid_count(EXTENDED_FEATURES_LEAF, EXTENDED_FEATURES_SUBLEAF_ZERO,
                       &eax, &ebx, &ecx, &edx)) {
     return;
   }
-  pclmul_flag = ecx & ECX_BIT_PCLMUL;
+
+  // VPCLMULQDQ is used with YMM registers (with AVX2) and with ZMM registers
+  // (with AVX512), the latter requires also avx512_flag.
+  avx2_flag    = ymm_ok ? (ebx & EBX_BIT_AVX2) : 0;
+  vpclmul_flag = ymm_ok ? (ecx & ECX_BIT_VPCLMUL) : 0;
+  avx512_flag  = zmm_ok ? (ebx & EBX_BIT_AVX512) : 0;
+  vbmi_flag    = zmm_ok ? (ecx & ECX_BIT_VBMI) : 0;
+  vbmi2_flag   = zmm_ok ? (ecx & ECX_BIT_VBMI2) : 0;
+  bitalg_flag  = zmm_ok ? (ecx & ECX_BIT_BITALG) : 0;
 }
 
-#else // X86_64
+#elif defined(AARCH64)
 
-void cpu_features_init(void)
+#  if defined(__linux__)
+#    include <sys/auxv.h>
+
+// The bits of AT_HWCAP, see arch/arm64/include/uapi/asm/hwcap.h in Linux
+#    define HWCAP_BIT_PMULL (1 << 4)
+#    define HWCAP_BIT_CPUID (1 << 11)
+#  endif
+
+static void detect_features(void)
+{
+  avx2_flag    = 0;
+  avx512_flag  = 0;
+  pclmul_flag  = 0;
+  vpclmul_flag = 0;
+  vbmi_flag    = 0;
+  vbmi2_flag   = 0;
+  bitalg_flag  = 0;
+  cpu_sig      = 0;
+
+  // NEON (Advanced SIMD) is mandatory in AArch64
+  neon_flag  = 1;
+  pmull_flag = 0;
+
+#  if defined(__linux__)
+  const unsigned long hwcap = getauxval(AT_HWCAP);
+
+  pmull_flag = !!(hwcap & HWCAP_BIT_PMULL);
+
+  // The kernel emulates the reads of MIDR_EL1 from user space
+  if(hwcap & HWCAP_BIT_CPUID) {
+    uint64_t midr;
+    __asm__ volatile("mrs %0, midr_el1" : "=r"(midr));
+    cpu_sig = (uint32_t)midr;
+  }
+#  elif defined(__APPLE__)
+  // All the Apple CPUs support the cryptographic extension
+  pmull_flag = 1;
+#  endif
+}
+
+#else // X86_64 or AARCH64
+
+static void detect_features(void)
 {
   avx2_flag    = 0;
   avx512_flag  = 0;
   pclmul_flag  = 0;
   vpclmul_flag = 0;
+  vbmi_flag    = 0;
+  vbmi2_flag   = 0;
+  bitalg_flag  = 0;
+  neon_flag    = 0;
+  pmull_flag   = 0;
+  cpu_sig      = 0;
 }
 
 #endif
+
+void cpu_features_init(void)
+{
+  detect_features();
+  dispatch_resolve();
+}
+
+#if defined(__GNUC__)
+// Detect the features when the library is loaded (or when the program starts,
+// if it is linked statically), so that they are not left disabled when the
+// caller does not call cpu_features_init.
+__attribute__((constructor)) static void cpu_features_load(void)
+{
+  cpu_features_init();
+}
+#endif
@@ -0,0 +1,107 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ */
+
+#include "cpu_features.h"
+#include "decode_internal.h"
+#include "gf2x_internal.h"
+#include "sampling_internal.h"
+
+// The methods of the contexts are resolved once for the features of the CPU
+// and every cap of the ISA policy, and the *_ctx_init functions copy the
+// contexts of the caps of the current policy instead of testing the features
+// on every call. The contexts are never written after they are published, so
+// bike_set_isa_policy only replaces the policy that selects them (with one
+// atomic store, see isa_policy.c). They are resolved by cpu_features_init,
+// which runs when the library is loaded (see cpu_features.c). Where it did not
+// run, the first caller that moves the state from DISPATCH_EMPTY to
+// DISPATCH_RESOLVING runs it, and concurrent callers resolve their own
+// contexts (without the ISA policy) until the state becomes DISPATCH_READY,
+// like the k-squaring maps of gf2x_mod_inv.
+// The gf2x contexts are also resolved for every mul_base of the tuning
+// profile, so bike_set_tune_profile likewise replaces only the profile that
+// selects them (see gf2x_tune.c).
+#define DISPATCH_EMPTY     (0)
+#define DISPATCH_RESOLVING (1)
+#define DISPATCH_READY     (2)
+
+static gf2x_ctx     gf2x_resolved[GF2X_MUL_BASE_NUM][BIKE_ISA_NUM];
+static decode_ctx   decode_resolved[BIKE_ISA_NUM];
+static sampling_ctx sampling_resolved[BIKE_ISA_NUM];
+static uint32_t     dispatch_state = DISPATCH_EMPTY;
+
+void dispatch_resolve(void)
+{
+  // The features do not change, so the published contexts are kept
+  if(__atomic_load_n(&dispatch_state, __ATOMIC_ACQUIRE) == DISPATCH_READY) {
+    return;
+  }
+
+  for(uint32_t cap = 0; cap < BIKE_ISA_NUM; cap++) {
+    for(uint32_t base = 0; base < GF2X_MUL_BASE_NUM; base++) {
+      // Keeps the default leaves if the cap does not allow the base
+      gf2x_ctx_resolve(&gf2x_resolved[base][cap], cap);
+      gf2x_ctx_set_mul_base(&gf2x_resolved[base][cap], base);
+    }
+    decode_ctx_resolve(&decode_resolved[cap], cap);
+    sampling_ctx_resolve(&sampling_resolved[cap], cap);
+  }
+
+  __atomic_store_n(&dispatch_state, DISPATCH_READY, __ATOMIC_RELEASE);
+}
+
+_INLINE_ uint32_t dispatch_ready(void)
+{
+  if(__atomic_load_n(&dispatch_state, __ATOMIC_ACQUIRE) == DISPATCH_READY) {
+    return 1;
+  }
+
+  uint32_t expected = DISPATCH_EMPTY;
+  if(!__atomic_compare_exchange_n(&dispatch_state, &expected,
+                                  DISPATCH_RESOLVING, 0, __ATOMIC_ACQUIRE,
+                                  __ATOMIC_RELAXED)) {
+    return 0;
+  }
+
+  // Sets the state to DISPATCH_READY
+  cpu_features_init();
+  return 1;
+}
+
+const gf2x_ctx *gf2x_ctx_resolved(void)
+{
+  if(!dispatch_ready()) {
+    return NULL;
+  }
+
+  bike_isa_policy_t   policy;
+  gf2x_tune_profile_t profile;
+  isa_policy(&policy);
+  gf2x_tune_profile(&profile);
+  return &gf2x_resolved[profile.mul_base][policy.gf2x];
+}
+
+const decode_ctx *decode_ctx_resolved(void)
+{
+  if(!dispatch_ready()) {
+    return NULL;
+  }
+
+  bike_isa_policy_t policy;
+  isa_policy(&policy);
+  return &decode_resolved[policy.decode];
+}
+
+const sampling_ctx *sampling_ctx_resolved(void)
+{
+  if(!dispatch_ready()) {
+    return NULL;
+  }
+
+  bike_isa_policy_t policy;
+  isa_policy(&policy);
+  return &sampling_resolved[policy.sampling];
+}
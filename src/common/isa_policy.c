@@ -0,0 +1,202 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu_features.h"
+
+// The caps of the policy are packed into one word (POLICY_PACK), so that
+// bike_set_isa_policy publishes a new policy with one atomic store, and the
+// readers see either the old or the new policy of all the groups. The word is
+// POLICY_UNSET until the first isa_policy call reads the policy from the
+// environment, unless bike_set_isa_policy was called before. It is shared by
+// all the instances of MULTI_LEVEL builds.
+#define POLICY_UNSET (0xffffffff)
+#define POLICY_PACK(p) \
+  ((p)->gf2x | ((p)->decode << 8) | ((p)->sampling << 16))
+
+static uint32_t current_policy = POLICY_UNSET;
+
+static const char *const isa_names[] = {"auto", "portable", "avx2", "avx512",
+                                        "neon"};
+
+const char *bike_isa_name(IN const uint32_t isa)
+{
+  if(isa >= (sizeof(isa_names) / sizeof(isa_names[0]))) {
+    return NULL;
+  }
+
+  return isa_names[isa];
+}
+
+// The best tier of the CPU that cap allows, see the *_ctx_resolve functions
+_INLINE_ uint32_t isa_tier(IN const uint32_t cap)
+{
+#if defined(X86_64)
+  if(is_avx512_enabled() && isa_allowed(cap, BIKE_ISA_AVX512)) {
+    return BIKE_ISA_AVX512;
+  }
+  if(is_avx2_enabled() && isa_allowed(cap, BIKE_ISA_AVX2)) {
+    return BIKE_ISA_AVX2;
+  }
+#elif defined(AARCH64)
+  if(is_neon_enabled() && isa_allowed(cap, BIKE_ISA_NEON)) {
+    return BIKE_ISA_NEON;
+  }
+#endif
+
+  return BIKE_ISA_PORTABLE;
+}
+
+// The kernels of BIKE_TARGET_ISA builds are fixed, so they have no policy
+#if !defined(BIKE_TARGET_ISA)
+// Returns 1 if cap is BIKE_ISA_AUTO, BIKE_ISA_PORTABLE,
+// or an ISA of the architecture
+_INLINE_ uint32_t is_valid_cap(IN const uint32_t cap)
+{
+  switch(cap) {
+    case BIKE_ISA_AUTO:
+    case BIKE_ISA_PORTABLE:
+#  if defined(X86_64)
+    case BIKE_ISA_AVX2:
+    case BIKE_ISA_AVX512:
+#  elif defined(AARCH64)
+    case BIKE_ISA_NEON:
+#  endif
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+_INLINE_ uint32_t match(IN const char *str,
+                        IN const size_t len,
+                        IN const char *name)
+{
+  return (strlen(name) == len) && (strncmp(str, name, len) == 0);
+}
+
+// Parse the cap of the len characters at str
+static uint32_t parse_cap(OUT uint32_t *cap,
+                          IN const char *str,
+                          IN const size_t len)
+{
+  for(uint32_t isa = 0; bike_isa_name(isa) != NULL; isa++) {
+    if(match(str, len, bike_isa_name(isa)) && is_valid_cap(isa)) {
+      *cap = isa;
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+// Parse the policy of BIKE_ISA_POLICY: a cap of all the groups (e.g., "avx2"),
+// or a comma separated list of the caps of the groups
+// (e.g., "gf2x=avx512,decode=avx2"), where the missing groups are not capped.
+static uint32_t parse_policy(OUT bike_isa_policy_t *policy, IN const char *str)
+{
+  bike_isa_policy_t p = {BIKE_ISA_AUTO, BIKE_ISA_AUTO, BIKE_ISA_AUTO};
+  uint32_t          cap;
+
+  if(parse_cap(&cap, str, strlen(str))) {
+    p.gf2x     = cap;
+    p.decode   = cap;
+    p.sampling = cap;
+    *policy    = p;
+    return 1;
+  }
+
+  while(*str != '\0') {
+    const size_t len = strcspn(str, ",");
+    const char  *eq  = memchr(str, '=', len);
+    if(eq == NULL) {
+      return 0;
+    }
+
+    const size_t name_len = (size_t)(eq - str);
+    uint32_t    *group    = NULL;
+    if(match(str, name_len, "gf2x")) {
+      group = &p.gf2x;
+    } else if(match(str, name_len, "decode")) {
+      group = &p.decode;
+    } else if(match(str, name_len, "sampling")) {
+      group = &p.sampling;
+    }
+
+    if((group == NULL) || !parse_cap(group, eq + 1, len - name_len - 1)) {
+      return 0;
+    }
+
+    str += len;
+    if(*str == ',') {
+      str++;
+    }
+  }
+
+  *policy = p;
+  return 1;
+}
+#endif
+
+void isa_policy(OUT bike_isa_policy_t *policy)
+{
+  uint32_t packed = __atomic_load_n(&current_policy, __ATOMIC_ACQUIRE);
+
+  if(packed == POLICY_UNSET) {
+    bike_isa_policy_t p = {BIKE_ISA_AUTO, BIKE_ISA_AUTO, BIKE_ISA_AUTO};
+#if !defined(BIKE_TARGET_ISA)
+    const char *env = getenv("BIKE_ISA_POLICY");
+    // An invalid policy is ignored
+    if(env != NULL) {
+      parse_policy(&p, env);
+    }
+#endif
+
+    // Keeps the policy of a concurrent bike_set_isa_policy (or isa_policy)
+    uint32_t expected = POLICY_UNSET;
+    packed            = POLICY_PACK(&p);
+    if(!__atomic_compare_exchange_n(&current_policy, &expected, packed, 0,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      packed = expected;
+    }
+  }
+
+  policy->gf2x     = packed & 0xff;
+  policy->decode   = (packed >> 8) & 0xff;
+  policy->sampling = (packed >> 16) & 0xff;
+}
+
+uint32_t bike_set_isa_policy(IN const bike_isa_policy_t *policy)
+{
+#if defined(BIKE_TARGET_ISA)
+  (void)policy;
+  return 0;
+#else
+  if(!is_valid_cap(policy->gf2x) || !is_valid_cap(policy->decode) ||
+     !is_valid_cap(policy->sampling)) {
+    return 0;
+  }
+
+  // The contexts of every cap are resolved once (see dispatch.c), so only
+  // the policy that selects them is replaced
+  __atomic_store_n(&current_policy, POLICY_PACK(policy), __ATOMIC_RELEASE);
+  return 1;
+#endif
+}
+
+void bike_get_isa_tiers(OUT bike_isa_policy_t *tiers)
+{
+  bike_isa_policy_t policy;
+  isa_policy(&policy);
+
+  tiers->gf2x     = isa_tier(policy.gf2x);
+  tiers->decode   = isa_tier(policy.decode);
+  tiers->sampling = isa_tier(policy.sampling);
+}
+
@@ -0,0 +1,301 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ */
+
+#if defined(LATENCY_MODE)
+#  if defined(__linux__)
+// Required for pinning the helper threads (pthread_setaffinity_np)
+#    define _GNU_SOURCE
+#  else
+#    define _POSIX_C_SOURCE 200809L
+#  endif
+#endif
+
+#include "parallel.h"
+
+#if defined(LATENCY_MODE)
+
+#  include <pthread.h>
+#  include <sched.h>
+#  include <stdint.h>
+#  include <stdlib.h>
+#  include <time.h>
+#  include <unistd.h>
+
+// A helper waits for a task by spinning on its sequence number, such that the
+// handoff takes only a few cycles. After spinning PAR_SPIN_NS nanoseconds
+// without a task it sleeps on a condition variable until the next task
+// arrives, so an idle helper does not hold a core of a shared host. The
+// caller of par_run also yields its core after spinning PAR_SPIN_NS
+// nanoseconds on the helpers. The clock is read every PAR_SPIN_CHECK spins.
+#  define PAR_SPIN_NS    (50000)
+#  define PAR_SPIN_CHECK (64)
+
+#  if defined(X86_64) || defined(X86)
+#    define CPU_RELAX() __builtin_ia32_pause()
+#  else
+#    define CPU_RELAX() \
+      do {              \
+      } while(0)
+#  endif
+
+typedef struct par_helper_s {
+  // The task is written by the caller before it increments seq
+  par_task_t task;
+  uint64_t   seq;
+  uint64_t   done;
+
+  pthread_mutex_t lock;
+  pthread_cond_t  cond;
+} ALIGN(64) par_helper_t;
+
+// The team is created by the first par_run that moves the state from
+// TEAM_EMPTY to TEAM_STARTING, and the concurrent callers execute their tasks
+// themselves until it becomes TEAM_READY (or TEAM_NONE if it cannot be
+// created). The helpers are not copied to the child of fork, so the child
+// handler of pthread_atfork sets the state back to TEAM_EMPTY and the child
+// creates its own team.
+#  define TEAM_EMPTY    (0)
+#  define TEAM_STARTING (1)
+#  define TEAM_READY    (2)
+#  define TEAM_NONE     (3)
+
+static par_helper_t helpers[PAR_NUM_HELPERS];
+static uint32_t     team_state = TEAM_EMPTY;
+static uint32_t     team_busy;
+static uint32_t     team_atfork;
+
+_INLINE_ uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+// Returns 1 when the spins that started at start exceed PAR_SPIN_NS
+_INLINE_ uint32_t spin_expired(IN OUT size_t *spins, IN const uint64_t start)
+{
+  if((++(*spins) % PAR_SPIN_CHECK) != 0) {
+    return 0;
+  }
+
+  return (now_ns() - start) > PAR_SPIN_NS;
+}
+
+_INLINE_ uint64_t wait_for_task(IN OUT par_helper_t *h, IN const uint64_t last)
+{
+  uint64_t       seq;
+  size_t         spins = 0;
+  const uint64_t start = now_ns();
+
+  while((seq = __atomic_load_n(&h->seq, __ATOMIC_ACQUIRE)) == last) {
+    if(!spin_expired(&spins, start)) {
+      CPU_RELAX();
+      continue;
+    }
+
+    pthread_mutex_lock(&h->lock);
+    while(__atomic_load_n(&h->seq, __ATOMIC_ACQUIRE) == last) {
+      pthread_cond_wait(&h->cond, &h->lock);
+    }
+    pthread_mutex_unlock(&h->lock);
+  }
+
+  return seq;
+}
+
+static void *helper_main(void *arg)
+{
+  par_helper_t *h    = (par_helper_t *)arg;
+  uint64_t      last = 0;
+
+  for(;;) {
+    last = wait_for_task(h, last);
+    h->task.func(h->task.arg);
+    __atomic_store_n(&h->done, last, __ATOMIC_RELEASE);
+  }
+
+  return NULL;
+}
+
+#  if defined(__linux__)
+// Pin helper i to a CPU on which the process may run, when the
+// BIKE_PIN_HELPERS environment variable is set (e.g., on a dedicated host).
+// The helpers of different processes start from different CPUs (by their
+// pid), the CPU of the calling thread is not known.
+_INLINE_ void pin_helper(IN pthread_t thread, IN const size_t i)
+{
+  cpu_set_t allowed;
+  cpu_set_t target;
+  size_t    found = 0;
+
+  if(getenv("BIKE_PIN_HELPERS") == NULL) {
+    return;
+  }
+
+  if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    return;
+  }
+
+  const int count = CPU_COUNT(&allowed);
+  if(count < 2) {
+    return;
+  }
+
+  const size_t target_idx =
+    ((size_t)getpid() * PAR_NUM_HELPERS + i) % (size_t)count;
+
+  for(int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if(!CPU_ISSET(cpu, &allowed)) {
+      continue;
+    }
+
+    if(found++ == target_idx) {
+      CPU_ZERO(&target);
+      CPU_SET(cpu, &target);
+      pthread_setaffinity_np(thread, sizeof(target), &target);
+      return;
+    }
+  }
+}
+#  endif
+
+// The child of fork has only the thread that called fork, and the helpers
+// of its parent are lost. The helpers of the parent are not running a task
+// of the child, so their state can be reset.
+static void team_after_fork(void)
+{
+  for(size_t i = 0; i < PAR_NUM_HELPERS; i++) {
+    helpers[i].seq  = 0;
+    helpers[i].done = 0;
+    pthread_mutex_init(&helpers[i].lock, NULL);
+    pthread_cond_init(&helpers[i].cond, NULL);
+  }
+
+  team_busy  = 0;
+  team_state = TEAM_EMPTY;
+}
+
+static uint32_t team_init(void)
+{
+  pthread_attr_t attr;
+
+  // The handler is inherited by the children, so it is registered once
+  if(!team_atfork) {
+    if(pthread_atfork(NULL, NULL, team_after_fork) != 0) {
+      return TEAM_NONE;
+    }
+    team_atfork = 1;
+  }
+
+  // The helpers would only compete with the calling thread on a single core
+  if(sysconf(_SC_NPROCESSORS_ONLN) < 2) {
+    return TEAM_NONE;
+  }
+
+  if(pthread_attr_init(&attr) != 0) {
+    return TEAM_NONE;
+  }
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+  for(size_t i = 0; i < PAR_NUM_HELPERS; i++) {
+    pthread_t thread;
+
+    pthread_mutex_init(&helpers[i].lock, NULL);
+    pthread_cond_init(&helpers[i].cond, NULL);
+
+    if(pthread_create(&thread, &attr, helper_main, &helpers[i]) != 0) {
+      // The helpers that were already created stay idle
+      pthread_attr_destroy(&attr);
+      return TEAM_NONE;
+    }
+
+#  if defined(__linux__)
+    pin_helper(thread, i);
+#  endif
+  }
+
+  pthread_attr_destroy(&attr);
+  return TEAM_READY;
+}
+
+// Acquire the team, return 0 if it is not available
+_INLINE_ uint32_t team_acquire(void)
+{
+  uint32_t state = __atomic_load_n(&team_state, __ATOMIC_ACQUIRE);
+
+  if(state == TEAM_EMPTY) {
+    if(!__atomic_compare_exchange_n(&team_state, &state, TEAM_STARTING, 0,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+      return 0;
+    }
+
+    state = team_init();
+    __atomic_store_n(&team_state, state, __ATOMIC_RELEASE);
+  }
+
+  if(state != TEAM_READY) {
+    return 0;
+  }
+
+  return !__atomic_exchange_n(&team_busy, 1, __ATOMIC_ACQUIRE);
+}
+
+void par_run(IN const par_task_t *tasks, IN const size_t n)
+{
+  uint64_t seq[PAR_NUM_HELPERS];
+
+  if((n > PAR_MAX_TASKS) || (n <= 1) || !team_acquire()) {
+    for(size_t i = 0; i < n; i++) {
+      tasks[i].func(tasks[i].arg);
+    }
+    return;
+  }
+
+  // Hand tasks[1], ..., tasks[n - 1] over to the helpers
+  for(size_t i = 1; i < n; i++) {
+    par_helper_t *h = &helpers[i - 1];
+
+    h->task    = tasks[i];
+    seq[i - 1] = h->seq + 1;
+    __atomic_store_n(&h->seq, seq[i - 1], __ATOMIC_RELEASE);
+
+    // Wake the helper up in case it sleeps
+    pthread_mutex_lock(&h->lock);
+    pthread_cond_signal(&h->cond);
+    pthread_mutex_unlock(&h->lock);
+  }
+
+  tasks[0].func(tasks[0].arg);
+
+  // Wait for the helpers, yield the core if they take too long
+  // (e.g., when the machine is oversubscribed)
+  for(size_t i = 1; i < n; i++) {
+    size_t         spins = 0;
+    const uint64_t start = now_ns();
+    while(__atomic_load_n(&helpers[i - 1].done, __ATOMIC_ACQUIRE) !=
+          seq[i - 1]) {
+      if(!spin_expired(&spins, start)) {
+        CPU_RELAX();
+      } else {
+        sched_yield();
+      }
+    }
+  }
+
+  __atomic_store_n(&team_busy, 0, __ATOMIC_RELEASE);
+}
+
+#else // LATENCY_MODE
+
+void par_run(IN const par_task_t *tasks, IN const size_t n)
+{
+  for(size_t i = 0; i < n; i++) {
+    tasks[i].func(tasks[i].arg);
+  }
+}
+
+#endif
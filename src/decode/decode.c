@@ -32,61 +32,93 @@
  *     “Optimized Implementation of QC-MDPC Code-Based Cryptography.”
  *     Concurrency and Computation: Practice and Experience 31 (18):
  *     e5089. https://doi.org/10.1002/cpe.5089.
+ *
+ * [7] The Backflip decoder is described in:
+ *     Sendrier, Nicolas, and Valentin Vasseur. 2019. “On the Decoding Failure
+ *     Rate of QC-MDPC Bit-Flipping Decoders.” In: Ding J., Steinwandt R.
+ *     (eds) Post-Quantum Cryptography. PQCrypto 2019. pp. 404–416.
  */
 
+#include <stdlib.h>
+
 #include "decode.h"
 #include "cleanup.h"
 #include "decode_internal.h"
 #include "gf2x.h"
+#include "parallel.h"
 #include "utilities.h"
 
-// Decoding (bit-flipping) parameter
-#if defined(BG_DECODER)
-#  if(LEVEL == 1)
-#    define MAX_IT 3
-#  elif(LEVEL == 3)
-#    define MAX_IT 4
-#  else
-#    error "Level can only be 1/3"
-#  endif
-#elif defined(BGF_DECODER)
-#  define MAX_IT 5
+// Decoding (bit-flipping) parameters.
+// The iterations of BG are defined for Level-1/3 in [2,3],
+// Level-5 uses the iterations of Level-3.
+#if(LEVEL == 1)
+#  define BG_MAX_IT 3
+#else
+#  define BG_MAX_IT 4
 #endif
-
+#define BGF_MAX_IT      5
+#define BACKFLIP_MAX_IT 4
+#define BG_THRESHOLD    (((D + 1) / 2) + 1)
+
+bike_static_assert((BG_MAX_IT <= DECODER_MAX_IT) &&
+                     (BGF_MAX_IT <= DECODER_MAX_IT) &&
+                     (BACKFLIP_MAX_IT <= DECODER_MAX_IT),
+                   decoder_max_it_err);
+
+// The decoders of decode_ctx_set_decoder:
+//   - BGF [4] runs one Black-Gray iteration and then bit-flipping iterations.
+//   - BG [2,3] runs only Black-Gray iterations.
+//   - Backflip runs one Black-Gray iteration and then bit-flipping iterations
+//     whose flips expire as in [7]. Instead of a time to live that is
+//     computed from the UPC of every flip, only the flips whose UPC is below
+//     the threshold plus DELTA expire, so both are found by one count of the
+//     UPCs. The flips do not expire once the syndrome is zero.
+const decoder_t decoders[DECODER_NUM] = {
+  [DECODER_BGF]      = {"BGF", BGF_MAX_IT, 1, BG_THRESHOLD, 0, 0},
+  [DECODER_BG]       = {"BG", BG_MAX_IT, BG_MAX_IT, BG_THRESHOLD, 0, 0},
+  [DECODER_BACKFLIP] = {"Backflip", BACKFLIP_MAX_IT, 1, BG_THRESHOLD, 2, 0}};
+
+// s = c0*h0, the padded product is also returned in c0h0
+// for the subsequent syndrome updates (see recompute_syndrome).
 void compute_syndrome(OUT syndrome_t *syndrome,
+                      OUT pad_r_t *c0h0,
                       IN const pad_r_t *c0,
                       IN const pad_r_t *h0,
                       IN const decode_ctx *ctx)
 {
-  DEFER_CLEANUP(pad_r_t pad_s, pad_r_cleanup);
-
-  gf2x_mod_mul(&pad_s, c0, h0);
+  gf2x_mod_mul(c0h0, c0, h0);
 
-  bike_memcpy((uint8_t *)syndrome->qw, pad_s.val.raw, R_BYTES);
+  bike_memcpy((uint8_t *)syndrome->qw, c0h0->val.raw, R_BYTES);
   ctx->dup(syndrome);
 }
 
+// The syndrome of the updated ciphertext c0' = (c0 + e0 + pk*e1) is
+//   s = c0'*h0 = c0*h0 + e0*h0 + e1*h1, since pk*h0 = h1.
+// The two products are independent, so they are computed together
+// and their sum is reduced only once.
 _INLINE_ void recompute_syndrome(OUT syndrome_t *syndrome,
-                                 IN const pad_r_t *c0,
+                                 IN const pad_r_t *c0h0,
                                  IN const pad_r_t *h0,
-                                 IN const pad_r_t *pk,
+                                 IN const pad_r_t *h1,
                                  IN const e_t *e,
                                  IN const decode_ctx *ctx)
 {
-  DEFER_CLEANUP(pad_r_t tmp_c0, pad_r_cleanup);
   DEFER_CLEANUP(pad_r_t e0 = {0}, pad_r_cleanup);
   DEFER_CLEANUP(pad_r_t e1 = {0}, pad_r_cleanup);
 
   e0.val = e->val[0];
   e1.val = e->val[1];
 
-  // tmp_c0 = pk * e1 + c0 + e0
-  gf2x_mod_mul(&tmp_c0, &e1, pk);
-  gf2x_mod_add(&tmp_c0, &tmp_c0, c0);
-  gf2x_mod_add(&tmp_c0, &tmp_c0, &e0);
+  // e0 = e0*h0 + e1*h1, the two products are reduced together
+  const pad_r_t *const err[2] = {&e0, &e1};
+  const pad_r_t *const key[2] = {h0, h1};
+  gf2x_mod_mul_acc(&e0, key, err, 2);
 
-  // Recompute the syndrome using the updated ciphertext
-  compute_syndrome(syndrome, &tmp_c0, h0, ctx);
+  // e0 = c0*h0 + e0*h0 + e1*h1
+  gf2x_mod_add(&e0, &e0, c0h0);
+
+  bike_memcpy((uint8_t *)syndrome->qw, e0.val.raw, R_BYTES);
+  ctx->dup(syndrome);
 }
 
 #define MUL64HIGH(c, a, b)                           \
@@ -131,161 +163,817 @@ _INLINE_ uint8_t get_threshold(IN const syndrome_t *s)
   return thr;
 }
 
+// The arguments of find_err1_half and find_err2_half.
+// The two halves (i = 0, 1) of the errors vectors are updated independently,
+// therefore, they are executed as two tasks (see parallel.h).
+typedef struct find_err_args_s {
+  e_t *                     e;
+  e_t *                     black_e;
+  e_t *                     gray_e;
+  const e_t *               pos_e;
+  ttl_t *                   ttl;
+  const syndrome_t *        syndrome;
+  const compressed_idx_d_t *wlist;
+  const rotate_plan_t *     rot;
+  uint8_t                   threshold;
+  const decode_ctx *        ctx;
+  uint32_t                  i;
+} find_err_args_t;
+
+// The rotation plans of the half i of the secret key, where rot holds the
+// plans of both halves (D each), or NULL.
+_INLINE_ const rotate_plan_t *half_rot(IN const rotate_plan_t *rot,
+                                       IN const uint32_t     i)
+{
+  return (rot == NULL) ? NULL : &rot[i * D];
+}
+
+// Run func on the two halves of the errors vectors
+_INLINE_ void run_halves(IN void (*func)(void *arg),
+                         IN const find_err_args_t *args)
+{
+  find_err_args_t half_args[N0];
+  par_task_t      tasks[N0];
+
+  for(uint32_t i = 0; i < N0; i++) {
+    half_args[i]   = *args;
+    half_args[i].i = i;
+    tasks[i].func  = func;
+    tasks[i].arg   = &half_args[i];
+  }
+
+  par_run(tasks, N0);
+}
+
+// The kernels of the bit-sliced counters process the slices of upc_t
+// as one array of SLICES rows of UPC_SLICE_QWORDS qwords.
+bike_static_assert(sizeof(upc_slice_t) == (UPC_SLICE_QWORDS * sizeof(uint64_t)),
+                   upc_slice_size_err);
+
+// Set the bits of ge to the complement of the R_BITS (MSBs of the counters)
+// that start at last_slice.
+_INLINE_ void upc_ge(OUT pad_r_t *ge, IN const uint8_t *last_slice)
+{
+  for(size_t j = 0; j < R_BYTES; j++) {
+    ge->val.raw[j] = (~last_slice[j]);
+  }
+}
+
+// Set the bits of ge_thr (and ge_thr_delta) according to the UPC counters,
+// see upc_bit_slice. The UPC array is modified.
+_INLINE_ void upc_bit_slice_ge(OUT pad_r_t *ge_thr,
+                               OUT pad_r_t *ge_thr_delta,
+                               IN OUT upc_t *upc,
+                               IN const uint8_t threshold,
+                               IN const decode_ctx *ctx)
+{
+  // Subtract the threshold from the UPC counters
+  ctx->bit_slice_full_subtract(upc->slice[0].u.qw, threshold, UPC_SLICE_QWORDS);
+
+  // The last slice of the UPC array holds the MSB of the accumulated values
+  // minus the threshold. Every zero bit indicates a counter that is at
+  // least the threshold.
+  const uint8_t *last_slice = upc->slice[SLICES - 1].u.r.raw;
+  upc_ge(ge_thr, last_slice);
+
+  if(ge_thr_delta == NULL) {
+    return;
+  }
+
+  // Add "DELTA" to the UPC array in a single pass over the slices,
+  // and repeat the above.
+  ctx->bit_slice_add_const(upc->slice[0].u.qw, DELTA, UPC_SLICE_QWORDS);
+  upc_ge(ge_thr_delta, last_slice);
+}
+
+// Count the UPCs of one half of the secret key with the bit-slice-adder
+// methodology of [5].
+void upc_bit_slice(OUT pad_r_t *ge_thr,
+                   OUT pad_r_t *ge_thr_delta,
+                   IN const syndrome_t *syndrome,
+                   IN const compressed_idx_d_t *wlist,
+                   IN const rotate_plan_t *rot,
+                   IN const uint8_t        threshold,
+                   IN const decode_ctx *ctx)
+{
+  DEFER_CLEANUP(syndrome_t rotated_syndrome = {0}, syndrome_cleanup);
+  DEFER_CLEANUP(upc_t upc, upc_cleanup);
+
+  // UPC must start from zero at every iteration
+  bike_memset(&upc, 0, sizeof(upc));
+
+  // Right-rotate the syndrome for every secret key set bit index
+  // Then slice-add it to the UPC array.
+  for(size_t j = 0; j < D; j++) {
+    rotate_right_idx(&rotated_syndrome, syndrome, wlist, rot, j, ctx);
+    ctx->bit_sliced_adder(&upc, &rotated_syndrome, LOG2_MSB(j + 1));
+  }
+
+  upc_bit_slice_ge(ge_thr, ge_thr_delta, &upc, threshold, ctx);
+}
+
+// The same as upc_bit_slice, where the rotated syndromes are added to the
+// UPC array in batches of UPC_BATCH. The UPC array is larger than the L1 cache
+// for Level 3/5, and the batches save most of its loads and stores.
+void upc_bit_slice_tiled(OUT pad_r_t *ge_thr,
+                         OUT pad_r_t *ge_thr_delta,
+                         IN const syndrome_t *syndrome,
+                         IN const compressed_idx_d_t *wlist,
+                         IN const rotate_plan_t *rot,
+                         IN const uint8_t        threshold,
+                         IN const decode_ctx *ctx)
+{
+  DEFER_CLEANUP(syndrome_t rotated_syndrome = {0}, syndrome_cleanup);
+  DEFER_CLEANUP(upc_t upc, upc_cleanup);
+  DEFER_CLEANUP(upc_batch_t batch, upc_batch_cleanup);
+
+  // UPC must start from zero at every iteration. The qwords of the batch
+  // above R_QWORDS are never written, and they are added to unused counters.
+  bike_memset(&upc, 0, sizeof(upc));
+  bike_memset(&batch, 0, sizeof(batch));
+
+  for(size_t j = 0; j < D; j += UPC_BATCH) {
+    const size_t count = ((D - j) < UPC_BATCH) ? (D - j) : UPC_BATCH;
+
+    for(size_t b = 0; b < count; b++) {
+      rotate_right_idx(&rotated_syndrome, syndrome, wlist, rot, j + b, ctx);
+      bike_memcpy(batch.rotated[b].u.qw, rotated_syndrome.qw,
+                  R_QWORDS * sizeof(uint64_t));
+    }
+
+    ctx->bit_sliced_adder_tiled(upc.slice[0].u.qw, batch.rotated[0].u.qw,
+                                count, UPC_SLICE_QWORDS);
+  }
+
+  upc_bit_slice_ge(ge_thr, ge_thr_delta, &upc, threshold, ctx);
+}
+
+// The same as upc_bit_slice_tiled for the two halves of the secret key.
+// The counters of both halves are held in one UPC array (see upc_joint_t),
+// so the adders, the subtraction of the threshold and the addition of DELTA
+// run once over a contiguous array instead of once per half.
+void upc_joint_tiled(OUT pad_e_t *ge_thr,
+                     OUT pad_e_t *ge_thr_delta,
+                     IN const syndrome_t *syndrome,
+                     IN const compressed_idx_d_t *wlist,
+                     IN const rotate_plan_t *rot,
+                     IN const uint8_t        threshold,
+                     IN const decode_ctx *ctx)
+{
+  DEFER_CLEANUP(syndrome_t rotated_syndrome = {0}, syndrome_cleanup);
+  DEFER_CLEANUP(upc_joint_t upc, upc_joint_cleanup);
+  DEFER_CLEANUP(upc_joint_batch_t batch, upc_joint_batch_cleanup);
+
+  // UPC must start from zero at every iteration. The qwords of the batch
+  // above (N0 * R_QWORDS) are never written, see upc_bit_slice_tiled.
+  bike_memset(&upc, 0, sizeof(upc));
+  bike_memset(&batch, 0, sizeof(batch));
+
+  for(size_t j = 0; j < D; j += UPC_BATCH) {
+    const size_t count = ((D - j) < UPC_BATCH) ? (D - j) : UPC_BATCH;
+
+    for(size_t b = 0; b < count; b++) {
+      for(size_t i = 0; i < N0; i++) {
+        rotate_right_idx(&rotated_syndrome, syndrome, &wlist[i],
+                         half_rot(rot, i), j + b, ctx);
+        bike_memcpy(&batch.rotated[b][i * R_QWORDS], rotated_syndrome.qw,
+                    R_QWORDS * sizeof(uint64_t));
+      }
+    }
+
+    ctx->bit_sliced_adder_tiled(upc.slice[0], batch.rotated[0], count,
+                                UPC_JOINT_QWORDS);
+  }
+
+  // See upc_bit_slice_ge
+  const uint8_t *last_slice = (const uint8_t *)upc.slice[SLICES - 1];
+
+  ctx->bit_slice_full_subtract(upc.slice[0], threshold, UPC_JOINT_QWORDS);
+  for(size_t i = 0; i < N0; i++) {
+    upc_ge(&ge_thr->val[i], &last_slice[i * R_QWORDS * sizeof(uint64_t)]);
+  }
+
+  if(ge_thr_delta == NULL) {
+    return;
+  }
+
+  ctx->bit_slice_add_const(upc.slice[0], DELTA, UPC_JOINT_QWORDS);
+  for(size_t i = 0; i < N0; i++) {
+    upc_ge(&ge_thr_delta->val[i], &last_slice[i * R_QWORDS * sizeof(uint64_t)]);
+  }
+}
+
+// Update the errors vector (e) and the black and gray errors vectors of
+// the half i according to the positions whose UPC is at least the threshold
+// (ge_thr), and at least the threshold minus DELTA (ge_thr_delta).
+_INLINE_ void update_err1_half(OUT e_t *e,
+                               OUT e_t *black_e,
+                               OUT e_t *gray_e,
+                               IN const pad_r_t *ge_thr,
+                               IN const pad_r_t *ge_thr_delta,
+                               IN const uint32_t i)
+{
+  // The errors values are stored in the black array and xored with the
+  // errors Of the previous iteration.
+  for(size_t j = 0; j < R_BYTES; j++) {
+    black_e->val[i].raw[j] = ge_thr->val.raw[j];
+    e->val[i].raw[j] ^= ge_thr->val.raw[j];
+  }
+
+  // Ensure that the padding bits (upper bits of the last byte) are zero so
+  // they will not be included in the multiplication and in the hash function.
+  e->val[i].raw[R_BYTES - 1] &= LAST_R_BYTE_MASK;
+
+  // Update the gray list with the relevant bits that are not
+  // set in the black list.
+  for(size_t j = 0; j < R_BYTES; j++) {
+    gray_e->val[i].raw[j] =
+      (~(black_e->val[i].raw[j])) & ge_thr_delta->val.raw[j];
+  }
+}
+
 // Calculate the Unsatisfied Parity Checks (UPCs) and update the errors
 // vector (e) accordingly. In addition, update the black and gray errors vector
-// with the relevant values.
+// with the relevant values. Only the half args->i of the vectors is updated.
+static void find_err1_half(void *arg)
+{
+  const find_err_args_t *args = (const find_err_args_t *)arg;
+  const decode_ctx *     ctx  = args->ctx;
+  const uint32_t         i    = args->i;
+
+  DEFER_CLEANUP(pad_r_t ge_thr = {0}, pad_r_cleanup);
+  DEFER_CLEANUP(pad_r_t ge_thr_delta = {0}, pad_r_cleanup);
+
+  // 1) Find the positions whose UPC is at least the threshold,
+  //    and at least the threshold minus DELTA.
+  ctx->count_upc(&ge_thr, &ge_thr_delta, args->syndrome, &args->wlist[i],
+                 half_rot(args->rot, i), args->threshold, ctx);
+
+  // 2) Update the errors, black and gray errors vectors.
+  update_err1_half(args->e, args->black_e, args->gray_e, &ge_thr,
+                   &ge_thr_delta, i);
+}
+
 _INLINE_ void find_err1(OUT e_t *e,
                         OUT e_t *black_e,
                         OUT e_t *gray_e,
                         IN const syndrome_t *          syndrome,
                         IN const compressed_idx_d_ar_t wlist,
+                        IN const rotate_plan_t *       rot,
                         IN const uint8_t               threshold,
                         IN const decode_ctx *ctx)
 {
-  // This function uses the bit-slice-adder methodology of [5]:
-  DEFER_CLEANUP(syndrome_t rotated_syndrome = {0}, syndrome_cleanup);
-  DEFER_CLEANUP(upc_t upc, upc_cleanup);
-
-  for(uint32_t i = 0; i < N0; i++) {
-    // UPC must start from zero at every iteration
-    bike_memset(&upc, 0, sizeof(upc));
+  // Count the UPCs of both halves at once if the UPC engine supports it
+  if(ctx->count_upc_joint != NULL) {
+    DEFER_CLEANUP(pad_e_t ge_thr = {0}, pad_e_cleanup);
+    DEFER_CLEANUP(pad_e_t ge_thr_delta = {0}, pad_e_cleanup);
 
-    // 1) Right-rotate the syndrome for every secret key set bit index
-    //    Then slice-add it to the UPC array.
-    for(size_t j = 0; j < D; j++) {
-      ctx->rotate_right(&rotated_syndrome, syndrome, wlist[i].val[j]);
-      ctx->bit_sliced_adder(&upc, &rotated_syndrome, LOG2_MSB(j + 1));
-    }
+    ctx->count_upc_joint(&ge_thr, &ge_thr_delta, syndrome, wlist, rot,
+                         threshold, ctx);
 
-    // 2) Subtract the threshold from the UPC counters
-    ctx->bit_slice_full_subtract(&upc, threshold);
-
-    // 3) Update the errors and the black errors vectors.
-    //    The last slice of the UPC array holds the MSB of the accumulated values
-    //    minus the threshold. Every zero bit indicates a potential error bit.
-    //    The errors values are stored in the black array and xored with the
-    //    errors Of the previous iteration.
-    const r_t *last_slice = &(upc.slice[SLICES - 1].u.r.val);
-    for(size_t j = 0; j < R_BYTES; j++) {
-      const uint8_t sum_msb  = (~last_slice->raw[j]);
-      black_e->val[i].raw[j] = sum_msb;
-      e->val[i].raw[j] ^= sum_msb;
+    for(uint32_t i = 0; i < N0; i++) {
+      update_err1_half(e, black_e, gray_e, &ge_thr.val[i],
+                       &ge_thr_delta.val[i], i);
     }
+    return;
+  }
 
-    // Ensure that the padding bits (upper bits of the last byte) are zero so
-    // they will not be included in the multiplication and in the hash function.
-    e->val[i].raw[R_BYTES - 1] &= LAST_R_BYTE_MASK;
+  const find_err_args_t args = {e,     black_e, gray_e,    NULL, NULL, syndrome,
+                                wlist, rot,     threshold, ctx,  0};
 
-    // 4) Calculate the gray error array by adding "DELTA" to the UPC array.
-    //    For that we reuse the rotated_syndrome variable setting it to all "1".
-    for(size_t l = 0; l < DELTA; l++) {
-      bike_memset((uint8_t *)rotated_syndrome.qw, 0xff, R_BYTES);
-      ctx->bit_sliced_adder(&upc, &rotated_syndrome, SLICES);
-    }
+  run_halves(find_err1_half, &args);
+}
 
-    // 5) Update the gray list with the relevant bits that are not
-    //    set in the black list.
-    for(size_t j = 0; j < R_BYTES; j++) {
-      const uint8_t sum_msb = (~last_slice->raw[j]);
-      gray_e->val[i].raw[j] = (~(black_e->val[i].raw[j])) & sum_msb;
-    }
+// Update the errors vector (e) of the half i according to the positions
+// whose UPC is at least the threshold (ge_thr) and to pos_e.
+_INLINE_ void update_err2_half(OUT e_t *e,
+                               IN const e_t *pos_e,
+                               IN const pad_r_t *ge_thr,
+                               IN const uint32_t i)
+{
+  for(size_t j = 0; j < R_BYTES; j++) {
+    e->val[i].raw[j] ^= (pos_e->val[i].raw[j] & ge_thr->val.raw[j]);
   }
+
+  // Ensure that the padding bits (upper bits of the last byte) are zero, so
+  // they are not included in the multiplication, and in the hash function.
+  e->val[i].raw[R_BYTES - 1] &= LAST_R_BYTE_MASK;
 }
 
 // Recalculate the UPCs and update the errors vector (e) according to it
-// and to the black/gray vectors.
+// and to the black/gray vectors (pos_e). Only the half args->i of the
+// vectors is updated.
+static void find_err2_half(void *arg)
+{
+  const find_err_args_t *args = (const find_err_args_t *)arg;
+  const decode_ctx *     ctx  = args->ctx;
+  const uint32_t         i    = args->i;
+
+  DEFER_CLEANUP(pad_r_t ge_thr = {0}, pad_r_cleanup);
+
+  // 1) Find the positions whose UPC is at least the threshold
+  ctx->count_upc(&ge_thr, NULL, args->syndrome, &args->wlist[i],
+                 half_rot(args->rot, i), args->threshold, ctx);
+
+  // 2) Update the errors vector.
+  update_err2_half(args->e, args->pos_e, &ge_thr, i);
+}
+
 _INLINE_ void find_err2(OUT e_t *e,
                         IN e_t * pos_e,
                         IN const syndrome_t *          syndrome,
                         IN const compressed_idx_d_ar_t wlist,
+                        IN const rotate_plan_t *       rot,
                         IN const uint8_t               threshold,
                         IN const decode_ctx *ctx)
 {
-  DEFER_CLEANUP(syndrome_t rotated_syndrome = {0}, syndrome_cleanup);
-  DEFER_CLEANUP(upc_t upc, upc_cleanup);
+  // Count the UPCs of both halves at once if the UPC engine supports it
+  if(ctx->count_upc_joint != NULL) {
+    DEFER_CLEANUP(pad_e_t ge_thr = {0}, pad_e_cleanup);
 
-  for(uint32_t i = 0; i < N0; i++) {
-    // UPC must start from zero at every iteration
-    bike_memset(&upc, 0, sizeof(upc));
+    ctx->count_upc_joint(&ge_thr, NULL, syndrome, wlist, rot, threshold, ctx);
 
-    // 1) Right-rotate the syndrome, for every index of a set bit in the secret
-    // key. Then slice-add it to the UPC array.
-    for(size_t j = 0; j < D; j++) {
-      ctx->rotate_right(&rotated_syndrome, syndrome, wlist[i].val[j]);
-      ctx->bit_sliced_adder(&upc, &rotated_syndrome, LOG2_MSB(j + 1));
+    for(uint32_t i = 0; i < N0; i++) {
+      update_err2_half(e, pos_e, &ge_thr.val[i], i);
     }
+    return;
+  }
+
+  const find_err_args_t args = {e,     NULL, NULL,      pos_e, NULL, syndrome,
+                                wlist, rot,  threshold, ctx,   0};
+
+  run_halves(find_err2_half, &args);
+}
+
+// Update the errors vector (e) and the time to live of its flips (ttl) of the
+// half i according to the positions whose UPC is at least the threshold
+// (ge_thr), and at least the threshold plus DELTA (ge_thr_hi):
+//   - the positions of ge_thr are flipped, the ones that are set get the time
+//     to live of the decoder, and the ones that are cleared get zero;
+//   - the time to live of the other positions is decremented, and the ones
+//     that expire (reach zero) are flipped back.
+// The time to live is bit-sliced, so this is done with bitwise operations.
+_INLINE_ void update_err_backflip_half(OUT e_t *e,
+                                       IN OUT ttl_t *ttl,
+                                       IN const pad_r_t *ge_thr_hi,
+                                       IN const pad_r_t *ge_thr,
+                                       IN const decoder_t *decoder,
+                                       IN const uint8_t    active,
+                                       IN const uint32_t   i)
+{
+  const uint8_t short0 = 0 - (decoder->ttl_short & 0x1);
+  const uint8_t short1 = 0 - ((decoder->ttl_short >> 1) & 0x1);
+  const uint8_t long0  = 0 - (decoder->ttl_long & 0x1);
+  const uint8_t long1  = 0 - ((decoder->ttl_long >> 1) & 0x1);
+
+  uint8_t *t0 = ttl->bit[0].val[i].raw;
+  uint8_t *t1 = ttl->bit[1].val[i].raw;
+
+  for(size_t j = 0; j < R_BYTES; j++) {
+    const uint8_t flip = ge_thr->val.raw[j];
+    const uint8_t hi   = ge_thr_hi->val.raw[j];
+    const uint8_t set  = flip & (~e->val[i].raw[j]);
+
+    // The time to live of the positions that are not flipped is at least
+    // one only where e is set, and it expires if it is exactly one.
+    const uint8_t expired = t0[j] & (~t1[j]) & (~flip) & active;
+    e->val[i].raw[j] ^= flip ^ expired;
+
+    // Decrement (t1, t0) where the positions are not flipped
+    const uint8_t dec0 = (~flip) & t1[j] & (~t0[j]);
+    const uint8_t dec1 = (~flip) & t1[j] & t0[j];
+
+    t0[j] = (set & ((hi & long0) | ((~hi) & short0))) | dec0;
+    t1[j] = (set & ((hi & long1) | ((~hi) & short1))) | dec1;
+  }
+
+  // Ensure that the padding bits (upper bits of the last byte) are zero, so
+  // they are not included in the multiplication, and in the hash function.
+  e->val[i].raw[R_BYTES - 1] &= LAST_R_BYTE_MASK;
+}
+
+// The flips do not expire once the syndrome is zero (the errors vector is
+// decoded), since a constant-time decoder does not stop there.
+// Returns 0 if the weight of the syndrome is zero, and 0xff otherwise.
+_INLINE_ uint8_t backflip_active(IN const syndrome_t *syndrome)
+{
+  const uint64_t weight = r_bits_vector_weight((const r_t *)syndrome->qw);
+  return (uint8_t)(~secure_cmpeq64_mask(weight, 0));
+}
+
+// A Backflip iteration of the half args->i of the vectors,
+// see update_err_backflip_half.
+static void find_err_backflip_half(void *arg)
+{
+  const find_err_args_t *args = (const find_err_args_t *)arg;
+  const decode_ctx *     ctx  = args->ctx;
+  const uint32_t         i    = args->i;
 
-    // 2) Subtract the threshold from the UPC counters
-    ctx->bit_slice_full_subtract(&upc, threshold);
+  DEFER_CLEANUP(pad_r_t ge_thr_hi = {0}, pad_r_cleanup);
+  DEFER_CLEANUP(pad_r_t ge_thr = {0}, pad_r_cleanup);
+
+  // 1) Find the positions whose UPC is at least the threshold plus DELTA,
+  //    and at least the threshold.
+  ctx->count_upc(&ge_thr_hi, &ge_thr, args->syndrome, &args->wlist[i],
+                 half_rot(args->rot, i), args->threshold + DELTA, ctx);
+
+  // 2) Update the errors vector and the time to live of its flips.
+  update_err_backflip_half(args->e, args->ttl, &ge_thr_hi, &ge_thr,
+                           ctx->decoder, backflip_active(args->syndrome), i);
+}
 
-    // 3) Update the errors vector.
-    //    The last slice of the UPC array holds the MSB of the accumulated values
-    //    minus the threshold. Every zero bit indicates a potential error bit.
-    const r_t *last_slice = &(upc.slice[SLICES - 1].u.r.val);
-    for(size_t j = 0; j < R_BYTES; j++) {
-      const uint8_t sum_msb = (~last_slice->raw[j]);
-      e->val[i].raw[j] ^= (pos_e->val[i].raw[j] & sum_msb);
+_INLINE_ void find_err_backflip(OUT e_t *e,
+                                IN OUT ttl_t *ttl,
+                                IN const syndrome_t *          syndrome,
+                                IN const compressed_idx_d_ar_t wlist,
+                                IN const rotate_plan_t *       rot,
+                                IN const uint8_t               threshold,
+                                IN const decode_ctx *ctx)
+{
+  // Count the UPCs of both halves at once if the UPC engine supports it
+  if(ctx->count_upc_joint != NULL) {
+    DEFER_CLEANUP(pad_e_t ge_thr_hi = {0}, pad_e_cleanup);
+    DEFER_CLEANUP(pad_e_t ge_thr = {0}, pad_e_cleanup);
+
+    ctx->count_upc_joint(&ge_thr_hi, &ge_thr, syndrome, wlist, rot,
+                         threshold + DELTA, ctx);
+
+    const uint8_t active = backflip_active(syndrome);
+    for(uint32_t i = 0; i < N0; i++) {
+      update_err_backflip_half(e, ttl, &ge_thr_hi.val[i], &ge_thr.val[i],
+                               ctx->decoder, active, i);
     }
+    return;
+  }
+
+  const find_err_args_t args = {e,     NULL, NULL,      NULL, ttl, syndrome,
+                                wlist, rot,  threshold, ctx,  0};
+
+  run_halves(find_err_backflip_half, &args);
+}
 
-    // Ensure that the padding bits (upper bits of the last byte) are zero, so
-    // they are not included in the multiplication, and in the hash function.
-    e->val[i].raw[R_BYTES - 1] &= LAST_R_BYTE_MASK;
+// Compute the rotation plans of all the indices of the secret key
+// with the rotate_plan function of ctx.
+_INLINE_ void decode_plan_compute(OUT decode_plan_t *plan,
+                                  IN const sk_t *sk,
+                                  IN const decode_ctx *ctx)
+{
+  for(size_t i = 0; i < N0; i++) {
+    for(size_t j = 0; j < D; j++) {
+      ctx->rotate_plan(&plan->rot[i][j], sk->wlist[i].val[j]);
+    }
   }
+
+  plan->block_bits = ctx->rotate_block_bits;
 }
 
-void decode(OUT e_t *e, IN const ct_t *ct, IN const sk_t *sk)
+void decode_plan_init(OUT decode_plan_t *plan, IN const sk_t *sk)
 {
-  // Initialize the decode methods struct
   decode_ctx ctx;
   decode_ctx_init(&ctx);
 
+  decode_plan_compute(plan, sk, &ctx);
+}
+
+// Record the weight of the syndrome in the trace of ctx (if it is set)
+_INLINE_ void trace_weight(IN const decode_ctx *ctx,
+                           IN const uint32_t    iter,
+                           IN const syndrome_t *s)
+{
+  if(ctx->trace != NULL) {
+    ctx->trace->weight[iter] = r_bits_vector_weight((const r_t *)s->qw);
+  }
+}
+
+// Decode with the rotation plans rot of the indices of the secret key,
+// computed by ctx->rotate_plan.
+_INLINE_ void decode_rot(OUT e_t *e,
+                         IN const ct_t *ct,
+                         IN const sk_t *sk,
+                         IN const rotate_plan_t *rot,
+                         IN const decode_ctx *ctx)
+{
   DEFER_CLEANUP(e_t black_e = {0}, e_cleanup);
   DEFER_CLEANUP(e_t gray_e = {0}, e_cleanup);
+  DEFER_CLEANUP(ttl_t ttl = {0}, ttl_cleanup);
 
   DEFER_CLEANUP(pad_r_t c0 = {0}, pad_r_cleanup);
   DEFER_CLEANUP(pad_r_t h0 = {0}, pad_r_cleanup);
-  pad_r_t pk = {0};
+  DEFER_CLEANUP(pad_r_t h1 = {0}, pad_r_cleanup);
+  DEFER_CLEANUP(pad_r_t c0h0 = {0}, pad_r_cleanup);
 
-  // Pad ciphertext (c0), secret key (h0), and public key (h)
+  // Pad ciphertext (c0), and secret key (h0, h1)
   c0.val = ct->c0;
   h0.val = sk->bin[0];
-  pk.val = sk->pk;
+  h1.val = sk->bin[1];
 
   DEFER_CLEANUP(syndrome_t s = {0}, syndrome_cleanup);
   DMSG("  Computing s.\n");
-  compute_syndrome(&s, &c0, &h0, &ctx);
-  ctx.dup(&s);
+  compute_syndrome(&s, &c0h0, &c0, &h0, ctx);
+  ctx->dup(&s);
 
   // Reset (init) the error because it is xored in the find_err functions.
   bike_memset(e, 0, sizeof(*e));
 
-  for(uint32_t iter = 0; iter < MAX_IT; iter++) {
+  // The schedule of the decoder depends only on public parameters
+  const decoder_t *decoder = ctx->decoder;
+
+  for(uint32_t iter = 0; iter < decoder->max_it; iter++) {
     const uint8_t threshold = get_threshold(&s);
+    trace_weight(ctx, iter, &s);
 
     DMSG("    Iteration: %d\n", iter);
     DMSG("    Weight of e: %lu\n",
          r_bits_vector_weight(&e->val[0]) + r_bits_vector_weight(&e->val[1]));
     DMSG("    Weight of syndrome: %lu\n", r_bits_vector_weight((r_t *)s.qw));
 
-    find_err1(e, &black_e, &gray_e, &s, sk->wlist, threshold, &ctx);
-    recompute_syndrome(&s, &c0, &h0, &pk, e, &ctx);
-#if defined(BGF_DECODER)
-    if(iter >= 1) {
+    if((iter >= decoder->bg_it) && (decoder->ttl_short != 0)) {
+      find_err_backflip(e, &ttl, &s, sk->wlist, rot, threshold, ctx);
+      recompute_syndrome(&s, &c0h0, &h0, &h1, e, ctx);
+      continue;
+    }
+
+    find_err1(e, &black_e, &gray_e, &s, sk->wlist, rot, threshold, ctx);
+    recompute_syndrome(&s, &c0h0, &h0, &h1, e, ctx);
+    if(iter >= decoder->bg_it) {
       continue;
     }
-#endif
     DMSG("    Weight of e: %lu\n",
          r_bits_vector_weight(&e->val[0]) + r_bits_vector_weight(&e->val[1]));
     DMSG("    Weight of syndrome: %lu\n", r_bits_vector_weight((r_t *)s.qw));
 
-    find_err2(e, &black_e, &s, sk->wlist, ((D + 1) / 2) + 1, &ctx);
-    recompute_syndrome(&s, &c0, &h0, &pk, e, &ctx);
+    find_err2(e, &black_e, &s, sk->wlist, rot, decoder->bg_threshold, ctx);
+    recompute_syndrome(&s, &c0h0, &h0, &h1, e, ctx);
 
     DMSG("    Weight of e: %lu\n",
          r_bits_vector_weight(&e->val[0]) + r_bits_vector_weight(&e->val[1]));
     DMSG("    Weight of syndrome: %lu\n", r_bits_vector_weight((r_t *)s.qw));
 
-    find_err2(e, &gray_e, &s, sk->wlist, ((D + 1) / 2) + 1, &ctx);
-    recompute_syndrome(&s, &c0, &h0, &pk, e, &ctx);
+    find_err2(e, &gray_e, &s, sk->wlist, rot, decoder->bg_threshold, ctx);
+    recompute_syndrome(&s, &c0h0, &h0, &h1, e, ctx);
+  }
+
+  trace_weight(ctx, decoder->max_it, &s);
+}
+
+void decode_with_ctx(OUT e_t *e,
+                     IN const ct_t *ct,
+                     IN const sk_t *sk,
+                     IN const decode_ctx *ctx)
+{
+  // Every index of the secret key is used for one rotation in every call to
+  // the find_err functions, so their rotation plans are computed once.
+  DEFER_CLEANUP(decode_plan_t plan, decode_plan_cleanup);
+  decode_plan_compute(&plan, sk, ctx);
+
+  decode_rot(e, ct, sk, &plan.rot[0][0], ctx);
+}
+
+void decode(OUT e_t *e, IN const ct_t *ct, IN const sk_t *sk)
+{
+  // Initialize the decode methods struct
+  decode_ctx ctx;
+  decode_ctx_init(&ctx);
+
+  decode_with_ctx(e, ct, sk, &ctx);
+}
+
+void decode_with_plan(OUT e_t *e,
+                      IN const ct_t *ct,
+                      IN const sk_t *sk,
+                      IN const decode_plan_t *plan)
+{
+  decode_ctx ctx;
+  decode_ctx_init(&ctx);
+
+  if((plan == NULL) || (plan->block_bits != ctx.rotate_block_bits)) {
+    decode(e, ct, sk);
+    return;
+  }
+
+  decode_rot(e, ct, sk, &plan->rot[0][0], &ctx);
+}
+
+// The decoding state of a single ciphertext in decode_multi
+typedef struct decode_multi_state_s {
+  e_t        black_e;
+  e_t        gray_e;
+  pad_r_t    c0h0;
+  pad_r_t    ge_thr;
+  pad_r_t    ge_thr_delta;
+  syndrome_t s;
+  uint8_t    threshold;
+} decode_multi_state_t;
+
+// The working memory of decode_group. It is too large for the stacks of many
+// threads (about 2 MB at Level 5), so decode_multi allocates it on the heap.
+typedef struct decode_multi_ws_s {
+  upc_multi_t          upc;
+  upc_multi_batch_t    batch;
+  decode_multi_state_t st[DECODE_MULTI_MAX];
+} ALIGN(ALIGN_BYTES) decode_multi_ws_t;
+
+// Count the UPCs of one half of the secret key (given by the rotation plans
+// of its indices, rot) for the n syndromes
+// of ws->st, and set st[k].ge_thr (and st[k].ge_thr_delta if with_delta is set)
+// as in upc_bit_slice. The counters of the syndromes are held side by side
+// in the multi UPC array, and every batch of rotations is added to all of
+// them with one call to the tiled adders.
+// Instead of subtracting the (different) thresholds at the end, the counters
+// of every syndrome start from minus its threshold (modulo 2^SLICES).
+_INLINE_ void upc_multi_tiled(IN OUT decode_multi_ws_t *ws,
+                              IN const size_t           n,
+                              IN const rotate_plan_t *  rot,
+                              IN const uint32_t         with_delta,
+                              IN const decode_ctx *ctx)
+{
+  DEFER_CLEANUP(syndrome_t rotated_syndrome = {0}, syndrome_cleanup);
+
+  // Only the first n * UPC_SLICE_QWORDS qwords of every row of the UPC array
+  // and of the batch are used, so only they are initialized and cleaned.
+  decode_multi_state_t *st    = ws->st;
+  upc_multi_t *         upc   = &ws->upc;
+  upc_multi_batch_t *   batch = &ws->batch;
+
+  // The length of the rows of the UPC array and of the batch
+  const size_t len = n * UPC_SLICE_QWORDS;
+
+  // The qwords of the batch above R_QWORDS of every syndrome are never
+  // written, see upc_bit_slice_tiled.
+  bike_memset(batch->qw, 0, UPC_BATCH * len * sizeof(uint64_t));
+
+  for(size_t k = 0; k < n; k++) {
+    const uint32_t neg_thr = 0 - (uint32_t)st[k].threshold;
+    for(size_t j = 0; j < SLICES; j++) {
+      const uint8_t mask = 0 - (uint8_t)((neg_thr >> j) & 0x1);
+      bike_memset(&upc->qw[(j * len) + (k * UPC_SLICE_QWORDS)], mask,
+                  UPC_SLICE_QWORDS * sizeof(uint64_t));
+    }
+  }
+
+  for(size_t j = 0; j < D; j += UPC_BATCH) {
+    const size_t count = ((D - j) < UPC_BATCH) ? (D - j) : UPC_BATCH;
+
+    for(size_t b = 0; b < count; b++) {
+      for(size_t k = 0; k < n; k++) {
+        ctx->rotate_right_plan(&rotated_syndrome, &st[k].s, &rot[j + b]);
+        bike_memcpy(&batch->qw[(b * len) + (k * UPC_SLICE_QWORDS)],
+                    rotated_syndrome.qw, R_QWORDS * sizeof(uint64_t));
+      }
+    }
+
+    ctx->bit_sliced_adder_tiled(upc->qw, batch->qw, count, len);
+  }
+
+  // See upc_bit_slice_ge
+  const uint8_t *last_slice = (const uint8_t *)&upc->qw[(SLICES - 1) * len];
+  for(size_t k = 0; k < n; k++) {
+    upc_ge(&st[k].ge_thr, &last_slice[k * UPC_SLICE_QWORDS * sizeof(uint64_t)]);
+  }
+
+  if(with_delta) {
+    ctx->bit_slice_add_const(upc->qw, DELTA, len);
+    for(size_t k = 0; k < n; k++) {
+      upc_ge(&st[k].ge_thr_delta,
+             &last_slice[k * UPC_SLICE_QWORDS * sizeof(uint64_t)]);
+    }
+  }
+
+  secure_clean((uint8_t *)upc->qw, SLICES * len * sizeof(uint64_t));
+  secure_clean((uint8_t *)batch->qw, UPC_BATCH * len * sizeof(uint64_t));
+}
+
+// See find_err2, pos_e is the gray errors vector if gray is set,
+// and the black errors vector otherwise.
+_INLINE_ void find_err2_multi(OUT e_t *e,
+                              IN OUT decode_multi_ws_t *ws,
+                              IN const size_t           n,
+                              IN const uint32_t         gray,
+                              IN const rotate_plan_t *  rot,
+                              IN const decode_ctx *ctx)
+{
+  decode_multi_state_t *st = ws->st;
+
+  for(size_t k = 0; k < n; k++) {
+    st[k].threshold = ctx->decoder->bg_threshold;
+  }
+
+  for(uint32_t i = 0; i < N0; i++) {
+    upc_multi_tiled(ws, n, half_rot(rot, i), 0, ctx);
+
+    for(size_t k = 0; k < n; k++) {
+      const e_t *pos_e = gray ? &st[k].gray_e : &st[k].black_e;
+      update_err2_half(&e[k], pos_e, &st[k].ge_thr, i);
+    }
   }
 }
+
+// Decode n <= DECODE_MULTI_MAX ciphertexts in lock-step, see decode.
+_INLINE_ void decode_group(OUT e_t *e,
+                           IN const ct_t *ct,
+                           IN const size_t n,
+                           IN const pad_r_t *h0,
+                           IN const pad_r_t *h1,
+                           IN const rotate_plan_t *rot,
+                           IN OUT decode_multi_ws_t *ws,
+                           IN const decode_ctx *ctx)
+{
+  decode_multi_state_t *st = ws->st;
+  bike_memset(st, 0, sizeof(ws->st));
+
+  DEFER_CLEANUP(pad_r_t c0 = {0}, pad_r_cleanup);
+
+  for(size_t k = 0; k < n; k++) {
+    c0.val = ct[k].c0;
+    compute_syndrome(&st[k].s, &st[k].c0h0, &c0, h0, ctx);
+
+    // Reset (init) the error because it is xored in the find_err functions.
+    bike_memset(&e[k], 0, sizeof(e[k]));
+  }
+
+  for(uint32_t iter = 0; iter < ctx->decoder->max_it; iter++) {
+    // See find_err1
+    for(size_t k = 0; k < n; k++) {
+      st[k].threshold = get_threshold(&st[k].s);
+    }
+
+    for(uint32_t i = 0; i < N0; i++) {
+      upc_multi_tiled(ws, n, half_rot(rot, i), 1, ctx);
+
+      for(size_t k = 0; k < n; k++) {
+        update_err1_half(&e[k], &st[k].black_e, &st[k].gray_e, &st[k].ge_thr,
+                         &st[k].ge_thr_delta, i);
+      }
+    }
+
+    for(size_t k = 0; k < n; k++) {
+      recompute_syndrome(&st[k].s, &st[k].c0h0, h0, h1, &e[k], ctx);
+    }
+    if(iter >= ctx->decoder->bg_it) {
+      continue;
+    }
+
+    find_err2_multi(e, ws, n, 0, rot, ctx);
+    for(size_t k = 0; k < n; k++) {
+      recompute_syndrome(&st[k].s, &st[k].c0h0, h0, h1, &e[k], ctx);
+    }
+
+    find_err2_multi(e, ws, n, 1, rot, ctx);
+    for(size_t k = 0; k < n; k++) {
+      recompute_syndrome(&st[k].s, &st[k].c0h0, h0, h1, &e[k], ctx);
+    }
+  }
+
+  secure_clean((uint8_t *)st, sizeof(ws->st));
+}
+
+void decode_multi(OUT e_t *e,
+                  IN const ct_t *ct,
+                  IN const size_t n,
+                  IN const sk_t *sk)
+{
+  // Initialize the decode methods struct
+  decode_ctx ctx;
+  decode_ctx_init(&ctx);
+
+  DEFER_CLEANUP(pad_r_t h0 = {0}, pad_r_cleanup);
+  DEFER_CLEANUP(pad_r_t h1 = {0}, pad_r_cleanup);
+
+  // The rotations of the indices of the secret key are computed once for all
+  // the ciphertexts.
+  DEFER_CLEANUP(decode_plan_t plan, decode_plan_cleanup);
+  decode_plan_compute(&plan, sk, &ctx);
+
+  // The working memory of the groups, aligned by hand since malloc
+  // only guarantees the alignment of the basic types.
+  uint8_t *mem = NULL;
+  if((n != 0) && (ctx.decoder->ttl_short == 0)) {
+    mem = malloc(sizeof(decode_multi_ws_t) + ALIGN_BYTES);
+  }
+
+  // The lock-step decoding has no time to live of the flips, so the
+  // ciphertexts are decoded one at a time with Backflip (and when the
+  // working memory cannot be allocated).
+  if(mem == NULL) {
+    for(size_t k = 0; k < n; k++) {
+      decode_rot(&e[k], &ct[k], sk, &plan.rot[0][0], &ctx);
+    }
+    return;
+  }
+
+  decode_multi_ws_t *ws =
+    (decode_multi_ws_t *)(mem + ALIGN_BYTES - ((uintptr_t)mem % ALIGN_BYTES));
+
+  h0.val = sk->bin[0];
+  h1.val = sk->bin[1];
+
+  for(size_t g = 0; g < n; g += DECODE_MULTI_MAX) {
+    const size_t count =
+      ((n - g) < DECODE_MULTI_MAX) ? (n - g) : DECODE_MULTI_MAX;
+
+    decode_group(&e[g], &ct[g], count, &h0, &h1, &plan.rot[0][0], ws, &ctx);
+  }
+
+  secure_clean((uint8_t *)ws, sizeof(*ws));
+  free(mem);
+}
@@ -19,6 +19,7 @@
  */
 
 #include "decode.h"
+#include "cleanup.h"
 #include "decode_internal.h"
 #include "utilities.h"
 
@@ -27,8 +28,29 @@
 
 #define R_YMM_HALF_LOG2 UPTOPOW2(R_YMM / 2)
 
-_INLINE_ void
-rotate256_big(OUT syndrome_t *out, IN const syndrome_t *in, IN size_t ymm_num)
+bike_static_assert(R_YMM_HALF_LOG2 < (1 << ROTATE_PLAN_LEVELS),
+                   rotate_plan_levels_err);
+
+// Compute the blend masks of rotate256_big and the count of rotate256_small
+// for rotating by bitscount.
+void rotate_plan_avx2(OUT rotate_plan_t *p, IN const uint32_t bitscount)
+{
+  uint32_t ymm_num = bitscount / BITS_IN_YMM;
+  size_t   l       = 0;
+
+  for(uint32_t idx = R_YMM_HALF_LOG2; idx >= 1; idx >>= 1, l++) {
+    // Convert 32 bit mask to 64 bit mask
+    const uint64_t mask = ((uint32_t)secure_l32_mask(ymm_num, idx) + 1U) - 1ULL;
+    ymm_num             = ymm_num - (idx & mask);
+    p->mask[l]          = mask;
+  }
+
+  p->small = bitscount % BITS_IN_YMM;
+}
+
+_INLINE_ void rotate256_big(OUT syndrome_t *out,
+                            IN const syndrome_t *in,
+                            IN const uint64_t *masks)
 {
   // For preventing overflows (comparison in bytes)
   bike_static_assert(sizeof(*out) >
@@ -37,10 +59,9 @@ rotate256_big(OUT syndrome_t *out, IN const syndrome_t *in, IN size_t ymm_num)
 
   *out = *in;
 
-  for(uint32_t idx = R_YMM_HALF_LOG2; idx >= 1; idx >>= 1) {
-    const uint8_t mask       = secure_l32_mask(ymm_num, idx);
-    const __m256i blend_mask = SET1_I8(mask);
-    ymm_num                  = ymm_num - (idx & mask);
+  size_t l = 0;
+  for(uint32_t idx = R_YMM_HALF_LOG2; idx >= 1; idx >>= 1, l++) {
+    const __m256i blend_mask = SET1_I64(masks[l]);
 
     for(size_t i = 0; i < (R_YMM + idx); i++) {
       __m256i a = LOAD(&out->qw[4 * (i + idx)]);
@@ -93,14 +114,24 @@ rotate256_small(OUT syndrome_t *out, IN const syndrome_t *in, size_t count)
   }
 }
 
+void rotate_right_plan_avx2(OUT syndrome_t *out,
+                            IN const syndrome_t *in,
+                            IN const rotate_plan_t *p)
+{
+  // 1) Rotate in granularity of 256 bits blocks, using YMMs
+  rotate256_big(out, in, p->mask);
+  // 2) Rotate in smaller granularity (less than 256 bits), using YMMs
+  rotate256_small(out, out, p->small);
+}
+
 void rotate_right_avx2(OUT syndrome_t *out,
                        IN const syndrome_t *in,
                        IN const uint32_t    bitscount)
 {
-  // 1) Rotate in granularity of 256 bits blocks, using YMMs
-  rotate256_big(out, in, (bitscount / BITS_IN_YMM));
-  // 2) Rotate in smaller granularity (less than 256 bits), using YMMs
-  rotate256_small(out, out, (bitscount % BITS_IN_YMM));
+  DEFER_CLEANUP(rotate_plan_t p, rotate_plan_cleanup);
+
+  rotate_plan_avx2(&p, bitscount);
+  rotate_right_plan_avx2(out, in, &p);
 }
 
 // Duplicates the first R_BITS of the syndrome three times
@@ -134,34 +165,79 @@ void bit_sliced_adder_avx2(OUT upc_t *upc,
   }
 }
 
-void bit_slice_full_subtract_avx2(OUT upc_t *upc, IN uint8_t val)
+// Add count rotated syndromes to the UPC array,
+// see bit_sliced_adder_tiled_port.
+// The SLICES YMMs of every column are kept in registers.
+void bit_sliced_adder_tiled_avx2(OUT uint64_t *upc,
+                                 IN const uint64_t *rotated,
+                                 IN const size_t    count,
+                                 IN const size_t    qwords_len)
 {
-  // Borrow
-  uint64_t br[R_QWORDS] = {0};
+  for(size_t i = 0; i < qwords_len; i += QWORDS_IN_YMM) {
+    __m256i u[SLICES];
+    for(size_t k = 0; k < SLICES; k++) {
+      u[k] = LOAD(&upc[(k * qwords_len) + i]);
+    }
+
+    for(size_t b = 0; b < count; b++) {
+      __m256i carry = LOAD(&rotated[(b * qwords_len) + i]);
+      for(size_t k = 0; k < SLICES; k++) {
+        const __m256i tmp = u[k] & carry;
+        u[k] ^= carry;
+        carry = tmp;
+      }
+    }
+
+    for(size_t k = 0; k < SLICES; k++) {
+      STORE(&upc[(k * qwords_len) + i], u[k]);
+    }
+  }
+}
 
+// See bit_slice_full_subtract_port
+void bit_slice_full_subtract_avx2(OUT uint64_t *upc,
+                                  IN uint8_t      val,
+                                  IN const size_t qwords_len)
+{
+  __m256i b[SLICES];
   for(size_t j = 0; j < SLICES; j++) {
+    b[j] = SET1_I64(0 - (uint64_t)(val & 0x1));
+    val >>= 1;
+  }
+
+  for(size_t i = 0; i < qwords_len; i += QWORDS_IN_YMM) {
+    // Borrow
+    __m256i br = SET_ZERO;
 
-    const uint64_t lsb_mask = 0 - (val & 0x1);
+    for(size_t j = 0; j < SLICES; j++) {
+      const __m256i a   = LOAD(&upc[(j * qwords_len) + i]);
+      const __m256i tmp = ((~a) & b[j] & (~br)) | (((~a) | b[j]) & br);
+      STORE(&upc[(j * qwords_len) + i], a ^ b[j] ^ br);
+      br = tmp;
+    }
+  }
+}
+
+// See bit_slice_add_const_port
+void bit_slice_add_const_avx2(OUT uint64_t *upc,
+                              IN uint8_t      val,
+                              IN const size_t qwords_len)
+{
+  __m256i b[SLICES];
+  for(size_t j = 0; j < SLICES; j++) {
+    b[j] = SET1_I64(0 - (uint64_t)(val & 0x1));
     val >>= 1;
+  }
 
-    // Perform a - b with c as the input/output carry
-    // br = 0 0 0 0 1 1 1 1
-    // a  = 0 0 1 1 0 0 1 1
-    // b  = 0 1 0 1 0 1 0 1
-    // -------------------
-    // o  = 0 1 1 0 0 1 1 1
-    // c  = 0 1 0 0 1 1 0 1
-    //
-    // o  = a^b^c
-    //            _     __    _ _   _ _     _
-    // br = abc + abc + abc + abc = abc + ((a+b))c
+  for(size_t i = 0; i < qwords_len; i += QWORDS_IN_YMM) {
+    // Carry
+    __m256i c = SET_ZERO;
 
-    for(size_t i = 0; i < R_QWORDS; i++) {
-      const uint64_t a      = upc->slice[j].u.qw[i];
-      const uint64_t b      = lsb_mask;
-      const uint64_t tmp    = ((~a) & b & (~br[i])) | ((((~a) | b) & br[i]));
-      upc->slice[j].u.qw[i] = a ^ b ^ br[i];
-      br[i]                 = tmp;
+    for(size_t j = 0; j < SLICES; j++) {
+      const __m256i a   = LOAD(&upc[(j * qwords_len) + i]);
+      const __m256i tmp = (a & c) | ((a | c) & b[j]);
+      STORE(&upc[(j * qwords_len) + i], a ^ b[j] ^ c);
+      c = tmp;
     }
   }
 }
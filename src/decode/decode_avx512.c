@@ -18,6 +18,7 @@
  */
 
 #include "decode.h"
+#include "cleanup.h"
 #include "decode_internal.h"
 #include "utilities.h"
 
@@ -26,8 +27,29 @@
 
 #define R_ZMM_HALF_LOG2 UPTOPOW2(R_ZMM / 2)
 
-_INLINE_ void
-rotate512_big(OUT syndrome_t *out, IN const syndrome_t *in, size_t zmm_num)
+bike_static_assert(R_ZMM_HALF_LOG2 < (1 << ROTATE_PLAN_LEVELS),
+                   rotate_plan_levels_err);
+
+// Compute the blend masks of rotate512_big and the count of rotate512_small
+// for rotating by bitscount. The plans are also used by rotate_right_vbmi2.
+void rotate_plan_avx512(OUT rotate_plan_t *p, IN const uint32_t bitscount)
+{
+  uint32_t zmm_num = bitscount / BITS_IN_ZMM;
+  size_t   l       = 0;
+
+  for(uint32_t idx = R_ZMM_HALF_LOG2; idx >= 1; idx >>= 1, l++) {
+    // Convert 32 bit mask to 64 bit mask
+    const uint64_t mask = ((uint32_t)secure_l32_mask(zmm_num, idx) + 1U) - 1ULL;
+    zmm_num             = zmm_num - (idx & mask);
+    p->mask[l]          = mask;
+  }
+
+  p->small = bitscount % BITS_IN_ZMM;
+}
+
+_INLINE_ void rotate512_big(OUT syndrome_t *out,
+                            IN const syndrome_t *in,
+                            IN const uint64_t *masks)
 {
   // For preventing overflows (comparison in bytes)
   bike_static_assert(sizeof(*out) >
@@ -35,9 +57,9 @@ rotate512_big(OUT syndrome_t *out, IN const syndrome_t *in, size_t zmm_num)
                      rotr_big_err);
   *out = *in;
 
-  for(uint32_t idx = R_ZMM_HALF_LOG2; idx >= 1; idx >>= 1) {
-    const uint8_t mask = secure_l32_mask(zmm_num, idx);
-    zmm_num            = zmm_num - (idx & mask);
+  size_t l = 0;
+  for(uint32_t idx = R_ZMM_HALF_LOG2; idx >= 1; idx >>= 1, l++) {
+    const uint8_t mask = (uint8_t)masks[l];
 
     for(size_t i = 0; i < (R_ZMM + idx); i++) {
       const __m512i a = LOAD(&out->qw[8 * (i + idx)]);
@@ -87,14 +109,24 @@ rotate512_small(OUT syndrome_t *out, IN const syndrome_t *in, size_t bitscount)
   }
 }
 
+void rotate_right_plan_avx512(OUT syndrome_t *out,
+                              IN const syndrome_t *in,
+                              IN const rotate_plan_t *p)
+{
+  // 1) Rotate in granularity of 512 bits blocks, using ZMMs
+  rotate512_big(out, in, p->mask);
+  // 2) Rotate in smaller granularity (less than 512 bits), using ZMMs
+  rotate512_small(out, out, p->small);
+}
+
 void rotate_right_avx512(OUT syndrome_t *out,
                          IN const syndrome_t *in,
                          IN const uint32_t    bitscount)
 {
-  // 1) Rotate in granularity of 512 bits blocks, using ZMMs
-  rotate512_big(out, in, (bitscount / BITS_IN_ZMM));
-  // 2) Rotate in smaller granularity (less than 512 bits), using ZMMs
-  rotate512_small(out, out, (bitscount % BITS_IN_ZMM));
+  DEFER_CLEANUP(rotate_plan_t p, rotate_plan_cleanup);
+
+  rotate_plan_avx512(&p, bitscount);
+  rotate_right_plan_avx512(out, in, &p);
 }
 
 // Duplicates the first R_BITS of the syndrome three times
@@ -128,34 +160,135 @@ void bit_sliced_adder_avx512(OUT upc_t *upc,
   }
 }
 
-void bit_slice_full_subtract_avx512(OUT upc_t *upc, IN uint8_t val)
+// Add count rotated syndromes to the UPC array,
+// see bit_sliced_adder_tiled_port.
+// The SLICES ZMMs of every column are kept in registers.
+void bit_sliced_adder_tiled_avx512(OUT uint64_t *upc,
+                                   IN const uint64_t *rotated,
+                                   IN const size_t    count,
+                                   IN const size_t    qwords_len)
 {
-  // Borrow
-  uint64_t br[R_QWORDS] = {0};
+  for(size_t i = 0; i < qwords_len; i += QWORDS_IN_ZMM) {
+    __m512i u[SLICES];
+    for(size_t k = 0; k < SLICES; k++) {
+      u[k] = LOAD(&upc[(k * qwords_len) + i]);
+    }
 
-  for(size_t j = 0; j < SLICES; j++) {
+    for(size_t b = 0; b < count; b++) {
+      __m512i carry = LOAD(&rotated[(b * qwords_len) + i]);
+      for(size_t k = 0; k < SLICES; k++) {
+        const __m512i tmp = u[k] & carry;
+        u[k] ^= carry;
+        carry = tmp;
+      }
+    }
 
-    const uint64_t lsb_mask = 0 - (val & 0x1);
+    for(size_t k = 0; k < SLICES; k++) {
+      STORE(&upc[(k * qwords_len) + i], u[k]);
+    }
+  }
+}
+
+// The full subtractor/adder below compute every sum and borrow/carry
+// with a single ternary-logic instruction.
+
+// Truth tables of the ternary-logic instruction for the inputs (a, b, c)
+#define XOR3_TT   (0x96) // a^b^c
+#define MAJ_TT    (0xe8) // ab + ac + bc
+#define BORROW_TT (0x8e) // (~a)b + (~a)c + bc
+
+_INLINE_ void bit_slice_full_op_avx512(OUT uint64_t *upc,
+                                       IN uint8_t      val,
+                                       IN const size_t qwords_len,
+                                       IN const int    carry_tt)
+{
+  __m512i b[SLICES];
+  for(size_t j = 0; j < SLICES; j++) {
+    b[j] = SET1_I64(0 - (uint64_t)(val & 0x1));
     val >>= 1;
+  }
+
+  for(size_t i = 0; i < qwords_len; i += QWORDS_IN_ZMM) {
+    __m512i c = SET_ZERO;
+
+    for(size_t j = 0; j < SLICES; j++) {
+      const __m512i a = LOAD(&upc[(j * qwords_len) + i]);
+      STORE(&upc[(j * qwords_len) + i], TERNLOG_I64(a, b[j], c, XOR3_TT));
+
+      // The immediate operand must be a compile-time constant
+      if(carry_tt == BORROW_TT) {
+        c = TERNLOG_I64(a, b[j], c, BORROW_TT);
+      } else {
+        c = TERNLOG_I64(a, b[j], c, MAJ_TT);
+      }
+    }
+  }
+}
+
+// Perform a - b with c as the input/output borrow, where
+// o  = a^b^c
+//            _     __    _ _   _ _     _
+// br = abc + abc + abc + abc = abc + ((a+b))c
+// (see bit_slice_full_subtract_port).
+void bit_slice_full_subtract_avx512(OUT uint64_t *upc,
+                                    IN uint8_t      val,
+                                    IN const size_t qwords_len)
+{
+  bit_slice_full_op_avx512(upc, val, qwords_len, BORROW_TT);
+}
+
+// Add the constant val to all the counters of the UPC array (modulo 2^SLICES)
+// in a single pass over the slices.
+void bit_slice_add_const_avx512(OUT uint64_t *upc,
+                                IN uint8_t      val,
+                                IN const size_t qwords_len)
+{
+  bit_slice_full_op_avx512(upc, val, qwords_len, MAJ_TT);
+}
 
-    // Perform a - b with c as the input/output carry
-    // br = 0 0 0 0 1 1 1 1
-    // a  = 0 0 1 1 0 0 1 1
-    // b  = 0 1 0 1 0 1 0 1
-    // -------------------
-    // o  = 0 1 1 0 0 1 1 1
-    // c  = 0 1 0 0 1 1 0 1
-    //
-    // o  = a^b^c
-    //            _     __    _ _   _ _     _
-    // br = abc + abc + abc + abc = abc + ((a+b))c
+// The byte counters UPC engine, see upc_bytes_port. Every ZMM holds the
+// counters of the 64 bits of one qword of the rotated syndrome, therefore,
+// adding a rotated syndrome takes a single masked add per ZMM.
+bike_static_assert(D < 256, upc_bytes_overflow_err);
+
+void upc_bytes_avx512(OUT pad_r_t *ge_thr,
+                      OUT pad_r_t *ge_thr_delta,
+                      IN const syndrome_t *syndrome,
+                      IN const compressed_idx_d_t *wlist,
+                      IN const rotate_plan_t *rot,
+                      IN const uint8_t        threshold,
+                      IN const decode_ctx *ctx)
+{
+  DEFER_CLEANUP(syndrome_t rotated_syndrome = {0}, syndrome_cleanup);
+  __m512i upc[R_QWORDS];
+
+  const __m512i one = SET1_I8(1);
+
+  for(size_t i = 0; i < R_QWORDS; i++) {
+    upc[i] = SET_ZERO;
+  }
+
+  for(size_t j = 0; j < D; j++) {
+    rotate_right_idx(&rotated_syndrome, syndrome, wlist, rot, j, ctx);
 
     for(size_t i = 0; i < R_QWORDS; i++) {
-      const uint64_t a      = upc->slice[j].u.qw[i];
-      const uint64_t b      = lsb_mask;
-      const uint64_t tmp    = ((~a) & b & (~br[i])) | ((((~a) | b) & br[i]));
-      upc->slice[j].u.qw[i] = a ^ b ^ br[i];
-      br[i]                 = tmp;
+      upc[i] = MADD_I8(upc[i], rotated_syndrome.qw[i], upc[i], one);
     }
   }
+
+  uint64_t *    ge_thr64 = (uint64_t *)ge_thr;
+  const __m512i thr      = SET1_I8(threshold);
+  for(size_t i = 0; i < R_QWORDS; i++) {
+    ge_thr64[i] = CMPM_U8(upc[i], thr, _MM_CMPINT_NLT);
+  }
+
+  if(ge_thr_delta != NULL) {
+    uint64_t *    ge_thr_delta64 = (uint64_t *)ge_thr_delta;
+    const __m512i thr_delta      = SET1_I8(threshold - DELTA);
+    for(size_t i = 0; i < R_QWORDS; i++) {
+      ge_thr_delta64[i] = CMPM_U8(upc[i], thr_delta, _MM_CMPINT_NLT);
+    }
+  }
+
+  secure_clean((uint8_t *)upc, sizeof(upc));
 }
@@ -0,0 +1,213 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ *
+ * The rotate functions are based on the Barrel shifter described in [1] and
+ * some code snippets from [2]:
+ *
+ * [1] Chou, T.: QcBits: Constant-Time Small-Key Code-Based Cryptography.
+ *     In: Gier-lichs, B., Poschmann, A.Y. (eds.) Cryptographic Hardware
+ *     and Embedded Systems– CHES 2016. pp. 280–300. Springer Berlin Heidelberg,
+ *     Berlin, Heidelberg (2016)
+ *
+ * [2] Guimarães, Antonio, Diego F Aranha, and Edson Borin. 2019.
+ *     “Optimized Implementation of QC-MDPC Code-Based Cryptography.”
+ *     Concurrency and Computation: Practice and Experience 31 (18):
+ *     e5089. https://doi.org/10.1002/cpe.5089.
+ */
+
+#include "decode.h"
+#include "cleanup.h"
+#include "decode_internal.h"
+#include "utilities.h"
+
+#define NEON_INTERNAL
+#include "aarch64_intrinsic.h"
+
+#define R_QWORDS_HALF_LOG2 UPTOPOW2(R_QWORDS / 2)
+
+// The loops below process REG_QWORDS qwords at a time,
+// so they may go one qword beyond the bound of the scalar loops.
+#define R_QWORDS_REGS (DIVIDE_AND_CEIL(R_QWORDS, REG_QWORDS) * REG_QWORDS)
+
+_INLINE_ void
+rotr_big(OUT syndrome_t *out, IN const syndrome_t *in, IN const uint64_t *masks)
+{
+  // For preventing overflows (comparison in bytes)
+  bike_static_assert(sizeof(*out) > 8 * (R_QWORDS_REGS + 1 +
+                                         (2 * R_QWORDS_HALF_LOG2)),
+                     rotr_big_err);
+
+  *out = *in;
+
+  size_t l = 0;
+  for(uint32_t idx = R_QWORDS_HALF_LOG2; idx >= 1; idx >>= 1, l++) {
+    const REG_T vmask = SET1_I64(masks[l]);
+
+    // Rotate R_QWORDS quadwords and another idx quadwords,
+    // as needed by the next iteration. Every iteration reads the qwords
+    // that it overwrites before it writes them (out and in overlap).
+    for(size_t i = 0; i < (R_QWORDS + idx); i += REG_QWORDS) {
+      const REG_T a = LOAD(&out->qw[i + idx]);
+      const REG_T b = LOAD(&out->qw[i]);
+      STORE(&out->qw[i], BLEND(vmask, a, b));
+    }
+  }
+}
+
+_INLINE_ void
+rotr_small(OUT syndrome_t *out, IN const syndrome_t *in, IN const size_t bits)
+{
+  bike_static_assert(sizeof(*out) > (8 * (R_QWORDS_REGS + 1)),
+                     rotr_small_qw_err);
+
+  // The register shifts give zero for a shift by 64 (when bits = 0),
+  // so no mask is required as in rotr_small of decode_portable.c.
+  const int64x2_t right = vdupq_n_s64(0 - (int64_t)bits);
+  const int64x2_t left  = vdupq_n_s64(64 - (int64_t)bits);
+
+  for(size_t i = 0; i < R_QWORDS; i += REG_QWORDS) {
+    const REG_T low_part  = SHLV_I64(LOAD(&in->qw[i]), right);
+    const REG_T high_part = SHLV_I64(LOAD(&in->qw[i + 1]), left);
+    STORE(&out->qw[i], low_part | high_part);
+  }
+}
+
+// The rotations of rotate_right_neon are the same as of rotate_right_port,
+// so the plans are computed by rotate_plan_port.
+void rotate_right_plan_neon(OUT syndrome_t *out,
+                            IN const syndrome_t *in,
+                            IN const rotate_plan_t *p)
+{
+  // Rotate (64-bit) quad-words
+  rotr_big(out, in, p->mask);
+  // Rotate bits (less than 64)
+  rotr_small(out, out, p->small);
+}
+
+void rotate_right_neon(OUT syndrome_t *out,
+                       IN const syndrome_t *in,
+                       IN const uint32_t    bitscount)
+{
+  DEFER_CLEANUP(rotate_plan_t p, rotate_plan_cleanup);
+
+  rotate_plan_port(&p, bitscount);
+  rotate_right_plan_neon(out, in, &p);
+}
+
+// Duplicates the first R_BITS of the syndrome three times
+// |------------------------------------------|
+// |  Third copy | Second copy | first R_BITS |
+// |------------------------------------------|
+// This is required by the rotate functions.
+void dup_neon(IN OUT syndrome_t *s)
+{
+  s->qw[R_QWORDS - 1] =
+    (s->qw[0] << LAST_R_QWORD_LEAD) | (s->qw[R_QWORDS - 1] & LAST_R_QWORD_MASK);
+
+  for(size_t i = 0; i < (2 * R_QWORDS) - 1; i++) {
+    s->qw[R_QWORDS + i] =
+      (s->qw[i] >> LAST_R_QWORD_TRAIL) | (s->qw[i + 1] << LAST_R_QWORD_LEAD);
+  }
+}
+
+// Use half-adder as described in [1].
+void bit_sliced_adder_neon(OUT upc_t *upc,
+                           IN OUT syndrome_t *rotated_syndrome,
+                           IN const size_t    num_of_slices)
+{
+  // From cache-memory perspective this loop should be the outside loop
+  for(size_t j = 0; j < num_of_slices; j++) {
+    for(size_t i = 0; i < R_QWORDS; i += REG_QWORDS) {
+      const REG_T u = LOAD(&upc->slice[j].u.qw[i]);
+      const REG_T s = LOAD(&rotated_syndrome->qw[i]);
+
+      STORE(&upc->slice[j].u.qw[i], u ^ s);
+      STORE(&rotated_syndrome->qw[i], u & s);
+    }
+  }
+}
+
+// Add count rotated syndromes to the UPC array,
+// see bit_sliced_adder_tiled_port.
+void bit_sliced_adder_tiled_neon(OUT uint64_t *upc,
+                                 IN const uint64_t *rotated,
+                                 IN const size_t    count,
+                                 IN const size_t    qwords_len)
+{
+  for(size_t i = 0; i < qwords_len; i += REG_QWORDS) {
+    REG_T u[SLICES];
+    for(size_t k = 0; k < SLICES; k++) {
+      u[k] = LOAD(&upc[(k * qwords_len) + i]);
+    }
+
+    for(size_t b = 0; b < count; b++) {
+      REG_T carry = LOAD(&rotated[(b * qwords_len) + i]);
+      for(size_t k = 0; k < SLICES; k++) {
+        const REG_T tmp = u[k] & carry;
+        u[k] ^= carry;
+        carry = tmp;
+      }
+    }
+
+    for(size_t k = 0; k < SLICES; k++) {
+      STORE(&upc[(k * qwords_len) + i], u[k]);
+    }
+  }
+}
+
+// See bit_slice_full_subtract_port:
+//            _     __    _ _   _ _     _
+// br = abc + abc + abc + abc = abc + ((a+b))c
+void bit_slice_full_subtract_neon(OUT uint64_t *upc,
+                                  IN uint8_t      val,
+                                  IN const size_t qwords_len)
+{
+  REG_T b[SLICES];
+  for(size_t j = 0; j < SLICES; j++) {
+    b[j] = SET1_I64(0 - (uint64_t)(val & 0x1));
+    val >>= 1;
+  }
+
+  for(size_t i = 0; i < qwords_len; i += REG_QWORDS) {
+    // Borrow
+    REG_T br = SET_ZERO;
+
+    for(size_t j = 0; j < SLICES; j++) {
+      const REG_T a = LOAD(&upc[(j * qwords_len) + i]);
+      const REG_T tmp =
+        vbicq_u64(vbicq_u64(b[j], a), br) | (vornq_u64(b[j], a) & br);
+
+      STORE(&upc[(j * qwords_len) + i], a ^ b[j] ^ br);
+      br = tmp;
+    }
+  }
+}
+
+// Add the constant val to all the counters of the UPC array (modulo 2^SLICES)
+// in a single pass over the slices.
+void bit_slice_add_const_neon(OUT uint64_t *upc,
+                              IN uint8_t      val,
+                              IN const size_t qwords_len)
+{
+  REG_T b[SLICES];
+  for(size_t j = 0; j < SLICES; j++) {
+    b[j] = SET1_I64(0 - (uint64_t)(val & 0x1));
+    val >>= 1;
+  }
+
+  for(size_t i = 0; i < qwords_len; i += REG_QWORDS) {
+    // Carry
+    REG_T c = SET_ZERO;
+
+    // c = ac + (a+c)b, i.e., (a+c) where b is set and ac elsewhere
+    for(size_t j = 0; j < SLICES; j++) {
+      const REG_T a = LOAD(&upc[(j * qwords_len) + i]);
+
+      STORE(&upc[(j * qwords_len) + i], a ^ b[j] ^ c);
+      c = BLEND(b[j], a | c, a & c);
+    }
+  }
+}
@@ -6,13 +6,34 @@
  */
 
 #include "decode.h"
+#include "cleanup.h"
 #include "decode_internal.h"
 #include "utilities.h"
 
 #define R_QWORDS_HALF_LOG2 UPTOPOW2(R_QWORDS / 2)
 
+bike_static_assert(R_QWORDS_HALF_LOG2 < (1 << ROTATE_PLAN_LEVELS),
+                   rotate_plan_levels_err);
+
+// Compute the blend masks of rotr_big and the shift of rotr_small
+// for rotating by bitscount.
+void rotate_plan_port(OUT rotate_plan_t *p, IN const uint32_t bitscount)
+{
+  uint32_t qw_num = bitscount / 64;
+  size_t   l      = 0;
+
+  for(uint32_t idx = R_QWORDS_HALF_LOG2; idx >= 1; idx >>= 1, l++) {
+    // Convert 32 bit mask to 64 bit mask
+    const uint64_t mask = ((uint32_t)secure_l32_mask(qw_num, idx) + 1U) - 1ULL;
+    qw_num              = qw_num - (idx & u64_barrier(mask));
+    p->mask[l]          = mask;
+  }
+
+  p->small = bitscount % 64;
+}
+
 _INLINE_ void
-rotr_big(OUT syndrome_t *out, IN const syndrome_t *in, IN size_t qw_num)
+rotr_big(OUT syndrome_t *out, IN const syndrome_t *in, IN const uint64_t *masks)
 {
   // For preventing overflows (comparison in bytes)
   bike_static_assert(sizeof(*out) > 8 * (R_QWORDS + (2 * R_QWORDS_HALF_LOG2)),
@@ -20,10 +41,9 @@ rotr_big(OUT syndrome_t *out, IN const syndrome_t *in, IN size_t qw_num)
 
   *out = *in;
 
-  for(uint32_t idx = R_QWORDS_HALF_LOG2; idx >= 1; idx >>= 1) {
-    // Convert 32 bit mask to 64 bit mask
-    const uint64_t mask = ((uint32_t)secure_l32_mask(qw_num, idx) + 1U) - 1ULL;
-    qw_num              = qw_num - (idx & u64_barrier(mask));
+  size_t l = 0;
+  for(uint32_t idx = R_QWORDS_HALF_LOG2; idx >= 1; idx >>= 1, l++) {
+    const uint64_t mask = masks[l];
 
     // Rotate R_QWORDS quadwords and another idx quadwords,
     // as needed by the next iteration.
@@ -51,14 +71,24 @@ rotr_small(OUT syndrome_t *out, IN const syndrome_t *in, IN const size_t bits)
   }
 }
 
+void rotate_right_plan_port(OUT syndrome_t *out,
+                            IN const syndrome_t *in,
+                            IN const rotate_plan_t *p)
+{
+  // Rotate (64-bit) quad-words
+  rotr_big(out, in, p->mask);
+  // Rotate bits (less than 64)
+  rotr_small(out, out, p->small);
+}
+
 void rotate_right_port(OUT syndrome_t *out,
                        IN const syndrome_t *in,
                        IN const uint32_t    bitscount)
 {
-  // Rotate (64-bit) quad-words
-  rotr_big(out, in, (bitscount / 64));
-  // Rotate bits (less than 64)
-  rotr_small(out, out, (bitscount % 64));
+  DEFER_CLEANUP(rotate_plan_t p, rotate_plan_cleanup);
+
+  rotate_plan_port(&p, bitscount);
+  rotate_right_plan_port(out, in, &p);
 }
 
 // Duplicates the first R_BITS of the syndrome three times
@@ -92,34 +122,164 @@ void bit_sliced_adder_port(OUT upc_t *upc,
   }
 }
 
-void bit_slice_full_subtract_port(OUT upc_t *upc, IN uint8_t val)
+// The functions below process a UPC array that is given as SLICES rows
+// (the slices) of qwords_len qwords, where qwords_len is a multiple of
+// QWORDS_IN_ZMM. The array is processed one column at a time, and the
+// counters of a column are kept in registers.
+
+// Add count rotated syndromes (rows of qwords_len qwords) to the UPC array.
+// Every column of the UPC slices is loaded once, the rotated syndromes are
+// added to it with half-adders, and it is stored back.
+// The carries are propagated through all the slices, which is simpler than
+// tracking the number of slices that may change (see bit_sliced_adder_port).
+void bit_sliced_adder_tiled_port(OUT uint64_t *upc,
+                                 IN const uint64_t *rotated,
+                                 IN const size_t    count,
+                                 IN const size_t    qwords_len)
 {
-  // Borrow
-  uint64_t br[R_QWORDS] = {0};
+  for(size_t i = 0; i < qwords_len; i++) {
+    uint64_t u[SLICES];
+    for(size_t k = 0; k < SLICES; k++) {
+      u[k] = upc[(k * qwords_len) + i];
+    }
+
+    for(size_t b = 0; b < count; b++) {
+      uint64_t carry = rotated[(b * qwords_len) + i];
+      for(size_t k = 0; k < SLICES; k++) {
+        const uint64_t tmp = u[k] & carry;
+        u[k] ^= carry;
+        carry = tmp;
+      }
+    }
+
+    for(size_t k = 0; k < SLICES; k++) {
+      upc[(k * qwords_len) + i] = u[k];
+    }
+  }
+}
 
+void bit_slice_full_subtract_port(OUT uint64_t *upc,
+                                  IN uint8_t      val,
+                                  IN const size_t qwords_len)
+{
+  uint64_t b[SLICES];
   for(size_t j = 0; j < SLICES; j++) {
+    b[j] = 0 - (uint64_t)(val & 0x1);
+    val >>= 1;
+  }
 
-    const uint64_t lsb_mask = 0 - (val & 0x1);
+  // Perform a - b with c as the input/output carry
+  // br = 0 0 0 0 1 1 1 1
+  // a  = 0 0 1 1 0 0 1 1
+  // b  = 0 1 0 1 0 1 0 1
+  // -------------------
+  // o  = 0 1 1 0 0 1 1 1
+  // c  = 0 1 0 0 1 1 0 1
+  //
+  // o  = a^b^c
+  //            _     __    _ _   _ _     _
+  // br = abc + abc + abc + abc = abc + ((a+b))c
+
+  for(size_t i = 0; i < qwords_len; i++) {
+    // Borrow
+    uint64_t br = 0;
+
+    for(size_t j = 0; j < SLICES; j++) {
+      const uint64_t a   = upc[(j * qwords_len) + i];
+      const uint64_t tmp = ((~a) & b[j] & (~br)) | ((((~a) | b[j]) & br));
+      upc[(j * qwords_len) + i] = a ^ b[j] ^ br;
+      br                        = tmp;
+    }
+  }
+}
+
+// Add the constant val to all the counters of the UPC array (modulo 2^SLICES)
+// in a single pass over the slices.
+void bit_slice_add_const_port(OUT uint64_t *upc,
+                              IN uint8_t      val,
+                              IN const size_t qwords_len)
+{
+  uint64_t b[SLICES];
+  for(size_t j = 0; j < SLICES; j++) {
+    b[j] = 0 - (uint64_t)(val & 0x1);
     val >>= 1;
+  }
 
-    // Perform a - b with c as the input/output carry
-    // br = 0 0 0 0 1 1 1 1
-    // a  = 0 0 1 1 0 0 1 1
-    // b  = 0 1 0 1 0 1 0 1
-    // -------------------
-    // o  = 0 1 1 0 0 1 1 1
-    // c  = 0 1 0 0 1 1 0 1
-    //
-    // o  = a^b^c
-    //            _     __    _ _   _ _     _
-    // br = abc + abc + abc + abc = abc + ((a+b))c
+  // Perform a + b with c as the input/output carry
+  // o = a^b^c
+  // c = ac + (a+c)b
+  for(size_t i = 0; i < qwords_len; i++) {
+    // Carry
+    uint64_t c = 0;
 
-    for(size_t i = 0; i < R_QWORDS; i++) {
-      const uint64_t a      = upc->slice[j].u.qw[i];
-      const uint64_t b      = lsb_mask;
-      const uint64_t tmp    = ((~a) & b & (~br[i])) | ((((~a) | b) & br[i]));
-      upc->slice[j].u.qw[i] = a ^ b ^ br[i];
-      br[i]                 = tmp;
+    for(size_t j = 0; j < SLICES; j++) {
+      const uint64_t a   = upc[(j * qwords_len) + i];
+      const uint64_t tmp = (a & c) | ((a | c) & b[j]);
+      upc[(j * qwords_len) + i] = a ^ b[j] ^ c;
+      c                         = tmp;
+    }
+  }
+}
+
+// The byte counters of the UPC engines, one counter per bit of the
+// (R_QWORDS qwords of the) rotated syndrome. The counters do not overflow,
+// therefore, eight counters are added at once in a qword.
+#define UPC_BYTES (R_QWORDS * 64)
+bike_static_assert(D < 256, upc_bytes_overflow_err);
+
+// Expand the 8 bits of b to 8 bytes of value 0/1 (bit k to byte k)
+_INLINE_ uint64_t expand_bits_to_bytes(IN const uint8_t b)
+{
+  // Byte k of t is either 0 or 2^k
+  const uint64_t t = (b * 0x0101010101010101ULL) & 0x8040201008040201ULL;
+
+  // Set the MSB of the bytes that are not 0 (without carries between bytes)
+  return ((t + 0x7f7f7f7f7f7f7f7fULL) >> 7) & 0x0101010101010101ULL;
+}
+
+// Set the bits of out where the byte counters are at least thr
+_INLINE_ void upc_bytes_ge(OUT pad_r_t *out,
+                           IN const uint8_t *upc,
+                           IN const uint8_t  thr)
+{
+  uint64_t *out64 = (uint64_t *)out;
+
+  for(size_t i = 0; i < R_QWORDS; i++) {
+    uint64_t ge = 0;
+    for(size_t b = 0; b < 64; b++) {
+      // The MSB of the difference is set iff upc < thr
+      const uint32_t lt = ((uint32_t)upc[(64 * i) + b] - thr) >> 31;
+      ge |= ((uint64_t)(lt ^ 1)) << b;
+    }
+    out64[i] = ge;
+  }
+}
+
+void upc_bytes_port(OUT pad_r_t *ge_thr,
+                    OUT pad_r_t *ge_thr_delta,
+                    IN const syndrome_t *syndrome,
+                    IN const compressed_idx_d_t *wlist,
+                    IN const rotate_plan_t *rot,
+                    IN const uint8_t        threshold,
+                    IN const decode_ctx *ctx)
+{
+  DEFER_CLEANUP(syndrome_t rotated_syndrome = {0}, syndrome_cleanup);
+  ALIGN(ALIGN_BYTES) uint64_t upc[UPC_BYTES / 8] = {0};
+
+  // Add every rotated syndrome bit to its byte counter
+  for(size_t j = 0; j < D; j++) {
+    rotate_right_idx(&rotated_syndrome, syndrome, wlist, rot, j, ctx);
+
+    const uint8_t *s8 = (const uint8_t *)rotated_syndrome.qw;
+    for(size_t i = 0; i < (UPC_BYTES / 8); i++) {
+      upc[i] += expand_bits_to_bytes(s8[i]);
     }
   }
+
+  upc_bytes_ge(ge_thr, (const uint8_t *)upc, threshold);
+  if(ge_thr_delta != NULL) {
+    upc_bytes_ge(ge_thr_delta, (const uint8_t *)upc, threshold - DELTA);
+  }
+
+  secure_clean((uint8_t *)upc, sizeof(upc));
 }
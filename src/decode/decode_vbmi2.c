@@ -0,0 +1,95 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ *
+ * The rotation is the one of decode_avx512.c, where the shifts of the
+ * qwords by less than 64 bits use the funnel shifts of AVX512-VBMI2.
+ */
+
+#include "decode.h"
+#include "cleanup.h"
+#include "decode_internal.h"
+#include "utilities.h"
+
+#define AVX512_INTERNAL
+#include "x86_64_intrinsic.h"
+
+#define R_ZMM_HALF_LOG2 UPTOPOW2(R_ZMM / 2)
+
+_INLINE_ void rotate512_big(OUT syndrome_t *out,
+                            IN const syndrome_t *in,
+                            IN const uint64_t *masks)
+{
+  // For preventing overflows (comparison in bytes)
+  bike_static_assert(sizeof(*out) >
+                       (BYTES_IN_ZMM * (R_ZMM + (2 * R_ZMM_HALF_LOG2))),
+                     rotr_big_err);
+  *out = *in;
+
+  size_t l = 0;
+  for(uint32_t idx = R_ZMM_HALF_LOG2; idx >= 1; idx >>= 1, l++) {
+    const uint8_t mask = (uint8_t)masks[l];
+
+    for(size_t i = 0; i < (R_ZMM + idx); i++) {
+      const __m512i a = LOAD(&out->qw[8 * (i + idx)]);
+      MSTORE64(&out->qw[8 * i], mask, a);
+    }
+  }
+}
+
+// See rotate512_small in decode_avx512.c. The funnel shift of (a1:a0) gives
+// (a0 >> count64) | (a1 << (64 - count64)), also when count64 = 0.
+_INLINE_ void
+rotate512_small(OUT syndrome_t *out, IN const syndrome_t *in, size_t bitscount)
+{
+  __m512i       previous    = SET_ZERO;
+  const int     count64     = (int)bitscount & 0x3f;
+  const __m512i count64_512 = SET1_I64(count64);
+
+  const __m512i num_full_qw = SET1_I64(bitscount >> 6);
+  const __m512i one         = SET1_I64(1);
+  __m512i       a0, a1;
+
+  __m512i idx = SET_I64(7, 6, 5, 4, 3, 2, 1, 0);
+
+  // Positions above 7 are taken from the second register in
+  // _mm512_permutex2var_epi64
+  idx          = ADD_I64(idx, num_full_qw);
+  __m512i idx1 = ADD_I64(idx, one);
+
+  for(int i = R_ZMM; i >= 0; i--) {
+    // Load the next 512 bits
+    const __m512i in512 = LOAD(&in->qw[8 * i]);
+
+    // Rotate the current and previous 512 registers so that their quadwords
+    // would be in the right positions.
+    a0 = PERMX2VAR_I64(in512, idx, previous);
+    a1 = PERMX2VAR_I64(in512, idx1, previous);
+
+    // Store the rotated value
+    STORE(&out->qw[8 * i], SHRDV_I64(a0, a1, count64_512));
+    previous = in512;
+  }
+}
+
+void rotate_right_plan_vbmi2(OUT syndrome_t *out,
+                             IN const syndrome_t *in,
+                             IN const rotate_plan_t *p)
+{
+  // 1) Rotate in granularity of 512 bits blocks, using ZMMs
+  rotate512_big(out, in, p->mask);
+  // 2) Rotate in smaller granularity (less than 512 bits), using ZMMs
+  rotate512_small(out, out, p->small);
+}
+
+void rotate_right_vbmi2(OUT syndrome_t *out,
+                        IN const syndrome_t *in,
+                        IN const uint32_t    bitscount)
+{
+  DEFER_CLEANUP(rotate_plan_t p, rotate_plan_cleanup);
+
+  rotate_plan_avx512(&p, bitscount);
+  rotate_right_plan_vbmi2(out, in, &p);
+}
@@ -14,104 +14,105 @@
 #include "gf2x.h"
 #include "gf2x_internal.h"
 
-// a = a^2 mod (x^r - 1)
-_INLINE_ void gf2x_mod_sqr_in_place(IN OUT pad_r_t *a,
-                                    OUT dbl_pad_r_t *secure_buffer,
-                                    IN const gf2x_ctx *ctx)
-{
-  ctx->sqr(secure_buffer, a);
-  ctx->red(a, secure_buffer);
-}
+// The gf2x_mod_inv function implements inversion in F_2[x]/(x^R - 1)
+// based on [1](Algorithm 2), generalized to an arbitrary addition chain.
+//
+// Denote f_e = a^(2^e - 1). Then f_(i+j) = (f_i)^(2^j) * f_j, and the inverse
+// is a^-1 = a^(2^(r-1) - 2) = (f_(r-2))^2. Therefore, every addition chain
+// for (r - 2) defines an inversion algorithm: every step of the chain costs
+// one multiplication and one exponentiation of the form f^(2^k).
+// [1](Algorithm 2) uses the binary expansion of (r - 2); the schedule used here
+// is generated at build time by tools/gf2x_inv_chain.c, which searches for a
+// chain with fewer multiplications and cheaper exponentiations.
+//
+// The exponentiations are computed either by repeated squaring of f, k times,
+// or by a single k-squaring of f. The method for a specific value of k
+// is chosen based on the performance of squaring and k-squaring:
+// repeated squaring is used for k <= k_sqr_thr of the tuning profile
+// (see gf2x_tune.h). Benchmarks on several platforms indicate that a good
+// default threshold is k = 64 (GF2X_DEFAULT_K_SQR_THR).
 
-// c = a^2^2^num_sqrs
-_INLINE_ void repeated_squaring(OUT pad_r_t *c,
-                                IN pad_r_t *    a,
-                                IN const size_t num_sqrs,
-                                OUT dbl_pad_r_t *sec_buf,
-                                IN const gf2x_ctx *ctx)
+// k-squaring is computed by a permutation of bits of the input polynomial,
+// as defined in [1](Observation 1). The required parameter for the permutation
+// is l = (2^k)^-1 % R. The generated schedule holds both k and l for every step.
+#include "gf2x_inv_schedule.h"
+
+typedef struct inv_step_s {
+  uint8_t  dst;
+  uint8_t  src;
+  uint8_t  mul;
+  uint32_t k;
+  uint32_t l;
+} inv_step_t;
+
+// The polynomials f_e that are alive during the computation
+typedef struct inv_regs_s {
+  pad_r_t val[GF2X_INV_NUM_REGS];
+} inv_regs_t;
+
+CLEANUP_FUNC(inv_regs, inv_regs_t)
+
+// Note that the schedule holds predefined constants that depend only on the
+// value of R. This value is public. Therefore, branches in gf2x_mod_inv,
+// which depends on R, are also "public". Code that releases these branches
+// (taken/not-taken) does not leak secret information.
+static const inv_step_t inv_schedule[GF2X_INV_NUM_STEPS] = {
+  GF2X_INV_SCHEDULE_VALS};
+
+// The permutation maps of the k-squarings in the schedule are also public.
+// Generating a map costs about as much as applying it, so we compute the maps
+// once, on the first call to gf2x_mod_inv, and reuse them afterwards.
+// Only the steps with k > GF2X_DEFAULT_K_SQR_THR have a map, and step i uses
+// k_sqr_maps[k_sqr_map_slots[i]] (steps with the same k share the map).
+// Of these, only the maps of the steps with k > k_sqr_maps_thr, the threshold
+// at the time the maps were built, exist. The other steps generate the map on
+// the fly if the threshold is lowered (see bike_set_tune_profile).
+// The maps are built by the first caller that moves the state from
+// K_SQR_MAPS_EMPTY to K_SQR_MAPS_BUILDING. Concurrent callers do not wait;
+// they fall back to k-squaring that generates the map on the fly until the
+// state becomes K_SQR_MAPS_READY.
+#define K_SQR_MAPS_EMPTY    (0)
+#define K_SQR_MAPS_BUILDING (1)
+#define K_SQR_MAPS_READY    (2)
+
+// The array is not empty even if no step has a map
+#define K_SQR_MAPS_LEN ((GF2X_INV_NUM_MAPS > 0) ? GF2X_INV_NUM_MAPS : 1)
+
+static const uint8_t k_sqr_map_slots[GF2X_INV_NUM_STEPS] = {
+  GF2X_INV_MAP_SLOTS};
+
+static k_sqr_map_t k_sqr_maps[K_SQR_MAPS_LEN];
+static uint32_t    k_sqr_maps_state = K_SQR_MAPS_EMPTY;
+static uint32_t    k_sqr_maps_thr;
+
+_INLINE_ const k_sqr_map_t *get_k_sqr_maps(void)
 {
-  c->val = a->val;
+  uint32_t state = __atomic_load_n(&k_sqr_maps_state, __ATOMIC_ACQUIRE);
+  if(state == K_SQR_MAPS_READY) {
+    return k_sqr_maps;
+  }
 
-  for(size_t i = 0; i < num_sqrs; i++) {
-    gf2x_mod_sqr_in_place(c, sec_buf, ctx);
+  uint32_t expected = K_SQR_MAPS_EMPTY;
+  if(!__atomic_compare_exchange_n(&k_sqr_maps_state, &expected,
+                                  K_SQR_MAPS_BUILDING, 0, __ATOMIC_ACQUIRE,
+                                  __ATOMIC_RELAXED)) {
+    return NULL;
   }
-}
 
-// The gf2x_mod_inv function implements inversion in F_2[x]/(x^R - 1)
-// based on [1](Algorithm 2).
+  gf2x_tune_profile_t profile;
+  gf2x_tune_profile(&profile);
 
-// In every iteration, [1](Algorithm 2) performs two exponentiations:
-// exponentiation 0 (exp0) and exponentiation 1 (exp1) of the form f^(2^k).
-// These exponentiations are computed either by repeated squaring of f, k times,
-// or by a single k-squaring of f. The method for a specific value of k
-// is chosen based on the performance of squaring and k-squaring.
-//
-// Benchmarks on several platforms indicate that a good threshold
-// for switching from repeated squaring to k-squaring is k = 64.
-#define K_SQR_THR (64)
+  k_sqr_maps_thr = profile.k_sqr_thr;
+  for(size_t i = 0; i < GF2X_INV_NUM_STEPS; i++) {
+    if((k_sqr_map_slots[i] != GF2X_INV_NO_MAP) &&
+       (inv_schedule[i].k > k_sqr_maps_thr)) {
+      k_sqr_map_init(&k_sqr_maps[k_sqr_map_slots[i]], inv_schedule[i].l);
+    }
+  }
 
-// k-squaring is computed by a permutation of bits of the input polynomial,
-// as defined in [1](Observation 1). The required parameter for the permutation
-// is l = (2^k)^-1 % R.
-// Therefore, there are two sets of parameters for every exponentiation:
-//   - exp0_k and exp1_k
-//   - exp0_l and exp1_l
-
-// Exponentiation 0 computes f^2^2^(i-1) for 0 < i < MAX_I.
-// Exponentiation 1 computes f^2^((r-2) % 2^i) for 0 < i < MAX_I,
-// only when the i-th bit of (r-2) is 1. Therefore, the value 0 in
-// exp1_k[i] and exp1_l[i] means that exp1 is skipped in i-th iteration.
-
-// To quickly generate all the required parameters in Sage:
-//   r = DESIRED_R
-//   max_i = floor(log(r-2, 2)) + 1
-//   exp0_k = [2^i for i in range(max_i)]
-//   exp0_l = [inverse_mod((2^k) % r, r) for k in exp0_k]
-//   exp1_k = [(r-2)%(2^i) if ((r-2) & (1<<i)) else 0 for i in range(max_i)]
-//   exp1_l = [inverse_mod((2^k) % r, r) if k != 0 else 0 for k in exp1_k]
-
-#if(LEVEL == 1)
-// The parameters below are hard-coded for R=12323
-bike_static_assert((R_BITS == 12323), gf2x_inv_r_doesnt_match_parameters);
-
-// MAX_I = floor(log(r-2)) + 1
-#  define MAX_I (14)
-#  define EXP0_K_VALS \
-     1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192
-#  define EXP0_L_VALS \
-     6162, 3081, 3851, 5632, 22, 484, 119, 1838, 1742, 3106, 10650, 1608, 10157, 8816
-#  define EXP1_K_VALS 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 33, 4129
-#  define EXP1_L_VALS 0, 0, 0, 0, 0, 6162, 0, 0, 0, 0, 0, 0, 242, 5717
-
-#elif(LEVEL == 3)
-// The parameters below are hard-coded for R=24659
-bike_static_assert((R_BITS == 24659), gf2x_inv_r_doesnt_match_parameters);
-
-// MAX_I = floor(log(r-2)) + 1
-#  define MAX_I (15)
-#  define EXP0_K_VALS \
-     1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384
-#  define EXP0_L_VALS                                                           \
-     12330, 6165, 7706, 3564, 2711, 1139, 15053, 1258, 4388, 20524, 9538, 6393, \
-     10486, 1715, 6804
-#  define EXP1_K_VALS 0, 0, 0, 0, 1, 0, 17, 0, 0, 0, 0, 0, 0, 81, 8273
-#  define EXP1_L_VALS 0, 0, 0, 0, 12330, 0, 13685, 0, 0, 0, 0, 0, 0, 23678, 19056
-
-#else
-// The parameters below are hard-coded for R=40973
-bike_static_assert((R_BITS == 40973), gf2x_inv_r_doesnt_match_parameters);
-
-// MAX_I = floor(log(r-2)) + 1
-#  define MAX_I (16)
-#  define EXP0_K_VALS \
-     1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, 32768
-#  define EXP0_L_VALS                                                         \
-     20487, 30730, 28169, 9443, 13001, 12376, 8302, 6618, 38760, 21582, 1660, \
-     10409, 14669, 30338, 17745, 7520
-#  define EXP1_K_VALS 0, 1, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 11, 0, 8203
-#  define EXP1_L_VALS 0, 20487, 0, 15365, 0, 0, 0, 0, 0, 0, 0, 0, 0, 6302, 0, 10058
-
-#endif
+  __atomic_store_n(&k_sqr_maps_state, K_SQR_MAPS_READY, __ATOMIC_RELEASE);
+  return k_sqr_maps;
+}
 
 // Inversion in F_2[x]/(x^R - 1), [1](Algorithm 2).
 // c = a^{-1} mod x^r-1
@@ -121,49 +122,51 @@ void gf2x_mod_inv(OUT pad_r_t *c, IN const pad_r_t *a)
   gf2x_ctx ctx;
   gf2x_ctx_init(&ctx);
 
-  // Note that exp0/1_k/l are predefined constants that depend only on the value
-  // of R. This value is public. Therefore, branches in this function, which
-  // depends on R, are also "public". Code that releases these branches
-  // (taken/not-taken) does not leak secret information.
-  const size_t exp0_k[MAX_I] = {EXP0_K_VALS};
-  const size_t exp0_l[MAX_I] = {EXP0_L_VALS};
-  const size_t exp1_k[MAX_I] = {EXP1_K_VALS};
-  const size_t exp1_l[MAX_I] = {EXP1_L_VALS};
+  gf2x_tune_profile_t profile;
+  gf2x_tune_profile(&profile);
+  const uint32_t k_sqr_thr = profile.k_sqr_thr;
+
+  // NULL if another thread is currently building the maps.
+  const k_sqr_map_t *maps = get_k_sqr_maps();
 
-  DEFER_CLEANUP(pad_r_t f = {0}, pad_r_cleanup);
   DEFER_CLEANUP(pad_r_t g = {0}, pad_r_cleanup);
-  DEFER_CLEANUP(pad_r_t t = {0}, pad_r_cleanup);
-  DEFER_CLEANUP(dbl_pad_r_t sec_buf = {0}, dbl_pad_r_cleanup);
 
-  // Steps 2 and 3 in [1](Algorithm 2)
-  f.val = a->val;
-  t.val = a->val;
+  DEFER_CLEANUP(inv_regs_t reg = {0}, inv_regs_cleanup);
 
-  for(size_t i = 1; i < MAX_I; i++) {
-    // Step 5 in [1](Algorithm 2), exponentiation 0: g = f^2^2^(i-1)
-    if(exp0_k[i - 1] <= K_SQR_THR) {
-      repeated_squaring(&g, &f, exp0_k[i - 1], &sec_buf, &ctx);
+  // f_1 = a
+  reg.val[0].val = a->val;
+
+  for(size_t i = 0; i < GF2X_INV_NUM_STEPS; i++) {
+    const inv_step_t *s = &inv_schedule[i];
+
+    // Exponentiation: g = reg[src]^2^k
+    if(s->k <= k_sqr_thr) {
+      ctx.sqr_red_k(&g, &reg.val[s->src], s->k);
+    } else if((maps != NULL) && (k_sqr_map_slots[i] != GF2X_INV_NO_MAP) &&
+              (s->k > k_sqr_maps_thr)) {
+      ctx.k_sqr_map(&g, &reg.val[s->src], &maps[k_sqr_map_slots[i]]);
     } else {
-      ctx.k_sqr(&g, &f, exp0_l[i - 1]);
+      ctx.k_sqr(&g, &reg.val[s->src], s->l);
     }
 
-    // Step 6, [1](Algorithm 2): f = f*g
-    gf2x_mod_mul_with_ctx(&f, &g, &f, &ctx);
+    // Multiplication: reg[dst] = g * reg[mul]
+    gf2x_mod_mul_with_ctx(&reg.val[s->dst], &g, &reg.val[s->mul], &ctx);
+  }
 
-    if(exp1_k[i] != 0) {
-      // Step 8, [1](Algorithm 2), exponentiation 1: g = f^2^((r-2) % 2^i)
-      if(exp1_k[i] <= K_SQR_THR) {
-        repeated_squaring(&g, &f, exp1_k[i], &sec_buf, &ctx);
-      } else {
-        ctx.k_sqr(&g, &f, exp1_l[i]);
-      }
+  // Step 10, [1](Algorithm 2): c = (f_(r-2))^2
+  ctx.sqr_red(c, &reg.val[GF2X_INV_RESULT_REG]);
+}
 
-      // Step 9, [1](Algorithm 2): t = t*g;
-      gf2x_mod_mul_with_ctx(&t, &g, &t, &ctx);
-    }
+size_t gf2x_inv_schedule_params(OUT uint32_t *k,
+                                OUT uint32_t *l,
+                                OUT uint8_t *has_map,
+                                IN const size_t max)
+{
+  for(size_t i = 0; (i < GF2X_INV_NUM_STEPS) && (i < max); i++) {
+    k[i]       = inv_schedule[i].k;
+    l[i]       = inv_schedule[i].l;
+    has_map[i] = (k_sqr_map_slots[i] != GF2X_INV_NO_MAP);
   }
 
-  // Step 10, [1](Algorithm 2): c = t^2
-  gf2x_mod_sqr_in_place(&t, &sec_buf, &ctx);
-  c->val = t.val;
+  return GF2X_INV_NUM_STEPS;
 }
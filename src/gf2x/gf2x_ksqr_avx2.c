@@ -208,3 +208,27 @@ void k_sqr_avx2(OUT pad_r_t *c, IN const pad_r_t *a, IN const size_t l_param)
   secure_clean(a_bytes, sizeof(a_bytes));
   secure_clean(c_bytes, sizeof(c_bytes));
 }
+
+// The same as k_sqr_avx2, with a precomputed permutation map.
+void k_sqr_map_avx2(OUT pad_r_t *c,
+                    IN const pad_r_t *a,
+                    IN const k_sqr_map_t *map)
+{
+  ALIGN(ALIGN_BYTES) uint8_t a_bytes[R_PADDED];
+  ALIGN(ALIGN_BYTES) uint8_t c_bytes[R_PADDED];
+
+  // Only the bytes above R_BITS that are read by bytes_to_bin must be zero.
+  bike_memset(&c_bytes[R_BITS], 0, (R_QWORDS * 2 * BYTES_IN_YMM) - R_BITS);
+
+  bin_to_bytes(a_bytes, a);
+
+  // Permute "a" using the precomputed permutation map.
+  for(size_t i = 0; i < R_BITS; i++) {
+    c_bytes[i] = a_bytes[map->idx[i]];
+  }
+
+  bytes_to_bin(c, c_bytes);
+
+  secure_clean(a_bytes, sizeof(a_bytes));
+  secure_clean(c_bytes, sizeof(c_bytes));
+}
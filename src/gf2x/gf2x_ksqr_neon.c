@@ -0,0 +1,164 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ *
+ * The k-squaring algorithm in this file is based on:
+ * [1] Nir Drucker, Shay Gueron, and Dusan Kostic. 2020. "Fast polynomial
+ * inversion for post quantum QC-MDPC cryptography". Cryptology ePrint Archive,
+ * 2020. https://eprint.iacr.org/2020/298.pdf
+ */
+
+#include "cleanup.h"
+#include "gf2x_internal.h"
+
+#include "aarch64_intrinsic.h"
+
+// See gf2x_ksqr_avx2.c. NEON has unsigned comparisons, so the map is
+// generated directly by map[i] = map[i - 1] + l_param (minus r if needed).
+#if(R_BITS < 32768)
+
+#  define MAP_WORDS_IN_REG WORDS_IN_NEON
+
+#  define map_word_t      uint16_t
+#  define map_reg_t       uint16x8_t
+#  define MAP_LOAD(mem)   vld1q_u16(mem)
+#  define MAP_STORE(m, v) vst1q_u16((m), (v))
+#  define MAP_SET1(x)     vdupq_n_u16(x)
+#  define MAP_ADD(x, y)   vaddq_u16(x, y)
+#  define MAP_SUB(x, y)   vsubq_u16(x, y)
+#  define MAP_CMPGE(x, y) vcgeq_u16(x, y)
+
+#else
+
+#  define MAP_WORDS_IN_REG DWORDS_IN_NEON
+
+#  define map_word_t      uint32_t
+#  define map_reg_t       uint32x4_t
+#  define MAP_LOAD(mem)   vld1q_u32(mem)
+#  define MAP_STORE(m, v) vst1q_u32((m), (v))
+#  define MAP_SET1(x)     vdupq_n_u32(x)
+#  define MAP_ADD(x, y)   vaddq_u32(x, y)
+#  define MAP_SUB(x, y)   vsubq_u32(x, y)
+#  define MAP_CMPGE(x, y) vcgeq_u32(x, y)
+
+#endif
+
+#define NUM_REGS    (4)
+#define NUM_OF_VALS (NUM_REGS * MAP_WORDS_IN_REG)
+
+_INLINE_ void generate_map(OUT map_word_t *map, IN const map_word_t l_param)
+{
+  map_reg_t vmap[NUM_REGS], vr, inc;
+
+  // The first NUM_OF_VALS elements are computed directly, every next
+  // element is the element NUM_OF_VALS positions before it plus
+  // (l_param * NUM_OF_VALS) % r, reduced mod r.
+  for(size_t i = 0; i < NUM_OF_VALS; i++) {
+    map[i] = (i * l_param) % R_BITS;
+  }
+
+  vr  = MAP_SET1(R_BITS);
+  inc = MAP_SET1((l_param * NUM_OF_VALS) % R_BITS);
+
+  for(size_t i = 0; i < NUM_REGS; i++) {
+    vmap[i] = MAP_LOAD(&map[i * MAP_WORDS_IN_REG]);
+  }
+
+  for(size_t i = NUM_REGS; i < (R_PADDED / MAP_WORDS_IN_REG); i += NUM_REGS) {
+    for(size_t j = 0; j < NUM_REGS; j++) {
+      // The sum is smaller than 2 * r, which fits in map_word_t
+      vmap[j] = MAP_ADD(vmap[j], inc);
+      vmap[j] = MAP_SUB(vmap[j], MAP_CMPGE(vmap[j], vr) & vr);
+
+      MAP_STORE(&map[(i + j) * MAP_WORDS_IN_REG], vmap[j]);
+    }
+  }
+}
+
+// Convert from bytes representation, where every byte holds a single bit
+// (0x00 or 0xff), of the polynomial, to a binary representation where every
+// byte holds 8 bits of the polynomial.
+_INLINE_ void bytes_to_bin(OUT pad_r_t *bin_buf, IN const uint8_t *bytes_buf)
+{
+  // Keep bit i of byte i of every 8 bytes, and sum the bytes
+  const uint8x16_t bits = {1, 2, 4, 8, 16, 32, 64, 128,
+                           1, 2, 4, 8, 16, 32, 64, 128};
+
+  uint8_t *bin8 = (uint8_t *)bin_buf;
+
+  for(size_t i = 0; i < R_QWORDS * 4; i++) {
+    const uint8x16_t t = vld1q_u8(&bytes_buf[i * BYTES_IN_NEON]) & bits;
+
+    bin8[2 * i]       = vaddv_u8(vget_low_u8(t));
+    bin8[(2 * i) + 1] = vaddv_u8(vget_high_u8(t));
+  }
+}
+
+// Convert from binary representation where every byte holds 8 bits
+// of the polynomial, to byte representation where
+// every byte holds a single bit of the polynomial (0x00 or 0xff).
+_INLINE_ void bin_to_bytes(OUT uint8_t *bytes_buf, IN const pad_r_t *bin_buf)
+{
+  // Broadcast every input byte to 8 bytes, and test bit i in byte i
+  const uint8x16_t bits = {1, 2, 4, 8, 16, 32, 64, 128,
+                           1, 2, 4, 8, 16, 32, 64, 128};
+
+  const uint8_t *bin8 = (const uint8_t *)bin_buf;
+
+  for(size_t i = 0; i < R_QWORDS * 4; i++) {
+    const uint8x16_t t =
+      vcombine_u8(vdup_n_u8(bin8[2 * i]), vdup_n_u8(bin8[(2 * i) + 1]));
+
+    vst1q_u8(&bytes_buf[i * BYTES_IN_NEON], vtstq_u8(t, bits));
+  }
+}
+
+// The k-squaring function computes c = a^(2^k) % (x^r - 1),
+// see k_sqr_avx2 for the details.
+void k_sqr_neon(OUT pad_r_t *c, IN const pad_r_t *a, IN const size_t l_param)
+{
+  ALIGN(ALIGN_BYTES) map_word_t map[R_PADDED];
+  ALIGN(ALIGN_BYTES) uint8_t    a_bytes[R_PADDED];
+  ALIGN(ALIGN_BYTES) uint8_t    c_bytes[R_PADDED] = {0};
+
+  // Generate the permutation map defined by pi1 and l_param.
+  generate_map(map, l_param);
+
+  bin_to_bytes(a_bytes, a);
+
+  // Permute "a" using the generated permutation map.
+  for(size_t i = 0; i < R_BITS; i++) {
+    c_bytes[i] = a_bytes[map[i]];
+  }
+
+  bytes_to_bin(c, c_bytes);
+
+  secure_clean(a_bytes, sizeof(a_bytes));
+  secure_clean(c_bytes, sizeof(c_bytes));
+}
+
+// The same as k_sqr_neon, with a precomputed permutation map.
+void k_sqr_map_neon(OUT pad_r_t *c,
+                    IN const pad_r_t *a,
+                    IN const k_sqr_map_t *map)
+{
+  ALIGN(ALIGN_BYTES) uint8_t a_bytes[R_PADDED];
+  ALIGN(ALIGN_BYTES) uint8_t c_bytes[R_PADDED];
+
+  // Only the bytes above R_BITS that are read by bytes_to_bin must be zero.
+  bike_memset(&c_bytes[R_BITS], 0, (R_QWORDS * 4 * BYTES_IN_NEON) - R_BITS);
+
+  bin_to_bytes(a_bytes, a);
+
+  // Permute "a" using the precomputed permutation map.
+  for(size_t i = 0; i < R_BITS; i++) {
+    c_bytes[i] = a_bytes[map->idx[i]];
+  }
+
+  bytes_to_bin(c, c_bytes);
+
+  secure_clean(a_bytes, sizeof(a_bytes));
+  secure_clean(c_bytes, sizeof(c_bytes));
+}
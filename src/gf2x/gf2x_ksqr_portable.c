@@ -46,3 +46,43 @@ void k_sqr_port(OUT pad_r_t *c, IN const pad_r_t *a, IN const size_t l_param)
   }
   c->val.raw[R_BYTES - 1] &= LAST_R_BYTE_MASK;
 }
+
+// Compute the permutation map pi1 (see above) of the k-squaring function.
+// The map depends only on the public value l_param.
+void k_sqr_map_init(OUT k_sqr_map_t *map, IN const size_t l_param)
+{
+  // Instead of computing (i * l_param) % r for every i, we accumulate
+  // l_param and subtract r when the sum exceeds it.
+  size_t pos = 0;
+  for(size_t i = 0; i < R_BITS; i++) {
+    map->idx[i] = (uint16_t)pos;
+
+    pos += l_param;
+    if(pos >= R_BITS) {
+      pos -= R_BITS;
+    }
+  }
+}
+
+// The same as k_sqr_port, but the positions pi1(idx) are taken
+// from a precomputed map.
+void k_sqr_map_port(OUT pad_r_t *c,
+                    IN const pad_r_t *a,
+                    IN const k_sqr_map_t *map)
+{
+  bike_memset(c->val.raw, 0, sizeof(c->val));
+
+  // Compute the result byte by byte
+  size_t idx = 0;
+  for(size_t i = 0; i < R_BYTES; i++) {
+    for(size_t j = 0; (j < BITS_IN_BYTE) && (idx < R_BITS); j++, idx++) {
+      size_t pos = map->idx[idx];
+
+      size_t  pos_byte = pos >> 3;
+      size_t  pos_bit  = pos & 7;
+      uint8_t bit      = (a->val.raw[pos_byte] >> pos_bit) & 1;
+
+      c->val.raw[i] |= (bit << j);
+    }
+  }
+}
@@ -0,0 +1,175 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ *
+ * The k-squaring algorithm in this file is based on:
+ * [1] Nir Drucker, Shay Gueron, and Dusan Kostic. 2020. "Fast polynomial
+ * inversion for post quantum QC-MDPC cryptography". Cryptology ePrint Archive,
+ * 2020. https://eprint.iacr.org/2020/298.pdf
+ */
+
+#include "gf2x_internal.h"
+
+#define AVX512_INTERNAL
+#include "x86_64_intrinsic.h"
+
+// The k-squaring kernels in gf2x_ksqr_avx2.c and gf2x_ksqr_avx512.c
+// expand the polynomial to one byte per bit, permute the bytes, and pack
+// the result back. For Level-5 the expanded buffers (2 * R_PADDED bytes)
+// do not fit in the L1 cache. The kernels in this file permute the bits
+// directly on the packed representation, using AVX512-VBMI and BITALG:
+//   For every 64 output bits c[i], ..., c[i + 63]:
+//   1. Gather the 64 dwords that start at the bytes that hold the bits
+//      a[pos_i], ..., a[pos_(i+63)], where pos_j = (j * l_param) % r.
+//   2. Compact the least significant byte of every dword into a single
+//      zmm register with VPERMT2B.
+//   3. Select bit (pos_j % 8) of every byte into a 64-bit mask with
+//      VPSHUFBITQMB, which produces the output qword.
+// The gathered addresses depend only on the public value l_param.
+
+#define NUM_ZMMS    (4)
+#define NUM_OF_VALS (NUM_ZMMS * DWORDS_IN_ZMM)
+
+bike_static_assert(NUM_OF_VALS == (8 * BYTES_IN_QWORD), k_sqr_vbmi_chunk_size);
+
+// The last gathered dword starts at byte (R_BITS - 1) / 8 of the polynomial.
+bike_static_assert((R_PADDED_BYTES >= R_BYTES + 3), k_sqr_vbmi_padding);
+
+#define SRLI_I32(a, imm)        _mm512_srli_epi32((a), (imm))
+#define GATHER_I32(idx, mem)    _mm512_i32gather_epi32((idx), (mem), 1)
+#define PERMX2VAR_I8(a, idx, b) _mm512_permutex2var_epi8((a), (idx), (b))
+#define BITSHUFFLE(a, ctrl)     _mm512_bitshuffle_epi64_mask((a), (ctrl))
+
+// clang-3.9 doesn't recognize this macro
+#if !defined(_MM_CMPINT_NLT)
+#  define _MM_CMPINT_NLT (5)
+#endif
+
+typedef struct k_sqr_consts_s {
+  // Indices of the least significant bytes of the dwords of two zmm
+  __m512i compact;
+  // The position of byte j inside its qword (8 * (j % 8))
+  __m512i offset;
+  __m512i seven;
+} k_sqr_consts_t;
+
+_INLINE_ void k_sqr_consts_init(OUT k_sqr_consts_t *consts)
+{
+  ALIGN(ALIGN_BYTES) uint8_t compact[BYTES_IN_ZMM];
+  ALIGN(ALIGN_BYTES) uint8_t offset[BYTES_IN_ZMM];
+
+  for(size_t i = 0; i < BYTES_IN_ZMM; i++) {
+    // The first 16 bytes are taken from the first register, and
+    // the next 16 from the second one (indices 64 to 127 of VPERMT2B).
+    if(i < DWORDS_IN_ZMM) {
+      compact[i] = 4 * i;
+    } else {
+      compact[i] = BYTES_IN_ZMM + (4 * (i - DWORDS_IN_ZMM));
+    }
+    offset[i] = 8 * (i & 7);
+  }
+
+  consts->compact = LOAD(compact);
+  consts->offset  = LOAD(offset);
+  consts->seven   = SET1_I8(7);
+}
+
+// Compact the least significant bytes of the dwords of v[0], ..., v[3]
+// into a single register.
+_INLINE_ __m512i compact(IN const __m512i v[NUM_ZMMS],
+                         IN const k_sqr_consts_t *consts)
+{
+  __m512i lo = PERMX2VAR_I8(v[0], consts->compact, v[1]);
+  __m512i hi = PERMX2VAR_I8(v[2], consts->compact, v[3]);
+
+  return _mm512_inserti64x4(lo, _mm512_castsi512_si256(hi), 1);
+}
+
+// Compute 64 bits of the output, given the positions of the
+// corresponding input bits.
+_INLINE_ uint64_t k_sqr_qword(IN const pad_r_t *a,
+                              IN const __m512i pos[NUM_ZMMS],
+                              IN const k_sqr_consts_t *consts)
+{
+  __m512i data[NUM_ZMMS];
+
+  for(size_t i = 0; i < NUM_ZMMS; i++) {
+    data[i] = GATHER_I32(SRLI_I32(pos[i], 3), a->val.raw);
+  }
+
+  // ctrl[j] = 8 * (j % 8) + (pos_j % 8)
+  const __m512i ctrl = _mm512_ternarylogic_epi32(
+    compact(pos, consts), consts->seven, consts->offset, 0xea);
+
+  return BITSHUFFLE(compact(data, consts), ctrl);
+}
+
+void k_sqr_vbmi(OUT pad_r_t *c, IN const pad_r_t *a, IN const size_t l_param)
+{
+  ALIGN(ALIGN_BYTES) uint32_t first[NUM_OF_VALS];
+  k_sqr_consts_t              consts;
+  __m512i                     pos[NUM_ZMMS];
+  uint64_t                   *c64 = (uint64_t *)c->val.raw;
+
+  k_sqr_consts_init(&consts);
+
+  // The positions of the input bits are generated on the fly as in
+  // generate_map of gf2x_ksqr_avx512.c: the positions of the next qword
+  // are the current positions plus (64 * l_param) % r, reduced mod r.
+  for(size_t i = 0; i < NUM_OF_VALS; i++) {
+    first[i] = (i * l_param) % R_BITS;
+  }
+  for(size_t i = 0; i < NUM_ZMMS; i++) {
+    pos[i] = LOAD(&first[i * DWORDS_IN_ZMM]);
+  }
+
+  const __m512i vr  = SET1_I32(R_BITS);
+  const __m512i inc = SET1_I32((l_param * NUM_OF_VALS) % R_BITS);
+
+  for(size_t i = 0; i < R_QWORDS; i++) {
+    c64[i] = k_sqr_qword(a, pos, &consts);
+
+    for(size_t j = 0; j < NUM_ZMMS; j++) {
+      pos[j]         = ADD_I32(pos[j], inc);
+      __mmask16 mask = CMPM_U32(pos[j], vr, _MM_CMPINT_NLT);
+      pos[j]         = MSUB_I32(pos[j], mask, pos[j], vr);
+    }
+  }
+
+  c64[R_QWORDS - 1] &= LAST_R_QWORD_MASK;
+}
+
+void k_sqr_map_vbmi(OUT pad_r_t *c,
+                    IN const pad_r_t *a,
+                    IN const k_sqr_map_t *map)
+{
+  k_sqr_consts_t consts;
+  __m512i        pos[NUM_ZMMS];
+  uint64_t      *c64 = (uint64_t *)c->val.raw;
+
+  k_sqr_consts_init(&consts);
+
+  for(size_t i = 0; i < R_QWORDS; i++) {
+    for(size_t j = 0; j < NUM_ZMMS; j++) {
+      const size_t idx = (i * NUM_OF_VALS) + (j * DWORDS_IN_ZMM);
+
+      // The map holds exactly R_BITS indices, the positions beyond them
+      // are set to zero and masked out from the result below.
+      if(idx + DWORDS_IN_ZMM <= R_BITS) {
+        pos[j] = _mm512_cvtepu16_epi32(_mm256_loadu_si256(
+          (const __m256i *)&map->idx[idx]));
+      } else if(idx < R_BITS) {
+        pos[j] = _mm512_cvtepu16_epi32(
+          _mm256_maskz_loadu_epi16(MASK(R_BITS - idx), &map->idx[idx]));
+      } else {
+        pos[j] = SET_ZERO;
+      }
+    }
+
+    c64[i] = k_sqr_qword(a, pos, &consts);
+  }
+
+  c64[R_QWORDS - 1] &= LAST_R_QWORD_MASK;
+}
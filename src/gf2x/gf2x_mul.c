@@ -5,59 +5,207 @@
  * AWS Cryptographic Algorithms Group.
  */
 
-#include <assert.h>
-
 #include "cleanup.h"
 #include "gf2x.h"
 #include "gf2x_internal.h"
+#include "parallel.h"
 
 // The secure buffer size required for Karatsuba is computed by:
 //    size(n) = 3*n/2 + size(n/2) = 3*sum_{i}{n/2^i} < 3n
-#define SECURE_BUFFER_QWORDS (3 * R_PADDED_QWORDS)
+// The top level of a product holds the three products lo, hi, and mid
+// (of 2h qwords each, h = GF2X_TOP_HALF_QWORDS) separated by zero paddings,
+// and alah and blbh (h qwords each). The recursive calls below the top level
+// take less than 3h qwords per product. In the latency mode, the three
+// products of the top level are computed concurrently, each one with its
+// own buffer for the recursive calls.
+#define TOP_HALF_QWORDS GF2X_TOP_HALF_QWORDS
+#define TOP_PAD_QWORDS  GF2X_TOP_PAD_QWORDS
+#define TOP_QWORDS      (8 * TOP_HALF_QWORDS + 4 * TOP_PAD_QWORDS)
+#define REC_QWORDS      (3 * TOP_HALF_QWORDS)
+
+#if defined(LATENCY_MODE)
+#  define TOP_REC_BUFS (3)
+#else
+#  define TOP_REC_BUFS (1)
+#endif
+
+#define SECURE_BUFFER_QWORDS (TOP_QWORDS + (TOP_REC_BUFS * REC_QWORDS))
+
+// Compute the n independent base products c[j] = a[j] * b[j] in pairs.
+_INLINE_ void mul_base_xn(OUT uint64_t *const c[],
+                          IN const uint64_t *const a[],
+                          IN const uint64_t *const b[],
+                          IN const size_t          n,
+                          IN const gf2x_ctx *ctx)
+{
+  size_t j = 0;
+  for(; (j + 1) < n; j += 2) {
+    ctx->mul_base_x2(&c[j], &a[j], &b[j]);
+  }
+  if(j < n) {
+    ctx->mul_base(c[j], a[j], b[j]);
+  }
+}
+
+// The number of qwords taken by the Karatsuba half-sums of an operand of
+// qwords_len_pad qwords, see gf2x_prepared_t.
+_INLINE_ size_t prepared_sums_qwords(IN size_t qwords_len_pad)
+{
+  size_t sums_qwords = 0;
+  size_t num_nodes   = 1;
+
+  for(; qwords_len_pad > GF2X_PREPARED_MIN_QWORDS; qwords_len_pad >>= 1) {
+    sums_qwords += num_nodes * (qwords_len_pad >> 1);
+    num_nodes *= 3;
+  }
+
+  return sums_qwords;
+}
+
+// prepared_sums_qwords at compile time, for operands of up to
+// (GF2X_PREPARED_MIN_QWORDS << 6) qwords
+#define PREPARED_SUMS_STEP(n, sub) \
+  (((n) > GF2X_PREPARED_MIN_QWORDS) ? (((n) / 2) + (3 * (sub))) : 0)
+
+#define PREPARED_SUMS_1(n) PREPARED_SUMS_STEP(n, 0)
+#define PREPARED_SUMS_2(n) PREPARED_SUMS_STEP(n, PREPARED_SUMS_1((n) / 2))
+#define PREPARED_SUMS_3(n) PREPARED_SUMS_STEP(n, PREPARED_SUMS_2((n) / 2))
+#define PREPARED_SUMS_4(n) PREPARED_SUMS_STEP(n, PREPARED_SUMS_3((n) / 2))
+#define PREPARED_SUMS_5(n) PREPARED_SUMS_STEP(n, PREPARED_SUMS_4((n) / 2))
+#define PREPARED_SUMS_6(n) PREPARED_SUMS_STEP(n, PREPARED_SUMS_5((n) / 2))
+
+// The half-sums of a prepared operand of qwords_len_pad qwords are laid out
+// as: alah | sums(a_lo) | sums(a_hi) | sums(alah), in the order in which
+// karatzuba consumes them. Return the sums of the i-th sub-operand
+// (0 - a_lo, 1 - a_hi, 2 - alah) of the n operands in child, or NULL if
+// these are not prepared.
+_INLINE_ const uint64_t *const *prepared_child(OUT const uint64_t *child[],
+                                               IN const uint64_t *const sums[],
+                                               IN const size_t n,
+                                               IN const size_t qwords_len_pad,
+                                               IN const size_t i)
+{
+  const size_t half_qw_len = qwords_len_pad >> 1;
+  const size_t sub_qwords  = prepared_sums_qwords(half_qw_len);
+
+  if((sums == NULL) || (half_qw_len <= GF2X_PREPARED_MIN_QWORDS)) {
+    return NULL;
+  }
+
+  for(size_t j = 0; j < n; j++) {
+    child[j] = &sums[j][half_qw_len + (i * sub_qwords)];
+  }
+
+  return child;
+}
+
+// Compute the half-sums of a (of qwords_len_pad qwords) as consumed by
+// karatzuba, see prepared_child.
+static void prepare_sums(OUT uint64_t *sums,
+                         IN const uint64_t *a,
+                         IN const size_t    qwords_len_pad,
+                         IN const gf2x_ctx *ctx)
+{
+  if(qwords_len_pad <= GF2X_PREPARED_MIN_QWORDS) {
+    return;
+  }
+
+  const size_t half_qw_len = qwords_len_pad >> 1;
+  const size_t sub_qwords  = prepared_sums_qwords(half_qw_len);
+
+  ctx->karatzuba_add2(sums, a, &a[half_qw_len], half_qw_len);
+
+  prepare_sums(&sums[half_qw_len], a, half_qw_len, ctx);
+  prepare_sums(&sums[half_qw_len + sub_qwords], &a[half_qw_len], half_qw_len,
+               ctx);
+  prepare_sums(&sums[half_qw_len + (2 * sub_qwords)], sums, half_qw_len, ctx);
+}
 
 // Karatsuba multiplication algorithm.
-// Input arguments a and b are padded with zeros, here:
+// Computes n independent products c[j] = a[j] * b[j] in lock-step, so that
+// the base multiplications of the different products are interleaved.
+// Input arguments a[j] and b[j] are padded with zeros, here:
 //   - n: real number of digits in a and b (R_QWORDS)
 //   - n_padded: padded number of digits of a and b (assumed to be power of 2)
 // A buffer sec_buf is used for storing temporary data between recursion calls.
 // It might contain secrets, and therefore should be securely cleaned after
 // completion.
-_INLINE_ void karatzuba(OUT uint64_t *c,
-                        IN const uint64_t *a,
-                        IN const uint64_t *b,
-                        IN const size_t    qwords_len,
-                        IN const size_t    qwords_len_pad,
-                        uint64_t *         sec_buf,
+// When sums is not NULL, sums[j] holds the (prepared) half-sums of a[j],
+// and only the half-sums of b[j] are computed.
+_INLINE_ void karatzuba(OUT uint64_t *const c[],
+                        IN const uint64_t *const a[],
+                        IN const uint64_t *const b[],
+                        IN const uint64_t *const sums[],
+                        IN const size_t          n,
+                        IN const size_t          qwords_len,
+                        IN const size_t          qwords_len_pad,
+                        uint64_t *               sec_buf,
                         IN const gf2x_ctx *ctx)
 {
   if(qwords_len <= ctx->mul_base_qwords) {
-    ctx->mul_base(c, a, b);
+    mul_base_xn(c, a, b, n, ctx);
+
+    // The output buffer is not initialized by the callers, therefore,
+    // the (zero) part of the product above the base product is explicitly set.
+    if(qwords_len_pad > ctx->mul_base_qwords) {
+      for(size_t j = 0; j < n; j++) {
+        bike_memset(&c[j][2 * ctx->mul_base_qwords], 0,
+                    2 * (qwords_len_pad - ctx->mul_base_qwords) *
+                      sizeof(uint64_t));
+      }
+    }
     return;
   }
 
   const size_t half_qw_len = qwords_len_pad >> 1;
 
-  // Split a and b into low and high parts of size n_padded/2
-  const uint64_t *a_lo = a;
-  const uint64_t *b_lo = b;
-  const uint64_t *a_hi = &a[half_qw_len];
-  const uint64_t *b_hi = &b[half_qw_len];
+  // The entries j >= n of a_lo, b_lo, a_hi, b_hi, c0, and c2 are never used,
+  // they are initialized only to silence (false) maybe-uninitialized warnings
+  const uint64_t *a_lo[GF2X_MUL_MAX_BATCH] = {0};
+  const uint64_t *b_lo[GF2X_MUL_MAX_BATCH] = {0};
+  const uint64_t *a_hi[GF2X_MUL_MAX_BATCH] = {0};
+  const uint64_t *b_hi[GF2X_MUL_MAX_BATCH] = {0};
+  const uint64_t *alah_in[GF2X_MUL_MAX_BATCH], *blbh_in[GF2X_MUL_MAX_BATCH];
+  uint64_t       *c0[GF2X_MUL_MAX_BATCH] = {0}, *c1[GF2X_MUL_MAX_BATCH];
+  uint64_t       *c2[GF2X_MUL_MAX_BATCH] = {0};
+  uint64_t       *alah[GF2X_MUL_MAX_BATCH], *blbh[GF2X_MUL_MAX_BATCH];
+  uint64_t       *tmp[GF2X_MUL_MAX_BATCH];
+
+  // The prepared half-sums of a_lo, a_hi, and alah (if any)
+  const uint64_t        *child[3][GF2X_MUL_MAX_BATCH];
+  const uint64_t *const *sums_lo =
+    prepared_child(child[0], sums, n, qwords_len_pad, 0);
+  const uint64_t *const *sums_hi =
+    prepared_child(child[1], sums, n, qwords_len_pad, 1);
+  const uint64_t *const *sums_mid =
+    prepared_child(child[2], sums, n, qwords_len_pad, 2);
 
-  // Split c into 4 parts of size n_padded/2 (the last ptr is not needed)
-  uint64_t *c0 = c;
-  uint64_t *c1 = &c[half_qw_len];
-  uint64_t *c2 = &c[half_qw_len * 2];
+  for(size_t j = 0; j < n; j++) {
+    // Split a and b into low and high parts of size n_padded/2
+    a_lo[j] = a[j];
+    b_lo[j] = b[j];
+    a_hi[j] = &a[j][half_qw_len];
+    b_hi[j] = &b[j][half_qw_len];
 
-  // Allocate 3 ptrs of size n_padded/2  on sec_buf
-  uint64_t *alah = sec_buf;
-  uint64_t *blbh = &sec_buf[half_qw_len];
-  uint64_t *tmp  = &sec_buf[half_qw_len * 2];
+    // Split c into 4 parts of size n_padded/2 (the last ptr is not needed)
+    c0[j] = c[j];
+    c1[j] = &c[j][half_qw_len];
+    c2[j] = &c[j][half_qw_len * 2];
 
-  // Move sec_buf ptr to the first free location for the next recursion call
-  sec_buf = &sec_buf[half_qw_len * 3];
+    // Allocate 3 ptrs of size n_padded/2 on sec_buf
+    alah[j]    = sec_buf;
+    blbh[j]    = &sec_buf[half_qw_len];
+    tmp[j]     = &sec_buf[half_qw_len * 2];
+    alah_in[j] = (sums != NULL) ? sums[j] : alah[j];
+    blbh_in[j] = blbh[j];
+
+    // Move sec_buf ptr to the first free location
+    sec_buf = &sec_buf[half_qw_len * 3];
+  }
 
   // Compute a_lo*b_lo and store the result in (c1|c0)
-  karatzuba(c0, a_lo, b_lo, half_qw_len, half_qw_len, sec_buf, ctx);
+  karatzuba(c0, a_lo, b_lo, sums_lo, n, half_qw_len, half_qw_len, sec_buf,
+            ctx);
 
   // If the real number of digits n is less or equal to n_padded/2 then:
   //     a_hi = 0 and b_hi = 0
@@ -66,21 +214,236 @@ _INLINE_ void karatzuba(OUT uint64_t *c,
   // so we can skip the remaining two multiplications
   if(qwords_len > half_qw_len) {
     // Compute a_hi*b_hi and store the result in (c3|c2)
-    karatzuba(c2, a_hi, b_hi, qwords_len - half_qw_len, half_qw_len, sec_buf,
-              ctx);
+    karatzuba(c2, a_hi, b_hi, sums_hi, n, qwords_len - half_qw_len,
+              half_qw_len, sec_buf, ctx);
 
-    // Compute alah = (a_lo + a_hi) and blbh = (b_lo + b_hi)
-    ctx->karatzuba_add1(alah, blbh, a, b, half_qw_len);
+    for(size_t j = 0; j < n; j++) {
+      // Compute alah = (a_lo + a_hi) and blbh = (b_lo + b_hi)
+      if(sums != NULL) {
+        ctx->karatzuba_add2(blbh[j], b_lo[j], b_hi[j], half_qw_len);
+      } else {
+        ctx->karatzuba_add1(alah[j], blbh[j], a[j], b[j], half_qw_len);
+      }
 
-    // Compute (c1 + c2) and store the result in tmp
-    ctx->karatzuba_add2(tmp, c1, c2, half_qw_len);
+      // Compute (c1 + c2) and store the result in tmp
+      ctx->karatzuba_add2(tmp[j], c1[j], c2[j], half_qw_len);
+    }
 
     // Compute alah*blbh and store the result in (c2|c1)
-    karatzuba(c1, alah, blbh, half_qw_len, half_qw_len, sec_buf, ctx);
+    karatzuba(c1, alah_in, blbh_in, sums_mid, n, half_qw_len, half_qw_len,
+              sec_buf, ctx);
 
     // Add (tmp|tmp) and (c3|c0) to (c2|c1)
-    ctx->karatzuba_add3(c0, tmp, half_qw_len);
+    for(size_t j = 0; j < n; j++) {
+      ctx->karatzuba_add3(c0[j], tmp[j], half_qw_len);
+    }
+  } else {
+    // The output buffer is not initialized by the callers,
+    // therefore, the (zero) upper half of the product is explicitly set.
+    for(size_t j = 0; j < n; j++) {
+      bike_memset(c2[j], 0, 2 * half_qw_len * sizeof(uint64_t));
+    }
+  }
+}
+
+// The layout of the top level of a product in the secure buffer:
+//   pad | lo | pad | hi | pad | mid | pad | alah | blbh
+#define TOP_LO_OFFSET  (TOP_PAD_QWORDS)
+#define TOP_HI_OFFSET  (TOP_LO_OFFSET + 2 * TOP_HALF_QWORDS + TOP_PAD_QWORDS)
+#define TOP_MID_OFFSET (TOP_HI_OFFSET + 2 * TOP_HALF_QWORDS + TOP_PAD_QWORDS)
+#define TOP_SUM_OFFSET (TOP_MID_OFFSET + 2 * TOP_HALF_QWORDS + TOP_PAD_QWORDS)
+
+// The (unreduced) lo, hi, and mid products of the top level, with the
+// paddings between them.
+#define TOP_PRODS_QWORDS (TOP_MID_OFFSET + 2 * TOP_HALF_QWORDS - TOP_LO_OFFSET)
+
+// The arguments of a call to karatzuba that is executed as a task
+typedef struct karatzuba_task_s {
+  uint64_t *const *       c;
+  const uint64_t *const * a;
+  const uint64_t *const * b;
+  const uint64_t *const * sums;
+  size_t                  n;
+  size_t                  qwords_len;
+  uint64_t *              sec_buf;
+  const gf2x_ctx *        ctx;
+} karatzuba_task_t;
+
+static void karatzuba_task(void *arg)
+{
+  const karatzuba_task_t *t = (const karatzuba_task_t *)arg;
+
+  karatzuba(t->c, t->a, t->b, t->sums, t->n, t->qwords_len, TOP_HALF_QWORDS,
+            t->sec_buf, t->ctx);
+}
+
+// Compute the top level of the Karatsuba multiplication of the n independent
+// products a[j]*b[j], that is, the three products
+//   lo = a_lo*b_lo, hi = a_hi*b_hi, mid = (a_lo + a_hi)*(b_lo + b_hi),
+// of product j are written to &secure_buffer[j * TOP_QWORDS], see the layout
+// above. The final step (adding the three products) is left to the callers,
+// which fuse it with the reduction mod (x^r - 1) (see karatzuba_red).
+// The secure_buffer holds n * SECURE_BUFFER_QWORDS qwords.
+// When sums is not NULL, sums[j] holds the prepared half-sums of a[j].
+_INLINE_ void mul_top_xn(IN const pad_r_t *const a[],
+                         IN const pad_r_t *const b[],
+                         IN const uint64_t *const sums[],
+                         IN const size_t         n,
+                         OUT uint64_t           *secure_buffer,
+                         IN const gf2x_ctx *ctx)
+{
+  bike_static_assert((R_PADDED_BYTES % 2 == 0), karatzuba_n_is_odd);
+  // a_hi and b_hi are not zero
+  bike_static_assert((R_QWORDS > TOP_HALF_QWORDS), karatzuba_top_level);
+  bike_static_assert((TOP_PAD_QWORDS >= QWORDS_IN_ZMM), karatzuba_top_pad);
+  bike_static_assert((TOP_SUM_OFFSET + 2 * TOP_HALF_QWORDS == TOP_QWORDS),
+                     karatzuba_top_layout);
+  // The prepared half-sums start at the top level
+  bike_static_assert((2 * TOP_HALF_QWORDS == R_PADDED_QWORDS),
+                     karatzuba_top_prepared);
+
+  const uint64_t *a_lo[GF2X_MUL_MAX_BATCH], *b_lo[GF2X_MUL_MAX_BATCH];
+  const uint64_t *a_hi[GF2X_MUL_MAX_BATCH], *b_hi[GF2X_MUL_MAX_BATCH];
+  const uint64_t *alah_in[GF2X_MUL_MAX_BATCH], *blbh_in[GF2X_MUL_MAX_BATCH];
+  uint64_t       *lo[GF2X_MUL_MAX_BATCH], *hi[GF2X_MUL_MAX_BATCH];
+  uint64_t       *mid[GF2X_MUL_MAX_BATCH];
+  uint64_t       *alah[GF2X_MUL_MAX_BATCH], *blbh[GF2X_MUL_MAX_BATCH];
+
+  // The prepared half-sums of a_lo, a_hi, and alah (if any)
+  const uint64_t        *child[3][GF2X_MUL_MAX_BATCH];
+  const uint64_t *const *sums_lo =
+    prepared_child(child[0], sums, n, R_PADDED_QWORDS, 0);
+  const uint64_t *const *sums_hi =
+    prepared_child(child[1], sums, n, R_PADDED_QWORDS, 1);
+  const uint64_t *const *sums_mid =
+    prepared_child(child[2], sums, n, R_PADDED_QWORDS, 2);
+
+  for(size_t j = 0; j < n; j++) {
+    uint64_t *top = &secure_buffer[j * TOP_QWORDS];
+
+    lo[j]   = &top[TOP_LO_OFFSET];
+    hi[j]   = &top[TOP_HI_OFFSET];
+    mid[j]  = &top[TOP_MID_OFFSET];
+    alah[j] = &top[TOP_SUM_OFFSET];
+    blbh[j] = &alah[j][TOP_HALF_QWORDS];
+
+    // Zero the paddings that surround lo, hi, and mid
+    for(size_t i = 0; i < 4; i++) {
+      bike_memset(&top[i * (TOP_PAD_QWORDS + 2 * TOP_HALF_QWORDS)], 0,
+                  TOP_PAD_QWORDS * sizeof(uint64_t));
+    }
+
+    a_lo[j]    = (const uint64_t *)a[j];
+    b_lo[j]    = (const uint64_t *)b[j];
+    a_hi[j]    = &a_lo[j][TOP_HALF_QWORDS];
+    b_hi[j]    = &b_lo[j][TOP_HALF_QWORDS];
+    alah_in[j] = (sums != NULL) ? sums[j] : alah[j];
+    blbh_in[j] = blbh[j];
+  }
+
+  for(size_t j = 0; j < n; j++) {
+    if(sums != NULL) {
+      ctx->karatzuba_add2(blbh[j], b_lo[j], b_hi[j], TOP_HALF_QWORDS);
+    } else {
+      ctx->karatzuba_add1(alah[j], blbh[j], a_lo[j], b_lo[j],
+                          TOP_HALF_QWORDS);
+    }
+  }
+
+  // The buffers of the recursive calls follow the top levels of all products
+  uint64_t *sec_buf[TOP_REC_BUFS];
+  for(size_t i = 0; i < TOP_REC_BUFS; i++) {
+    sec_buf[i] = &secure_buffer[(n * TOP_QWORDS) + (i * n * REC_QWORDS)];
+  }
+
+  // lo = a_lo*b_lo, hi = a_hi*b_hi, mid = (a_lo + a_hi)*(b_lo + b_hi).
+  // The three products are independent (see parallel.h).
+  karatzuba_task_t args[3] = {
+    {lo, a_lo, b_lo, sums_lo, n, TOP_HALF_QWORDS, sec_buf[0], ctx},
+    {hi, a_hi, b_hi, sums_hi, n, R_QWORDS - TOP_HALF_QWORDS,
+     sec_buf[1 % TOP_REC_BUFS], ctx},
+    {mid, alah_in, blbh_in, sums_mid, n, TOP_HALF_QWORDS,
+     sec_buf[2 % TOP_REC_BUFS], ctx}};
+
+  const par_task_t tasks[3] = {{karatzuba_task, &args[0]},
+                               {karatzuba_task, &args[1]},
+                               {karatzuba_task, &args[2]}};
+  par_run(tasks, 3);
+}
+
+// c[j] = a[j]*b[j] mod (x^r - 1) for 0 <= j < n.
+// The final step of the top level of the Karatsuba multiplication is fused
+// with the reduction mod (x^r - 1). The result is written directly to c[j],
+// without the intermediate double-width product.
+// Note: c[j] may alias any a[i] or b[i]; the outputs are written only after
+// the last use of the inputs.
+_INLINE_ void mod_mul_xn(OUT pad_r_t *const c[],
+                         IN const pad_r_t *const a[],
+                         IN const pad_r_t *const b[],
+                         IN const uint64_t *const sums[],
+                         IN const size_t         n,
+                         OUT uint64_t           *secure_buffer,
+                         IN const gf2x_ctx *ctx)
+{
+  mul_top_xn(a, b, sums, n, secure_buffer, ctx);
+
+  for(size_t j = 0; j < n; j++) {
+    const uint64_t *top = &secure_buffer[j * TOP_QWORDS];
+
+    ctx->karatzuba_red(c[j], &top[TOP_LO_OFFSET], &top[TOP_HI_OFFSET],
+                       &top[TOP_MID_OFFSET]);
+  }
+}
+
+// c = sum_{j < n} a[j]*b[j] mod (x^r - 1), where a[j] is given either
+// in a (when p is NULL), or prepared in p[j].
+// The reduction is linear, therefore, the unreduced top-level products of
+// all the pairs are accumulated, and reduced only once. The products are
+// computed in pairs (see mod_mul_xn).
+// The secure_buffer holds TOP_QWORDS + 2 * SECURE_BUFFER_QWORDS qwords
+// (2 * SECURE_BUFFER_QWORDS suffice when n <= 2).
+// Note: c may alias any a[j] or b[j].
+_INLINE_ void mod_mul_acc(OUT pad_r_t *c,
+                          IN const pad_r_t *const a[],
+                          IN const gf2x_prepared_t *const p[],
+                          IN const pad_r_t *const b[],
+                          IN const size_t         n,
+                          OUT uint64_t           *secure_buffer,
+                          IN const gf2x_ctx *ctx)
+{
+  // The empty sum
+  if(n == 0) {
+    bike_memset(c, 0, sizeof(*c));
+    return;
+  }
+
+  // The products of the first pair are accumulated into the top level of
+  // the first product, and the next pairs are computed right after it.
+  uint64_t *acc = secure_buffer;
+
+  for(size_t i = 0; i < n; i += 2) {
+    const size_t num_prods = ((n - i) < 2) ? (n - i) : 2;
+    uint64_t    *work      = (i == 0) ? acc : &secure_buffer[TOP_QWORDS];
+
+    const pad_r_t * a_in[2];
+    const uint64_t *sums[2];
+    for(size_t j = 0; j < num_prods; j++) {
+      a_in[j] = (p != NULL) ? &p[i + j]->a : a[i + j];
+      sums[j] = (p != NULL) ? p[i + j]->sums : NULL;
+    }
+
+    mul_top_xn(a_in, &b[i], (p != NULL) ? sums : NULL, num_prods, work, ctx);
+
+    // Add lo, hi, and mid (and the zero paddings between them) to acc
+    for(size_t j = (i == 0) ? 1 : 0; j < num_prods; j++) {
+      ctx->karatzuba_add2(&acc[TOP_LO_OFFSET], &acc[TOP_LO_OFFSET],
+                          &work[(j * TOP_QWORDS) + TOP_LO_OFFSET],
+                          TOP_PRODS_QWORDS);
+    }
   }
+
+  ctx->karatzuba_red(c, &acc[TOP_LO_OFFSET], &acc[TOP_HI_OFFSET],
+                     &acc[TOP_MID_OFFSET]);
 }
 
 void gf2x_mod_mul_with_ctx(OUT pad_r_t *c,
@@ -88,15 +451,9 @@ void gf2x_mod_mul_with_ctx(OUT pad_r_t *c,
                            IN const pad_r_t *b,
                            IN const gf2x_ctx *ctx)
 {
-  bike_static_assert((R_PADDED_BYTES % 2 == 0), karatzuba_n_is_odd);
-
-  DEFER_CLEANUP(dbl_pad_r_t t = {0}, dbl_pad_r_cleanup);
   ALIGN(ALIGN_BYTES) uint64_t secure_buffer[SECURE_BUFFER_QWORDS];
 
-  karatzuba((uint64_t *)&t, (const uint64_t *)a, (const uint64_t *)b, R_QWORDS,
-            R_PADDED_QWORDS, secure_buffer, ctx);
-
-  ctx->red(c, &t);
+  mod_mul_xn(&c, &a, &b, NULL, 1, secure_buffer, ctx);
 
   secure_clean((uint8_t *)secure_buffer, sizeof(secure_buffer));
 }
@@ -111,3 +468,118 @@ void gf2x_mod_mul(OUT pad_r_t *c, IN const pad_r_t *a, IN const pad_r_t *b)
 
   gf2x_mod_mul_with_ctx(c, a, b, &ctx);
 }
+
+void gf2x_mod_mul_x2(OUT pad_r_t *const c[2],
+                     IN const pad_r_t *const a[2],
+                     IN const pad_r_t *const b[2])
+{
+  ALIGN(ALIGN_BYTES) uint64_t secure_buffer[2 * SECURE_BUFFER_QWORDS];
+
+  // Initialize gf2x methods struct
+  gf2x_ctx ctx;
+  gf2x_ctx_init(&ctx);
+
+  mod_mul_xn(c, a, b, NULL, 2, secure_buffer, &ctx);
+
+  secure_clean((uint8_t *)secure_buffer, sizeof(secure_buffer));
+}
+
+void gf2x_mod_mul_x4(OUT pad_r_t *const c[4],
+                     IN const pad_r_t *const a[4],
+                     IN const pad_r_t *const b[4])
+{
+  ALIGN(ALIGN_BYTES) uint64_t secure_buffer[4 * SECURE_BUFFER_QWORDS];
+
+  // Initialize gf2x methods struct
+  gf2x_ctx ctx;
+  gf2x_ctx_init(&ctx);
+
+  mod_mul_xn(c, a, b, NULL, 4, secure_buffer, &ctx);
+
+  secure_clean((uint8_t *)secure_buffer, sizeof(secure_buffer));
+}
+
+void gf2x_prepare(IN const pad_r_t *a, OUT gf2x_prepared_t *p)
+{
+  bike_static_assert((GF2X_PREPARED_SUMS_QWORDS > 0), gf2x_prepared_sums);
+  bike_static_assert((R_PADDED_QWORDS <= (GF2X_PREPARED_MIN_QWORDS << 6)),
+                     gf2x_prepared_levels);
+  bike_static_assert(
+    (PREPARED_SUMS_6(R_PADDED_QWORDS) == GF2X_PREPARED_SUMS_QWORDS),
+    gf2x_prepared_sums_layout);
+
+  // Initialize gf2x methods struct
+  gf2x_ctx ctx;
+  gf2x_ctx_init(&ctx);
+
+  p->a = *a;
+  prepare_sums(p->sums, (const uint64_t *)&p->a, R_PADDED_QWORDS, &ctx);
+}
+
+void gf2x_mod_mul_prepared(OUT pad_r_t *c,
+                           IN const gf2x_prepared_t *p,
+                           IN const pad_r_t *b)
+{
+  ALIGN(ALIGN_BYTES) uint64_t secure_buffer[SECURE_BUFFER_QWORDS];
+
+  // Initialize gf2x methods struct
+  gf2x_ctx ctx;
+  gf2x_ctx_init(&ctx);
+
+  const pad_r_t * a    = &p->a;
+  const uint64_t *sums = p->sums;
+  mod_mul_xn(&c, &a, &b, &sums, 1, secure_buffer, &ctx);
+
+  secure_clean((uint8_t *)secure_buffer, sizeof(secure_buffer));
+}
+
+void gf2x_mod_mul_prepared_x2(OUT pad_r_t *const c[2],
+                              IN const gf2x_prepared_t *const p[2],
+                              IN const pad_r_t *const b[2])
+{
+  ALIGN(ALIGN_BYTES) uint64_t secure_buffer[2 * SECURE_BUFFER_QWORDS];
+
+  // Initialize gf2x methods struct
+  gf2x_ctx ctx;
+  gf2x_ctx_init(&ctx);
+
+  const pad_r_t * a[2]    = {&p[0]->a, &p[1]->a};
+  const uint64_t *sums[2] = {p[0]->sums, p[1]->sums};
+  mod_mul_xn(c, a, b, sums, 2, secure_buffer, &ctx);
+
+  secure_clean((uint8_t *)secure_buffer, sizeof(secure_buffer));
+}
+
+void gf2x_mod_mul_acc(OUT pad_r_t *c,
+                      IN const pad_r_t *const a[],
+                      IN const pad_r_t *const b[],
+                      IN const size_t         n)
+{
+  ALIGN(ALIGN_BYTES)
+  uint64_t secure_buffer[TOP_QWORDS + (2 * SECURE_BUFFER_QWORDS)];
+
+  // Initialize gf2x methods struct
+  gf2x_ctx ctx;
+  gf2x_ctx_init(&ctx);
+
+  mod_mul_acc(c, a, NULL, b, n, secure_buffer, &ctx);
+
+  secure_clean((uint8_t *)secure_buffer, sizeof(secure_buffer));
+}
+
+void gf2x_mod_mul_prepared_acc(OUT pad_r_t *c,
+                               IN const gf2x_prepared_t *const p[],
+                               IN const pad_r_t *const b[],
+                               IN const size_t         n)
+{
+  ALIGN(ALIGN_BYTES)
+  uint64_t secure_buffer[TOP_QWORDS + (2 * SECURE_BUFFER_QWORDS)];
+
+  // Initialize gf2x methods struct
+  gf2x_ctx ctx;
+  gf2x_ctx_init(&ctx);
+
+  mod_mul_acc(c, NULL, p, b, n, secure_buffer, &ctx);
+
+  secure_clean((uint8_t *)secure_buffer, sizeof(secure_buffer));
+}
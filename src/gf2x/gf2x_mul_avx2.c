@@ -76,6 +76,64 @@ void karatzuba_add3_avx2(OUT uint64_t *c,
   }
 }
 
+// Return the qwords q, ..., q + REG_QWORDS - 1 of the product
+//   (hi * x^(2h) + (mid + lo + hi) * x^h + lo), with h = GF2X_TOP_HALF_QWORDS.
+// The digits of lo, hi, and mid that are outside [0, 2h) are considered
+// to be zero (the buffers are surrounded by zero qwords, so a register that
+// crosses the boundary of a buffer is loaded correctly).
+_INLINE_ REG_T karatzuba_prod_avx2(IN const uint64_t *lo,
+                                   IN const uint64_t *hi,
+                                   IN const uint64_t *mid,
+                                   IN const size_t    q)
+{
+  const ptrdiff_t h  = GF2X_TOP_HALF_QWORDS;
+  const ptrdiff_t iq = (ptrdiff_t)q;
+  REG_T           p;
+
+  if(iq < 2 * h) {
+    p = LOAD(&lo[iq]);
+    if(iq + (ptrdiff_t)REG_QWORDS > 2 * h) {
+      p ^= LOAD(&hi[iq - (2 * h)]);
+    }
+  } else {
+    p = LOAD(&hi[iq - (2 * h)]);
+  }
+
+  if((iq + (ptrdiff_t)REG_QWORDS > h) && (iq < 3 * h)) {
+    p ^= LOAD(&mid[iq - h]) ^ LOAD(&lo[iq - h]) ^ LOAD(&hi[iq - h]);
+  }
+
+  return p;
+}
+
+// c = (hi * x^(2h) + (mid + lo + hi) * x^h + lo) mod (x^r - 1)
+void karatzuba_red_avx2(OUT pad_r_t *c,
+                        IN const uint64_t *lo,
+                        IN const uint64_t *hi,
+                        IN const uint64_t *mid)
+{
+  uint64_t *c64 = (uint64_t *)c;
+
+  for(size_t i = 0; i < R_QWORDS; i += REG_QWORDS) {
+    REG_T vt0 = karatzuba_prod_avx2(lo, hi, mid, i);
+    REG_T vt1 = karatzuba_prod_avx2(lo, hi, mid, i + R_QWORDS);
+    REG_T vt2 = karatzuba_prod_avx2(lo, hi, mid, i + R_QWORDS - 1);
+
+    vt1 = SLLI_I64(vt1, LAST_R_QWORD_TRAIL);
+    vt2 = SRLI_I64(vt2, LAST_R_QWORD_LEAD);
+
+    vt0 ^= (vt1 | vt2);
+
+    STORE(&c64[i], vt0);
+  }
+
+  c64[R_QWORDS - 1] &= LAST_R_QWORD_MASK;
+
+  // Clean the secrets from the upper part of c
+  secure_clean((uint8_t *)&c64[R_QWORDS],
+               (R_PADDED_QWORDS - R_QWORDS) * sizeof(uint64_t));
+}
+
 // c = a mod (x^r - 1)
 void gf2x_red_avx2(OUT pad_r_t *c, IN const dbl_pad_r_t *a)
 {
@@ -7,6 +7,7 @@
 
 #include <immintrin.h>
 
+#include "cleanup.h"
 #include "gf2x_internal.h"
 
 #define LOAD128(mem)       _mm_loadu_si128((const void *)(mem))
@@ -16,6 +17,8 @@
 #define CLMUL(x, y, imm)   _mm_clmulepi64_si128((x), (y), (imm))
 #define BSRLI(x, imm)      _mm_bsrli_si128((x), (imm))
 #define BSLLI(x, imm)      _mm_bslli_si128((x), (imm))
+#define SLLI_I64(x, imm)   _mm_slli_epi64((x), (imm))
+#define SRLI_I64(x, imm)   _mm_srli_epi64((x), (imm))
 
 // 4x4 Karatsuba multiplication
 _INLINE_ void gf2x_mul4_int(OUT __m128i      c[4],
@@ -88,46 +91,73 @@ _INLINE_ void gf2x_mul4_int(OUT __m128i      c[4],
 
 // 512x512bit multiplication performed by Karatsuba algorithm
 // where a and b are considered as having 8 digits of size 64 bits.
-void gf2x_mul_base_pclmul(OUT uint64_t *c,
-                          IN const uint64_t *a,
-                          IN const uint64_t *b)
+// The n independent products are computed in lock-step, so that the
+// CLMUL instructions of the different products are interleaved.
+_INLINE_ void gf2x_mul_base_xn_int(OUT uint64_t *const c[],
+                                   IN const uint64_t *const a[],
+                                   IN const uint64_t *const b[],
+                                   IN const size_t          n)
 {
-  __m128i va[4], vb[4];
-  __m128i aa[2], bb[2];
-  __m128i lo[4], hi[4], mi[4], m[2];
+  __m128i va[2][4], vb[2][4];
+  __m128i aa[2][2], bb[2][2];
+  __m128i lo[2][4], hi[2][4], mi[2][4], m[2][2];
 
-  for(size_t i = 0; i < 4; i++) {
-    va[i] = LOAD128(&a[QWORDS_IN_XMM * i]);
-    vb[i] = LOAD128(&b[QWORDS_IN_XMM * i]);
+  for(size_t j = 0; j < n; j++) {
+    for(size_t i = 0; i < 4; i++) {
+      va[j][i] = LOAD128(&a[j][QWORDS_IN_XMM * i]);
+      vb[j][i] = LOAD128(&b[j][QWORDS_IN_XMM * i]);
+    }
   }
 
   // Multiply the low and the high halves of a and b
   // lo <-- a_lo * b_lo
   // hi <-- a_hi * b_hi
-  gf2x_mul4_int(lo, va[0], va[1], vb[0], vb[1]);
-  gf2x_mul4_int(hi, va[2], va[3], vb[2], vb[3]);
+  for(size_t j = 0; j < n; j++) {
+    gf2x_mul4_int(lo[j], va[j][0], va[j][1], vb[j][0], vb[j][1]);
+  }
+  for(size_t j = 0; j < n; j++) {
+    gf2x_mul4_int(hi[j], va[j][2], va[j][3], vb[j][2], vb[j][3]);
+  }
 
   // Compute the middle multiplication
   // aa <-- a_lo + a_hi
   // bb <-- b_lo + b_hi
   // mi <-- aa * bb
-  aa[0] = va[0] ^ va[2];
-  aa[1] = va[1] ^ va[3];
-  bb[0] = vb[0] ^ vb[2];
-  bb[1] = vb[1] ^ vb[3];
-  gf2x_mul4_int(mi, aa[0], aa[1], bb[0], bb[1]);
-
-  m[0] = lo[2] ^ hi[0];
-  m[1] = lo[3] ^ hi[1];
-
-  STORE128(&c[0 * QWORDS_IN_XMM], lo[0]);
-  STORE128(&c[1 * QWORDS_IN_XMM], lo[1]);
-  STORE128(&c[2 * QWORDS_IN_XMM], mi[0] ^ lo[0] ^ m[0]);
-  STORE128(&c[3 * QWORDS_IN_XMM], mi[1] ^ lo[1] ^ m[1]);
-  STORE128(&c[4 * QWORDS_IN_XMM], mi[2] ^ hi[2] ^ m[0]);
-  STORE128(&c[5 * QWORDS_IN_XMM], mi[3] ^ hi[3] ^ m[1]);
-  STORE128(&c[6 * QWORDS_IN_XMM], hi[2]);
-  STORE128(&c[7 * QWORDS_IN_XMM], hi[3]);
+  for(size_t j = 0; j < n; j++) {
+    aa[j][0] = va[j][0] ^ va[j][2];
+    aa[j][1] = va[j][1] ^ va[j][3];
+    bb[j][0] = vb[j][0] ^ vb[j][2];
+    bb[j][1] = vb[j][1] ^ vb[j][3];
+    gf2x_mul4_int(mi[j], aa[j][0], aa[j][1], bb[j][0], bb[j][1]);
+  }
+
+  for(size_t j = 0; j < n; j++) {
+    m[j][0] = lo[j][2] ^ hi[j][0];
+    m[j][1] = lo[j][3] ^ hi[j][1];
+
+    STORE128(&c[j][0 * QWORDS_IN_XMM], lo[j][0]);
+    STORE128(&c[j][1 * QWORDS_IN_XMM], lo[j][1]);
+    STORE128(&c[j][2 * QWORDS_IN_XMM], mi[j][0] ^ lo[j][0] ^ m[j][0]);
+    STORE128(&c[j][3 * QWORDS_IN_XMM], mi[j][1] ^ lo[j][1] ^ m[j][1]);
+    STORE128(&c[j][4 * QWORDS_IN_XMM], mi[j][2] ^ hi[j][2] ^ m[j][0]);
+    STORE128(&c[j][5 * QWORDS_IN_XMM], mi[j][3] ^ hi[j][3] ^ m[j][1]);
+    STORE128(&c[j][6 * QWORDS_IN_XMM], hi[j][2]);
+    STORE128(&c[j][7 * QWORDS_IN_XMM], hi[j][3]);
+  }
+}
+
+void gf2x_mul_base_pclmul(OUT uint64_t *c,
+                          IN const uint64_t *a,
+                          IN const uint64_t *b)
+{
+  gf2x_mul_base_xn_int(&c, &a, &b, 1);
+}
+
+void gf2x_mul_base_x2_pclmul(OUT uint64_t *const c[2],
+                             IN const uint64_t *const a[2],
+                             IN const uint64_t *const b[2])
+{
+  gf2x_mul_base_xn_int(c, a, b, 2);
 }
 
 void gf2x_sqr_pclmul(OUT dbl_pad_r_t *c, IN const pad_r_t *a)
@@ -147,3 +177,85 @@ void gf2x_sqr_pclmul(OUT dbl_pad_r_t *c, IN const pad_r_t *a)
     STORE128(&c64[i * 2 + QWORDS_IN_XMM], vr1);
   }
 }
+
+// The number of qwords of c that are written by sqr_red_pclmul
+#define SQR_RED_QWORDS (DIVIDE_AND_CEIL(R_QWORDS, 2 * QWORDS_IN_XMM) * 4)
+
+bike_static_assert((SQR_RED_QWORDS <= R_PADDED_QWORDS), sqr_red_pclmul_size);
+
+// Qword j of a^2 is the square of dword j of a. Therefore, qwords
+// j, ..., j+3 of a^2 (for any j, not necessarily even) are computed
+// from the four dwords of a that start at dword j.
+_INLINE_ void sqr4(OUT __m128i s[2], IN const uint32_t *a32, IN const size_t j)
+{
+  const __m128i va = LOAD128(&a32[j]);
+
+  s[0] = CLMUL(va, va, 0x00);
+  s[1] = CLMUL(va, va, 0x11);
+}
+
+// c = a^2 mod (x^r - 1), the squares are reduced as they are computed,
+// see gf2x_red_avx2. The loop writes the qwords of c up to
+// SQR_RED_QWORDS, the remaining upper part of c is not touched.
+_INLINE_ void sqr_red_pclmul(OUT pad_r_t *c, IN const pad_r_t *a)
+{
+  __m128i vt0[2], vt1[2], vt2[2];
+
+  const uint32_t *a32 = (const uint32_t *)a;
+  uint64_t       *c64 = (uint64_t *)c;
+
+  for(size_t i = 0; i < R_QWORDS; i += 2 * QWORDS_IN_XMM) {
+    sqr4(vt0, a32, i);
+    sqr4(vt1, a32, i + R_QWORDS);
+    sqr4(vt2, a32, i + R_QWORDS - 1);
+
+    for(size_t j = 0; j < 2; j++) {
+      vt1[j] = SLLI_I64(vt1[j], LAST_R_QWORD_TRAIL);
+      vt2[j] = SRLI_I64(vt2[j], LAST_R_QWORD_LEAD);
+
+      STORE128(&c64[i + (j * QWORDS_IN_XMM)], vt0[j] ^ vt1[j] ^ vt2[j]);
+    }
+  }
+
+  c64[R_QWORDS - 1] &= LAST_R_QWORD_MASK;
+  for(size_t i = R_QWORDS; i < SQR_RED_QWORDS; i++) {
+    c64[i] = 0;
+  }
+}
+
+void gf2x_sqr_red_pclmul(OUT pad_r_t *c, IN const pad_r_t *a)
+{
+  sqr_red_pclmul(c, a);
+
+  // Clean the secrets from the upper part of c
+  uint64_t *c64 = (uint64_t *)c;
+  secure_clean((uint8_t *)&c64[R_QWORDS],
+               (R_PADDED_QWORDS - R_QWORDS) * sizeof(uint64_t));
+}
+
+void gf2x_sqr_red_k_pclmul(OUT pad_r_t *c,
+                           IN const pad_r_t *a,
+                           IN const size_t   num_sqrs)
+{
+  DEFER_CLEANUP(pad_r_t t = {0}, pad_r_cleanup);
+
+  // c is also an input of the intermediate squarings
+  uint64_t *c64 = (uint64_t *)c;
+  secure_clean((uint8_t *)&c64[R_QWORDS],
+               (R_PADDED_QWORDS - R_QWORDS) * sizeof(uint64_t));
+
+  if(num_sqrs == 0) {
+    c->val = a->val;
+    return;
+  }
+
+  // Alternate between c and t such that the last squaring is written to c
+  const pad_r_t *src = a;
+  pad_r_t       *dst = (num_sqrs & 1) ? c : &t;
+
+  for(size_t i = 0; i < num_sqrs; i++) {
+    sqr_red_pclmul(dst, src);
+    src = dst;
+    dst = (dst == c) ? &t : c;
+  }
+}
@@ -0,0 +1,262 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ *
+ * The AArch64 counterpart of gf2x_mul_base_pclmul.c: PMULL/PMULL2 compute
+ * the carry-less product of the low (resp. high) qwords of two registers,
+ * like PCLMULQDQ with the immediate 0x00 (resp. 0x11).
+ */
+
+#include "cleanup.h"
+#include "gf2x_internal.h"
+
+#include "aarch64_intrinsic.h"
+
+// The loads and stores go through bytes, because the pointers (e.g., the
+// dwords of sqr4) are not necessarily aligned to 8 bytes.
+#define LOAD128(mem)       vreinterpretq_u64_u8(vld1q_u8((const uint8_t *)(mem)))
+#define STORE128(mem, reg) vst1q_u8((uint8_t *)(mem), vreinterpretq_u8_u64(reg))
+#define UNPACKLO(x, y)     vzip1q_u64((x), (y))
+#define UNPACKHI(x, y)     vzip2q_u64((x), (y))
+#define BSRLI8(x)          vextq_u64((x), vdupq_n_u64(0), 1)
+#define BSLLI8(x)          vextq_u64(vdupq_n_u64(0), (x), 1)
+#define SLLI_I64(x, imm)   vshlq_n_u64((x), (imm))
+#define SRLI_I64(x, imm)   vshrq_n_u64((x), (imm))
+
+#define CLMUL_LO(x, y)                                            \
+  vreinterpretq_u64_p128(vmull_p64((poly64_t)vgetq_lane_u64(x, 0), \
+                                   (poly64_t)vgetq_lane_u64(y, 0)))
+#define CLMUL_HI(x, y)                                      \
+  vreinterpretq_u64_p128(vmull_high_p64(vreinterpretq_p64_u64(x), \
+                                        vreinterpretq_p64_u64(y)))
+
+// 4x4 Karatsuba multiplication, see gf2x_mul4_int in gf2x_mul_base_pclmul.c
+_INLINE_ void gf2x_mul4_int(OUT uint64x2_t      c[4],
+                            IN const uint64x2_t a_lo,
+                            IN const uint64x2_t a_hi,
+                            IN const uint64x2_t b_lo,
+                            IN const uint64x2_t b_hi)
+{
+  uint64x2_t aa, bb;
+  uint64x2_t xx, yy, uu, vv, m;
+  uint64x2_t lo[2], hi[2], mi[2];
+  uint64x2_t t[9];
+
+  aa = a_lo ^ a_hi;
+  bb = b_lo ^ b_hi;
+
+  // xx <-- [(a2+a3) | (a0+a1)]
+  // yy <-- [(b2+b3) | (b0+b1)]
+  xx = UNPACKLO(a_lo, a_hi);
+  yy = UNPACKLO(b_lo, b_hi);
+  xx = xx ^ UNPACKHI(a_lo, a_hi);
+  yy = yy ^ UNPACKHI(b_lo, b_hi);
+
+  // uu <-- [ 0 | (aa0+aa1)]
+  // vv <-- [ 0 | (bb0+bb1)]
+  uu = aa ^ BSRLI8(aa);
+  vv = bb ^ BSRLI8(bb);
+
+  // 9 multiplications
+  t[0] = CLMUL_LO(a_lo, b_lo);
+  t[1] = CLMUL_HI(a_lo, b_lo);
+  t[2] = CLMUL_LO(a_hi, b_hi);
+  t[3] = CLMUL_HI(a_hi, b_hi);
+  t[4] = CLMUL_LO(xx, yy);
+  t[5] = CLMUL_HI(xx, yy);
+  t[6] = CLMUL_LO(aa, bb);
+  t[7] = CLMUL_HI(aa, bb);
+  t[8] = CLMUL_LO(uu, vv);
+
+  t[4] ^= (t[0] ^ t[1]);
+  t[5] ^= (t[2] ^ t[3]);
+  t[8] ^= (t[6] ^ t[7]);
+
+  lo[0] = t[0] ^ BSLLI8(t[4]);
+  lo[1] = t[1] ^ BSRLI8(t[4]);
+  hi[0] = t[2] ^ BSLLI8(t[5]);
+  hi[1] = t[3] ^ BSRLI8(t[5]);
+  mi[0] = t[6] ^ BSLLI8(t[8]);
+  mi[1] = t[7] ^ BSRLI8(t[8]);
+
+  m = lo[1] ^ hi[0];
+
+  c[0] = lo[0];
+  c[1] = lo[0] ^ mi[0] ^ m;
+  c[2] = hi[1] ^ mi[1] ^ m;
+  c[3] = hi[1];
+}
+
+// 512x512bit multiplication performed by Karatsuba algorithm
+// where a and b are considered as having 8 digits of size 64 bits.
+// The n independent products are computed in lock-step, so that the
+// PMULL instructions of the different products are interleaved.
+_INLINE_ void gf2x_mul_base_xn_int(OUT uint64_t *const c[],
+                                   IN const uint64_t *const a[],
+                                   IN const uint64_t *const b[],
+                                   IN const size_t          n)
+{
+  uint64x2_t va[2][4], vb[2][4];
+  uint64x2_t aa[2][2], bb[2][2];
+  uint64x2_t lo[2][4], hi[2][4], mi[2][4], m[2][2];
+
+  for(size_t j = 0; j < n; j++) {
+    for(size_t i = 0; i < 4; i++) {
+      va[j][i] = LOAD128(&a[j][QWORDS_IN_NEON * i]);
+      vb[j][i] = LOAD128(&b[j][QWORDS_IN_NEON * i]);
+    }
+  }
+
+  // Multiply the low and the high halves of a and b
+  // lo <-- a_lo * b_lo
+  // hi <-- a_hi * b_hi
+  for(size_t j = 0; j < n; j++) {
+    gf2x_mul4_int(lo[j], va[j][0], va[j][1], vb[j][0], vb[j][1]);
+  }
+  for(size_t j = 0; j < n; j++) {
+    gf2x_mul4_int(hi[j], va[j][2], va[j][3], vb[j][2], vb[j][3]);
+  }
+
+  // Compute the middle multiplication
+  // aa <-- a_lo + a_hi
+  // bb <-- b_lo + b_hi
+  // mi <-- aa * bb
+  for(size_t j = 0; j < n; j++) {
+    aa[j][0] = va[j][0] ^ va[j][2];
+    aa[j][1] = va[j][1] ^ va[j][3];
+    bb[j][0] = vb[j][0] ^ vb[j][2];
+    bb[j][1] = vb[j][1] ^ vb[j][3];
+    gf2x_mul4_int(mi[j], aa[j][0], aa[j][1], bb[j][0], bb[j][1]);
+  }
+
+  for(size_t j = 0; j < n; j++) {
+    m[j][0] = lo[j][2] ^ hi[j][0];
+    m[j][1] = lo[j][3] ^ hi[j][1];
+
+    STORE128(&c[j][0 * QWORDS_IN_NEON], lo[j][0]);
+    STORE128(&c[j][1 * QWORDS_IN_NEON], lo[j][1]);
+    STORE128(&c[j][2 * QWORDS_IN_NEON], mi[j][0] ^ lo[j][0] ^ m[j][0]);
+    STORE128(&c[j][3 * QWORDS_IN_NEON], mi[j][1] ^ lo[j][1] ^ m[j][1]);
+    STORE128(&c[j][4 * QWORDS_IN_NEON], mi[j][2] ^ hi[j][2] ^ m[j][0]);
+    STORE128(&c[j][5 * QWORDS_IN_NEON], mi[j][3] ^ hi[j][3] ^ m[j][1]);
+    STORE128(&c[j][6 * QWORDS_IN_NEON], hi[j][2]);
+    STORE128(&c[j][7 * QWORDS_IN_NEON], hi[j][3]);
+  }
+}
+
+void gf2x_mul_base_pmull(OUT uint64_t *c,
+                         IN const uint64_t *a,
+                         IN const uint64_t *b)
+{
+  gf2x_mul_base_xn_int(&c, &a, &b, 1);
+}
+
+void gf2x_mul_base_x2_pmull(OUT uint64_t *const c[2],
+                            IN const uint64_t *const a[2],
+                            IN const uint64_t *const b[2])
+{
+  gf2x_mul_base_xn_int(c, a, b, 2);
+}
+
+void gf2x_sqr_pmull(OUT dbl_pad_r_t *c, IN const pad_r_t *a)
+{
+  uint64x2_t va, vr0, vr1;
+
+  const uint64_t *a64 = (const uint64_t *)a;
+  uint64_t *      c64 = (uint64_t *)c;
+
+  for(size_t i = 0; i < (R_XMM * QWORDS_IN_NEON); i += QWORDS_IN_NEON) {
+    va = LOAD128(&a64[i]);
+
+    vr0 = CLMUL_LO(va, va);
+    vr1 = CLMUL_HI(va, va);
+
+    STORE128(&c64[i * 2], vr0);
+    STORE128(&c64[i * 2 + QWORDS_IN_NEON], vr1);
+  }
+}
+
+// The number of qwords of c that are written by sqr_red_pmull
+#define SQR_RED_QWORDS (DIVIDE_AND_CEIL(R_QWORDS, 2 * QWORDS_IN_NEON) * 4)
+
+bike_static_assert((SQR_RED_QWORDS <= R_PADDED_QWORDS), sqr_red_pmull_size);
+
+// Qword j of a^2 is the square of dword j of a. Therefore, qwords
+// j, ..., j+3 of a^2 (for any j, not necessarily even) are computed
+// from the four dwords of a that start at dword j.
+_INLINE_ void
+sqr4(OUT uint64x2_t s[2], IN const uint32_t *a32, IN const size_t j)
+{
+  const uint64x2_t va = LOAD128(&a32[j]);
+
+  s[0] = CLMUL_LO(va, va);
+  s[1] = CLMUL_HI(va, va);
+}
+
+// c = a^2 mod (x^r - 1), the squares are reduced as they are computed,
+// see sqr_red_pclmul. The loop writes the qwords of c up to
+// SQR_RED_QWORDS, the remaining upper part of c is not touched.
+_INLINE_ void sqr_red_pmull(OUT pad_r_t *c, IN const pad_r_t *a)
+{
+  uint64x2_t vt0[2], vt1[2], vt2[2];
+
+  const uint32_t *a32 = (const uint32_t *)a;
+  uint64_t       *c64 = (uint64_t *)c;
+
+  for(size_t i = 0; i < R_QWORDS; i += 2 * QWORDS_IN_NEON) {
+    sqr4(vt0, a32, i);
+    sqr4(vt1, a32, i + R_QWORDS);
+    sqr4(vt2, a32, i + R_QWORDS - 1);
+
+    for(size_t j = 0; j < 2; j++) {
+      vt1[j] = SLLI_I64(vt1[j], LAST_R_QWORD_TRAIL);
+      vt2[j] = SRLI_I64(vt2[j], LAST_R_QWORD_LEAD);
+
+      STORE128(&c64[i + (j * QWORDS_IN_NEON)], vt0[j] ^ vt1[j] ^ vt2[j]);
+    }
+  }
+
+  c64[R_QWORDS - 1] &= LAST_R_QWORD_MASK;
+  for(size_t i = R_QWORDS; i < SQR_RED_QWORDS; i++) {
+    c64[i] = 0;
+  }
+}
+
+void gf2x_sqr_red_pmull(OUT pad_r_t *c, IN const pad_r_t *a)
+{
+  sqr_red_pmull(c, a);
+
+  // Clean the secrets from the upper part of c
+  uint64_t *c64 = (uint64_t *)c;
+  secure_clean((uint8_t *)&c64[R_QWORDS],
+               (R_PADDED_QWORDS - R_QWORDS) * sizeof(uint64_t));
+}
+
+void gf2x_sqr_red_k_pmull(OUT pad_r_t *c,
+                          IN const pad_r_t *a,
+                          IN const size_t   num_sqrs)
+{
+  DEFER_CLEANUP(pad_r_t t = {0}, pad_r_cleanup);
+
+  // c is also an input of the intermediate squarings
+  uint64_t *c64 = (uint64_t *)c;
+  secure_clean((uint8_t *)&c64[R_QWORDS],
+               (R_PADDED_QWORDS - R_QWORDS) * sizeof(uint64_t));
+
+  if(num_sqrs == 0) {
+    c->val = a->val;
+    return;
+  }
+
+  // Alternate between c and t such that the last squaring is written to c
+  const pad_r_t *src = a;
+  pad_r_t       *dst = (num_sqrs & 1) ? c : &t;
+
+  for(size_t i = 0; i < num_sqrs; i++) {
+    sqr_red_pmull(dst, src);
+    src = dst;
+    dst = (dst == c) ? &t : c;
+  }
+}
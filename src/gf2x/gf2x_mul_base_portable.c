@@ -5,6 +5,7 @@
  * AWS Cryptographic Algorithms Group.
  */
 
+#include "cleanup.h"
 #include "gf2x_internal.h"
 #include "utilities.h"
 
@@ -74,6 +75,14 @@ void gf2x_mul_base_port(OUT uint64_t *c,
   c[1] = h;
 }
 
+void gf2x_mul_base_x2_port(OUT uint64_t *const c[2],
+                           IN const uint64_t *const a[2],
+                           IN const uint64_t *const b[2])
+{
+  gf2x_mul_base_port(c[0], a[0], b[0]);
+  gf2x_mul_base_port(c[1], a[1], b[1]);
+}
+
 // c = a^2
 void gf2x_sqr_port(OUT dbl_pad_r_t *c, IN const pad_r_t *a)
 {
@@ -84,3 +93,81 @@ void gf2x_sqr_port(OUT dbl_pad_r_t *c, IN const pad_r_t *a)
     gf2x_mul_base_port(&c64[2 * i], &a64[i], &a64[i]);
   }
 }
+
+// Spread the 32 bits of x to the even positions of a 64-bit word.
+// This is the square of x (as a polynomial over GF(2)).
+_INLINE_ uint64_t sqr32(IN uint64_t x)
+{
+  x = (x | (x << 16)) & 0x0000ffff0000ffffULL;
+  x = (x | (x << 8)) & 0x00ff00ff00ff00ffULL;
+  x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  x = (x | (x << 2)) & 0x3333333333333333ULL;
+  x = (x | (x << 1)) & 0x5555555555555555ULL;
+
+  return x;
+}
+
+// Qword q of a^2 (before the reduction)
+_INLINE_ uint64_t sqr_qword(IN const uint64_t *a64, IN const size_t q)
+{
+  return sqr32((a64[q >> 1] >> (32 * (q & 1))) & 0xffffffffULL);
+}
+
+// c = a^2 mod (x^r - 1), the squares are reduced as they are computed,
+// see gf2x_red_port. The upper part of c (above R_QWORDS) is not touched.
+_INLINE_ void sqr_red_port(OUT pad_r_t *c, IN const pad_r_t *a)
+{
+  const uint64_t *a64 = (const uint64_t *)a;
+  uint64_t       *c64 = (uint64_t *)c;
+
+  // Qword (i + R_QWORDS) of a^2 is qword (i + 1 + R_QWORDS - 1)
+  // of the next iteration, so it is computed only once.
+  uint64_t prev = sqr_qword(a64, R_QWORDS - 1);
+
+  for(size_t i = 0; i < R_QWORDS; i++) {
+    uint64_t next = sqr_qword(a64, i + R_QWORDS);
+
+    c64[i] = sqr_qword(a64, i) ^ (next << LAST_R_QWORD_TRAIL) ^
+             (prev >> LAST_R_QWORD_LEAD);
+    prev = next;
+  }
+
+  c64[R_QWORDS - 1] &= LAST_R_QWORD_MASK;
+}
+
+void gf2x_sqr_red_port(OUT pad_r_t *c, IN const pad_r_t *a)
+{
+  sqr_red_port(c, a);
+
+  // Clean the secrets from the upper part of c
+  uint64_t *c64 = (uint64_t *)c;
+  secure_clean((uint8_t *)&c64[R_QWORDS],
+               (R_PADDED_QWORDS - R_QWORDS) * sizeof(uint64_t));
+}
+
+void gf2x_sqr_red_k_port(OUT pad_r_t *c,
+                         IN const pad_r_t *a,
+                         IN const size_t   num_sqrs)
+{
+  DEFER_CLEANUP(pad_r_t t = {0}, pad_r_cleanup);
+
+  // c is also an input of the intermediate squarings
+  uint64_t *c64 = (uint64_t *)c;
+  secure_clean((uint8_t *)&c64[R_QWORDS],
+               (R_PADDED_QWORDS - R_QWORDS) * sizeof(uint64_t));
+
+  if(num_sqrs == 0) {
+    c->val = a->val;
+    return;
+  }
+
+  // Alternate between c and t such that the last squaring is written to c
+  const pad_r_t *src = a;
+  pad_r_t       *dst = (num_sqrs & 1) ? c : &t;
+
+  for(size_t i = 0; i < num_sqrs; i++) {
+    sqr_red_port(dst, src);
+    src = dst;
+    dst = (dst == c) ? &t : c;
+  }
+}
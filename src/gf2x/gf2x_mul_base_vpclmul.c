@@ -5,6 +5,7 @@
  * AWS Cryptographic Algorithms Group.
  */
 
+#include "cleanup.h"
 #include "gf2x_internal.h"
 
 #define AVX512_INTERNAL
@@ -84,27 +85,56 @@ _INLINE_ void gf2x_mul8_512_int(OUT __m512i *zh,
 
 // 1024x1024 bit multiplication performed by Karatsuba algorithm.
 // Here, a and b are considered as having 16 digits of size 64 bits.
-void gf2x_mul_base_vpclmul(OUT uint64_t *c,
-                           IN const uint64_t *a,
-                           IN const uint64_t *b)
+// The n independent products are computed in lock-step, so that the
+// CLMUL instructions of the different products are interleaved.
+_INLINE_ void gf2x_mul_base_xn_int(OUT uint64_t *const c[],
+                                   IN const uint64_t *const a[],
+                                   IN const uint64_t *const b[],
+                                   IN const size_t          n)
 {
-  const __m512i a0 = LOAD(a);
-  const __m512i a1 = LOAD(&a[QWORDS_IN_ZMM]);
-  const __m512i b0 = LOAD(b);
-  const __m512i b1 = LOAD(&b[QWORDS_IN_ZMM]);
+  __m512i va[2][2], vb[2][2];
+  __m512i hi[2][2], lo[2][2], mi[2][2];
+
+  for(size_t j = 0; j < n; j++) {
+    va[j][0] = LOAD(a[j]);
+    va[j][1] = LOAD(&a[j][QWORDS_IN_ZMM]);
+    vb[j][0] = LOAD(b[j]);
+    vb[j][1] = LOAD(&b[j][QWORDS_IN_ZMM]);
+  }
+
+  for(size_t j = 0; j < n; j++) {
+    gf2x_mul8_512_int(&lo[j][1], &lo[j][0], va[j][0], vb[j][0]);
+  }
+  for(size_t j = 0; j < n; j++) {
+    gf2x_mul8_512_int(&hi[j][1], &hi[j][0], va[j][1], vb[j][1]);
+  }
+  for(size_t j = 0; j < n; j++) {
+    gf2x_mul8_512_int(&mi[j][1], &mi[j][0], va[j][0] ^ va[j][1],
+                      vb[j][0] ^ vb[j][1]);
+  }
 
-  __m512i hi[2], lo[2], mi[2];
+  for(size_t j = 0; j < n; j++) {
+    __m512i m = lo[j][1] ^ hi[j][0];
 
-  gf2x_mul8_512_int(&lo[1], &lo[0], a0, b0);
-  gf2x_mul8_512_int(&hi[1], &hi[0], a1, b1);
-  gf2x_mul8_512_int(&mi[1], &mi[0], a0 ^ a1, b0 ^ b1);
+    STORE(&c[j][0 * QWORDS_IN_ZMM], lo[j][0]);
+    STORE(&c[j][1 * QWORDS_IN_ZMM], mi[j][0] ^ lo[j][0] ^ m);
+    STORE(&c[j][2 * QWORDS_IN_ZMM], mi[j][1] ^ hi[j][1] ^ m);
+    STORE(&c[j][3 * QWORDS_IN_ZMM], hi[j][1]);
+  }
+}
 
-  __m512i m = lo[1] ^ hi[0];
+void gf2x_mul_base_vpclmul(OUT uint64_t *c,
+                           IN const uint64_t *a,
+                           IN const uint64_t *b)
+{
+  gf2x_mul_base_xn_int(&c, &a, &b, 1);
+}
 
-  STORE(&c[0 * QWORDS_IN_ZMM], lo[0]);
-  STORE(&c[1 * QWORDS_IN_ZMM], mi[0] ^ lo[0] ^ m);
-  STORE(&c[2 * QWORDS_IN_ZMM], mi[1] ^ hi[1] ^ m);
-  STORE(&c[3 * QWORDS_IN_ZMM], hi[1]);
+void gf2x_mul_base_x2_vpclmul(OUT uint64_t *const c[2],
+                              IN const uint64_t *const a[2],
+                              IN const uint64_t *const b[2])
+{
+  gf2x_mul_base_xn_int(c, a, b, 2);
 }
 
 void gf2x_sqr_vpclmul(OUT dbl_pad_r_t *c, IN const pad_r_t *a)
@@ -127,3 +157,92 @@ void gf2x_sqr_vpclmul(OUT dbl_pad_r_t *c, IN const pad_r_t *a)
     STORE(&c64[i * 2 + QWORDS_IN_ZMM], vr1);
   }
 }
+
+// The number of qwords of c that are written by sqr_red_vpclmul
+#define SQR_RED_QWORDS (DIVIDE_AND_CEIL(R_QWORDS, 2 * QWORDS_IN_ZMM) * 16)
+
+bike_static_assert((SQR_RED_QWORDS <= R_PADDED_QWORDS), sqr_red_vpclmul_size);
+
+// Qword j of a^2 is the square of dword j of a. Therefore, qwords
+// j, ..., j+15 of a^2 (for any j, not necessarily even) are computed
+// from the sixteen dwords of a that start at dword j. vm moves the first
+// four qwords of the loaded value to the even qwords of the register and
+// the last four to the odd qwords.
+_INLINE_ void sqr16(OUT __m512i     s[2],
+                    IN const uint32_t *a32,
+                    IN const size_t    j,
+                    IN const __m512i   vm)
+{
+  const __m512i va = PERMXVAR_I64(vm, LOAD(&a32[j]));
+
+  s[0] = CLMUL(va, va, 0x00);
+  s[1] = CLMUL(va, va, 0x11);
+}
+
+// c = a^2 mod (x^r - 1), the squares are reduced as they are computed,
+// see gf2x_red_avx512. The loop writes the qwords of c up to
+// SQR_RED_QWORDS, the remaining upper part of c is not touched.
+_INLINE_ void sqr_red_vpclmul(OUT pad_r_t *c, IN const pad_r_t *a)
+{
+  __m512i vm, vt0[2], vt1[2], vt2[2];
+
+  const uint32_t *a32 = (const uint32_t *)a;
+  uint64_t       *c64 = (uint64_t *)c;
+
+  vm = SET_I64(7, 3, 6, 2, 5, 1, 4, 0);
+
+  for(size_t i = 0; i < R_QWORDS; i += 2 * QWORDS_IN_ZMM) {
+    sqr16(vt0, a32, i, vm);
+    sqr16(vt1, a32, i + R_QWORDS, vm);
+    sqr16(vt2, a32, i + R_QWORDS - 1, vm);
+
+    for(size_t j = 0; j < 2; j++) {
+      vt1[j] = SLLI_I64(vt1[j], LAST_R_QWORD_TRAIL);
+      vt2[j] = SRLI_I64(vt2[j], LAST_R_QWORD_LEAD);
+
+      STORE(&c64[i + (j * QWORDS_IN_ZMM)], vt0[j] ^ vt1[j] ^ vt2[j]);
+    }
+  }
+
+  c64[R_QWORDS - 1] &= LAST_R_QWORD_MASK;
+  for(size_t i = R_QWORDS; i < SQR_RED_QWORDS; i++) {
+    c64[i] = 0;
+  }
+}
+
+void gf2x_sqr_red_vpclmul(OUT pad_r_t *c, IN const pad_r_t *a)
+{
+  sqr_red_vpclmul(c, a);
+
+  // Clean the secrets from the upper part of c
+  uint64_t *c64 = (uint64_t *)c;
+  secure_clean((uint8_t *)&c64[R_QWORDS],
+               (R_PADDED_QWORDS - R_QWORDS) * sizeof(uint64_t));
+}
+
+void gf2x_sqr_red_k_vpclmul(OUT pad_r_t *c,
+                            IN const pad_r_t *a,
+                            IN const size_t   num_sqrs)
+{
+  DEFER_CLEANUP(pad_r_t t = {0}, pad_r_cleanup);
+
+  // c is also an input of the intermediate squarings
+  uint64_t *c64 = (uint64_t *)c;
+  secure_clean((uint8_t *)&c64[R_QWORDS],
+               (R_PADDED_QWORDS - R_QWORDS) * sizeof(uint64_t));
+
+  if(num_sqrs == 0) {
+    c->val = a->val;
+    return;
+  }
+
+  // Alternate between c and t such that the last squaring is written to c
+  const pad_r_t *src = a;
+  pad_r_t       *dst = (num_sqrs & 1) ? c : &t;
+
+  for(size_t i = 0; i < num_sqrs; i++) {
+    sqr_red_vpclmul(dst, src);
+    src = dst;
+    dst = (dst == c) ? &t : c;
+  }
+}
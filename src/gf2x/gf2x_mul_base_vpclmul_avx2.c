@@ -0,0 +1,225 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ */
+
+#include "gf2x_internal.h"
+
+#define AVX2_INTERNAL
+#include "x86_64_intrinsic.h"
+
+// VPCLMULQDQ on ymm registers (without AVX512) operates on the two 128-bit
+// lanes of its operands independently. The same holds for UNPACKLO/HI and
+// the byte shifts below. Therefore, the 128-bit Karatsuba code of
+// gf2x_mul_base_pclmul.c computes two independent products at once when
+// it is executed on ymm registers: one product in each 128-bit lane.
+// We use this property to compute the three sub-products of every
+// Karatsuba level in pairs.
+
+#define CLMUL(x, y, imm)     _mm256_clmulepi64_epi128((x), (y), (imm))
+#define UNPACKLO(x, y)       _mm256_unpacklo_epi64((x), (y))
+#define UNPACKHI(x, y)       _mm256_unpackhi_epi64((x), (y))
+#define BSRLI(x, imm)        _mm256_bsrli_epi128((x), (imm))
+#define BSLLI(x, imm)        _mm256_bslli_epi128((x), (imm))
+#define PERM2X128(x, y, imm) _mm256_permute2x128_si256((x), (y), (imm))
+
+// Two 4x4 Karatsuba multiplications, one in each 128-bit lane.
+// In every lane: a_lo = [a1 | a0]; a_hi = [a3 | a2];
+//                b_lo = [b1 | b0]; b_hi = [b3 | b2];
+// and c[0], ..., c[3] hold the 512-bit product of the lane.
+_INLINE_ void gf2x_mul4_x2_int(OUT __m256i      c[4],
+                               IN const __m256i a_lo,
+                               IN const __m256i a_hi,
+                               IN const __m256i b_lo,
+                               IN const __m256i b_hi)
+{
+  __m256i aa, bb;
+  __m256i xx, yy, uu, vv, m;
+  __m256i lo[2], hi[2], mi[2];
+  __m256i t[9];
+
+  aa = a_lo ^ a_hi;
+  bb = b_lo ^ b_hi;
+
+  // xx <-- [(a2+a3) | (a0+a1)]
+  // yy <-- [(b2+b3) | (b0+b1)]
+  xx = UNPACKLO(a_lo, a_hi);
+  yy = UNPACKLO(b_lo, b_hi);
+  xx = xx ^ UNPACKHI(a_lo, a_hi);
+  yy = yy ^ UNPACKHI(b_lo, b_hi);
+
+  // uu <-- [ 0 | (aa0+aa1)]
+  // vv <-- [ 0 | (bb0+bb1)]
+  uu = aa ^ BSRLI(aa, 8);
+  vv = bb ^ BSRLI(bb, 8);
+
+  // 9 multiplications
+  t[0] = CLMUL(a_lo, b_lo, 0x00);
+  t[1] = CLMUL(a_lo, b_lo, 0x11);
+  t[2] = CLMUL(a_hi, b_hi, 0x00);
+  t[3] = CLMUL(a_hi, b_hi, 0x11);
+  t[4] = CLMUL(xx, yy, 0x00);
+  t[5] = CLMUL(xx, yy, 0x11);
+  t[6] = CLMUL(aa, bb, 0x00);
+  t[7] = CLMUL(aa, bb, 0x11);
+  t[8] = CLMUL(uu, vv, 0x00);
+
+  t[4] ^= (t[0] ^ t[1]);
+  t[5] ^= (t[2] ^ t[3]);
+  t[8] ^= (t[6] ^ t[7]);
+
+  lo[0] = t[0] ^ BSLLI(t[4], 8);
+  lo[1] = t[1] ^ BSRLI(t[4], 8);
+  hi[0] = t[2] ^ BSLLI(t[5], 8);
+  hi[1] = t[3] ^ BSRLI(t[5], 8);
+  mi[0] = t[6] ^ BSLLI(t[8], 8);
+  mi[1] = t[7] ^ BSRLI(t[8], 8);
+
+  m = lo[1] ^ hi[0];
+
+  c[0] = lo[0];
+  c[1] = lo[0] ^ mi[0] ^ m;
+  c[2] = hi[1] ^ mi[1] ^ m;
+  c[3] = hi[1];
+}
+
+// Two 8x8 Karatsuba multiplications, one in each 128-bit lane.
+// The 128-bit digit i of the operand of a lane is held in a[i] (b[i]),
+// and the 128-bit digit i of its 1024-bit product in c[i].
+_INLINE_ void gf2x_mul8_x2_int(OUT __m256i      c[8],
+                               IN const __m256i a[4],
+                               IN const __m256i b[4])
+{
+  __m256i lo[4], hi[4], mi[4], m[2];
+
+  gf2x_mul4_x2_int(lo, a[0], a[1], b[0], b[1]);
+  gf2x_mul4_x2_int(hi, a[2], a[3], b[2], b[3]);
+  gf2x_mul4_x2_int(mi, a[0] ^ a[2], a[1] ^ a[3], b[0] ^ b[2], b[1] ^ b[3]);
+
+  m[0] = lo[2] ^ hi[0];
+  m[1] = lo[3] ^ hi[1];
+
+  c[0] = lo[0];
+  c[1] = lo[1];
+  c[2] = mi[0] ^ lo[0] ^ m[0];
+  c[3] = mi[1] ^ lo[1] ^ m[1];
+  c[4] = mi[2] ^ hi[2] ^ m[0];
+  c[5] = mi[3] ^ hi[3] ^ m[1];
+  c[6] = hi[2];
+  c[7] = hi[3];
+}
+
+// 8x8 Karatsuba multiplication of a = [a[1] | a[0]] and b = [b[1] | b[0]].
+// The low and the high products are computed in the two lanes of the first
+// gf2x_mul4_x2_int call, and the middle product in the low lane
+// of the second one.
+_INLINE_ void gf2x_mul8_int(OUT __m256i      z[4],
+                            IN const __m256i a[2],
+                            IN const __m256i b[2])
+{
+  __m256i t[4], mi[4], l[2], h[2], m[2];
+
+  // [a3 a2 | a1 a0] -> lanes [a2 | a0] and [a3 | a1]
+  gf2x_mul4_x2_int(t, PERM2X128(a[0], a[1], 0x20), PERM2X128(a[0], a[1], 0x31),
+                   PERM2X128(b[0], b[1], 0x20), PERM2X128(b[0], b[1], 0x31));
+
+  const __m256i aa = a[0] ^ a[1];
+  const __m256i bb = b[0] ^ b[1];
+  gf2x_mul4_x2_int(mi, aa, PERM2X128(aa, aa, 0x11), bb,
+                   PERM2X128(bb, bb, 0x11));
+
+  // Move the products from the lanes back to a sequential layout
+  l[0] = PERM2X128(t[0], t[1], 0x20);
+  l[1] = PERM2X128(t[2], t[3], 0x20);
+  h[0] = PERM2X128(t[0], t[1], 0x31);
+  h[1] = PERM2X128(t[2], t[3], 0x31);
+  m[0] = PERM2X128(mi[0], mi[1], 0x20) ^ l[0] ^ h[0];
+  m[1] = PERM2X128(mi[2], mi[3], 0x20) ^ l[1] ^ h[1];
+
+  z[0] = l[0];
+  z[1] = l[1] ^ m[0];
+  z[2] = h[0] ^ m[1];
+  z[3] = h[1];
+}
+
+// 1024x1024 bit multiplication performed by Karatsuba algorithm.
+// Here, a and b are considered as having 16 digits of size 64 bits.
+void gf2x_mul_base_vpclmul_avx2(OUT uint64_t *c,
+                                IN const uint64_t *a,
+                                IN const uint64_t *b)
+{
+  __m256i va[4], vb[4], xa[4], xb[4], ya[2], yb[2];
+  __m256i x[8], mi[4], lo[4], hi[4];
+
+  for(size_t i = 0; i < 4; i++) {
+    va[i] = LOAD(&a[i * QWORDS_IN_YMM]);
+    vb[i] = LOAD(&b[i * QWORDS_IN_YMM]);
+  }
+
+  // The low lanes of xa/xb hold the low half of a/b,
+  // and the high lanes hold the high half.
+  xa[0] = PERM2X128(va[0], va[2], 0x20);
+  xa[1] = PERM2X128(va[0], va[2], 0x31);
+  xa[2] = PERM2X128(va[1], va[3], 0x20);
+  xa[3] = PERM2X128(va[1], va[3], 0x31);
+  xb[0] = PERM2X128(vb[0], vb[2], 0x20);
+  xb[1] = PERM2X128(vb[0], vb[2], 0x31);
+  xb[2] = PERM2X128(vb[1], vb[3], 0x20);
+  xb[3] = PERM2X128(vb[1], vb[3], 0x31);
+
+  // a_lo * b_lo (low lanes) and a_hi * b_hi (high lanes)
+  gf2x_mul8_x2_int(x, xa, xb);
+
+  // (a_lo + a_hi) * (b_lo + b_hi)
+  ya[0] = va[0] ^ va[2];
+  ya[1] = va[1] ^ va[3];
+  yb[0] = vb[0] ^ vb[2];
+  yb[1] = vb[1] ^ vb[3];
+  gf2x_mul8_int(mi, ya, yb);
+
+  for(size_t i = 0; i < 4; i++) {
+    lo[i] = PERM2X128(x[2 * i], x[(2 * i) + 1], 0x20);
+    hi[i] = PERM2X128(x[2 * i], x[(2 * i) + 1], 0x31);
+    mi[i] ^= lo[i] ^ hi[i];
+  }
+
+  STORE(&c[0 * QWORDS_IN_YMM], lo[0]);
+  STORE(&c[1 * QWORDS_IN_YMM], lo[1]);
+  STORE(&c[2 * QWORDS_IN_YMM], lo[2] ^ mi[0]);
+  STORE(&c[3 * QWORDS_IN_YMM], lo[3] ^ mi[1]);
+  STORE(&c[4 * QWORDS_IN_YMM], hi[0] ^ mi[2]);
+  STORE(&c[5 * QWORDS_IN_YMM], hi[1] ^ mi[3]);
+  STORE(&c[6 * QWORDS_IN_YMM], hi[2]);
+  STORE(&c[7 * QWORDS_IN_YMM], hi[3]);
+}
+
+// The ymm registers are fully used by a single product,
+// so the two products are computed one after the other.
+void gf2x_mul_base_x2_vpclmul_avx2(OUT uint64_t *const c[2],
+                                   IN const uint64_t *const a[2],
+                                   IN const uint64_t *const b[2])
+{
+  gf2x_mul_base_vpclmul_avx2(c[0], a[0], b[0]);
+  gf2x_mul_base_vpclmul_avx2(c[1], a[1], b[1]);
+}
+
+void gf2x_sqr_vpclmul_avx2(OUT dbl_pad_r_t *c, IN const pad_r_t *a)
+{
+  __m256i va, vr0, vr1;
+
+  const uint64_t *a64 = (const uint64_t *)a;
+  uint64_t       *c64 = (uint64_t *)c;
+
+  for(size_t i = 0; i < (R_YMM * QWORDS_IN_YMM); i += QWORDS_IN_YMM) {
+    // [a3 a2 | a1 a0] -> [a3 a1 | a2 a0]
+    va = PERM_I64(LOAD(&a64[i]), 0xd8);
+
+    vr0 = CLMUL(va, va, 0x00);
+    vr1 = CLMUL(va, va, 0x11);
+
+    STORE(&c64[i * 2], vr0);
+    STORE(&c64[i * 2 + QWORDS_IN_YMM], vr1);
+  }
+}
@@ -0,0 +1,98 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ *
+ * The reductions mod (x^r - 1) of gf2x_mul_avx512.c, where the shift of the
+ * upper part by LAST_R_QWORD_TRAIL bits uses the funnel shifts of
+ * AVX512-VBMI2.
+ */
+
+#include "cleanup.h"
+#include "gf2x_internal.h"
+
+#define AVX512_INTERNAL
+#include "x86_64_intrinsic.h"
+
+// The qwords i, ..., i + REG_QWORDS - 1 of the reduction are
+//   a[i] ^ ((a[i + R_QWORDS] << TRAIL) | (a[i + R_QWORDS - 1] >> LEAD)),
+// where the shifted value is the funnel shift of the two registers.
+#define RED_SHIFT(hi, lo) SHLDI_I64(hi, lo, LAST_R_QWORD_TRAIL)
+
+// c = a mod (x^r - 1)
+void gf2x_red_vbmi2(OUT pad_r_t *c, IN const dbl_pad_r_t *a)
+{
+  const uint64_t *a64 = (const uint64_t *)a;
+  uint64_t *      c64 = (uint64_t *)c;
+
+  for(size_t i = 0; i < R_QWORDS; i += REG_QWORDS) {
+    const REG_T vt0 = LOAD(&a64[i]);
+    const REG_T vt1 = LOAD(&a64[i + R_QWORDS]);
+    const REG_T vt2 = LOAD(&a64[i + R_QWORDS - 1]);
+
+    STORE(&c64[i], vt0 ^ RED_SHIFT(vt1, vt2));
+  }
+
+  c64[R_QWORDS - 1] &= LAST_R_QWORD_MASK;
+
+  // Clean the secrets from the upper part of c
+  secure_clean((uint8_t *)&c64[R_QWORDS],
+               (R_PADDED_QWORDS - R_QWORDS) * sizeof(uint64_t));
+}
+
+// See karatzuba_prod_avx512 in gf2x_mul_avx512.c
+_INLINE_ REG_T karatzuba_prod_vbmi2(IN const uint64_t *lo,
+                                    IN const uint64_t *hi,
+                                    IN const uint64_t *mid,
+                                    IN const size_t    q)
+{
+  const ptrdiff_t h  = GF2X_TOP_HALF_QWORDS;
+  const ptrdiff_t iq = (ptrdiff_t)q;
+  REG_T           p;
+
+  if(iq < 2 * h) {
+    p = LOAD(&lo[iq]);
+    if(iq + (ptrdiff_t)REG_QWORDS > 2 * h) {
+      p ^= LOAD(&hi[iq - (2 * h)]);
+    }
+  } else {
+    p = LOAD(&hi[iq - (2 * h)]);
+  }
+
+  if((iq + (ptrdiff_t)REG_QWORDS > h) && (iq < 3 * h)) {
+    p ^= LOAD(&mid[iq - h]) ^ LOAD(&lo[iq - h]) ^ LOAD(&hi[iq - h]);
+  }
+
+  return p;
+}
+
+// c = (hi * x^(2h) + (mid + lo + hi) * x^h + lo) mod (x^r - 1)
+// The upper qwords of the product that start at (i + R_QWORDS - 1) are
+// aligned from the ones of the previous iteration, instead of computing
+// them again as in karatzuba_red_avx512.
+void karatzuba_red_vbmi2(OUT pad_r_t *c,
+                         IN const uint64_t *lo,
+                         IN const uint64_t *hi,
+                         IN const uint64_t *mid)
+{
+  uint64_t *c64 = (uint64_t *)c;
+
+  // The last qword of prev is qword (R_QWORDS - 1) of the product
+  REG_T prev = karatzuba_prod_vbmi2(lo, hi, mid, R_QWORDS - REG_QWORDS);
+
+  for(size_t i = 0; i < R_QWORDS; i += REG_QWORDS) {
+    const REG_T vt0 = karatzuba_prod_vbmi2(lo, hi, mid, i);
+    const REG_T vt1 = karatzuba_prod_vbmi2(lo, hi, mid, i + R_QWORDS);
+    const REG_T vt2 = VALIGN(vt1, prev, REG_QWORDS - 1);
+
+    STORE(&c64[i], vt0 ^ RED_SHIFT(vt1, vt2));
+    prev = vt1;
+  }
+
+  c64[R_QWORDS - 1] &= LAST_R_QWORD_MASK;
+
+  // Clean the secrets from the upper part of c
+  secure_clean((uint8_t *)&c64[R_QWORDS],
+               (R_PADDED_QWORDS - R_QWORDS) * sizeof(uint64_t));
+}
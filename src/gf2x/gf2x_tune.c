@@ -0,0 +1,229 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ */
+
+// Required for clock_gettime
+#define _POSIX_C_SOURCE 200809L
+
+#include <time.h>
+
+#include "cpu_features.h"
+#include "gf2x_internal.h"
+#include "gf2x_tune.h"
+#include "utilities.h"
+
+// The stored profiles, terminated by an all-zero entry
+static const gf2x_tune_profile_t tune_profiles[] = {
+#define GF2X_TUNE_PROFILE(cpu_sig, r_bits, k_sqr_thr, mul_base) \
+  {(cpu_sig), (r_bits), (k_sqr_thr), (mul_base)},
+#include "gf2x_tune_profiles.h"
+#undef GF2X_TUNE_PROFILE
+  {0, 0, 0, 0}};
+
+static const gf2x_tune_profile_t tune_defaults = {
+  0, R_BITS, GF2X_DEFAULT_K_SQR_THR, GF2X_MUL_BASE_AUTO};
+
+// The choices of the current profile are packed into one word (TUNE_PACK), so
+// that bike_set_tune_profile publishes a new profile with one atomic store,
+// and the readers see either the old or the new profile, like the ISA policy
+// (see isa_policy.c). The word is TUNE_UNSET until the first
+// gf2x_tune_profile call loads the profile of the CPU from the table (after
+// cpu_features_init, which sets the CPU signature), unless
+// bike_set_tune_profile was called before. TUNE_UNSET is not a valid packed
+// profile, as its mul_base is out of range.
+#define TUNE_UNSET       (0xffffffff)
+#define TUNE_MAX_THR     (0xffffff)
+#define TUNE_PACK(p)     (((p)->k_sqr_thr << 8) | (p)->mul_base)
+
+static uint32_t current_profile = TUNE_UNSET;
+
+// A k_sqr_thr that is larger than every k of the inversion schedule (k < R)
+// chooses repeated squaring for all the steps, so it is clamped to
+// TUNE_MAX_THR, and an unknown mul_base is replaced by GF2X_MUL_BASE_AUTO.
+_INLINE_ uint32_t tune_pack(IN const gf2x_tune_profile_t *profile)
+{
+  gf2x_tune_profile_t p = *profile;
+
+  bike_static_assert(R_BITS < TUNE_MAX_THR, tune_max_thr_too_small);
+  p.k_sqr_thr = (p.k_sqr_thr < TUNE_MAX_THR) ? p.k_sqr_thr : TUNE_MAX_THR;
+  p.mul_base  = (p.mul_base < GF2X_MUL_BASE_NUM) ? p.mul_base
+                                                : GF2X_MUL_BASE_AUTO;
+
+  return TUNE_PACK(&p);
+}
+
+void gf2x_tune_profile(OUT gf2x_tune_profile_t *profile)
+{
+  uint32_t packed = __atomic_load_n(&current_profile, __ATOMIC_ACQUIRE);
+
+  if(packed == TUNE_UNSET) {
+    gf2x_tune_profile_t p = tune_defaults;
+    p.cpu_sig             = cpu_signature();
+    for(size_t i = 0; tune_profiles[i].r_bits != 0; i++) {
+      if((tune_profiles[i].cpu_sig == p.cpu_sig) &&
+         (tune_profiles[i].r_bits == R_BITS)) {
+        p = tune_profiles[i];
+      }
+    }
+
+    // Keeps the profile of a concurrent bike_set_tune_profile
+    // (or gf2x_tune_profile)
+    uint32_t expected = TUNE_UNSET;
+    packed            = tune_pack(&p);
+    if(!__atomic_compare_exchange_n(&current_profile, &expected, packed, 0,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+      packed = expected;
+    }
+  }
+
+  profile->cpu_sig   = cpu_signature();
+  profile->r_bits    = R_BITS;
+  profile->k_sqr_thr = packed >> 8;
+  profile->mul_base  = packed & 0xff;
+}
+
+void bike_set_tune_profile(IN const gf2x_tune_profile_t *profile)
+{
+  // The gf2x contexts of every mul_base are resolved once (see dispatch.c),
+  // so only the profile that selects them is replaced
+  __atomic_store_n(&current_profile, tune_pack(profile), __ATOMIC_RELEASE);
+}
+
+// ---------------------------------- Tuning ----------------------------------
+// Every candidate is timed TUNE_REPS times and its fastest run is taken,
+// which filters out most of the noise of interrupts and frequency changes.
+#define TUNE_REPS (16)
+
+// An upper bound on the number of steps of the inversion schedule
+#define TUNE_MAX_INV_STEPS (64)
+
+_INLINE_ uint64_t tune_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+#define TUNE_MEASURE(best, op)                                  \
+  do {                                                          \
+    (best) = UINT64_MAX;                                        \
+    for(size_t rep_ = 0; rep_ < TUNE_REPS; rep_++) {            \
+      const uint64_t start_ = tune_now();                       \
+      op;                                                       \
+      const uint64_t time_ = tune_now() - start_;               \
+      (best)               = (time_ < (best)) ? time_ : (best); \
+    }                                                           \
+  } while(0)
+
+// A fixed pseudo-random polynomial (the values do not affect the timings)
+_INLINE_ void tune_poly(OUT pad_r_t *a, IN uint64_t seed)
+{
+  bike_memset(a, 0, sizeof(*a));
+  for(size_t i = 0; i < R_BYTES; i++) {
+    seed          = (seed * 6364136223846793005ULL) + 1442695040888963407ULL;
+    a->val.raw[i] = (uint8_t)(seed >> 56);
+  }
+  a->val.raw[R_BYTES - 1] &= LAST_R_BYTE_MASK;
+}
+
+// Choose the threshold that minimizes the total time of the exponentiations
+// of the inversion schedule, where step i costs sqr[i] if k[i] <= threshold,
+// and ksqr[i] otherwise. ksqr[i] is the time of the k-squaring that
+// gf2x_mod_inv runs for step i: with its precomputed map if the step has one,
+// and with a map that is generated on the fly otherwise.
+static uint32_t tune_k_sqr_thr(IN const gf2x_ctx *ctx,
+                               IN const pad_r_t *a,
+                               OUT pad_r_t *c)
+{
+  static k_sqr_map_t map;
+  uint32_t           k[TUNE_MAX_INV_STEPS];
+  uint32_t           l[TUNE_MAX_INV_STEPS];
+  uint8_t            has_map[TUNE_MAX_INV_STEPS];
+  uint64_t           sqr[TUNE_MAX_INV_STEPS];
+  uint64_t           ksqr[TUNE_MAX_INV_STEPS];
+
+  size_t n = gf2x_inv_schedule_params(k, l, has_map, TUNE_MAX_INV_STEPS);
+  n        = (n < TUNE_MAX_INV_STEPS) ? n : TUNE_MAX_INV_STEPS;
+
+  for(size_t i = 0; i < n; i++) {
+    TUNE_MEASURE(sqr[i], ctx->sqr_red_k(c, a, k[i]));
+
+    if(has_map[i]) {
+      // gf2x_mod_inv applies the precomputed maps (see get_k_sqr_maps)
+      k_sqr_map_init(&map, l[i]);
+      TUNE_MEASURE(ksqr[i], ctx->k_sqr_map(c, a, &map));
+    } else {
+      TUNE_MEASURE(ksqr[i], ctx->k_sqr(c, a, l[i]));
+    }
+  }
+
+  // The candidates are 0 (k-squaring only) and the values of k
+  uint32_t best_thr  = 0;
+  uint64_t best_cost = UINT64_MAX;
+  for(size_t j = 0; j <= n; j++) {
+    const uint32_t thr  = (j == 0) ? 0 : k[j - 1];
+    uint64_t       cost = 0;
+    for(size_t i = 0; i < n; i++) {
+      cost += (k[i] <= thr) ? sqr[i] : ksqr[i];
+    }
+
+    if((cost < best_cost) || ((cost == best_cost) && (thr < best_thr))) {
+      best_cost = cost;
+      best_thr  = thr;
+    }
+  }
+
+  return best_thr;
+}
+
+// Choose the fastest multiplication base kernel that the CPU supports.
+static uint32_t tune_mul_base(IN const pad_r_t *a,
+                              IN const pad_r_t *b,
+                              OUT pad_r_t *c)
+{
+  uint32_t best_base = GF2X_MUL_BASE_AUTO;
+  uint64_t best_time = UINT64_MAX;
+
+  for(uint32_t base = GF2X_MUL_BASE_PORT; base < GF2X_MUL_BASE_NUM; base++) {
+    gf2x_ctx ctx;
+    uint64_t t;
+
+    gf2x_ctx_init(&ctx);
+    if(!gf2x_ctx_set_mul_base(&ctx, base)) {
+      continue;
+    }
+
+    TUNE_MEASURE(t, gf2x_mod_mul_with_ctx(c, a, b, &ctx));
+    if(t < best_time) {
+      best_time = t;
+      best_base = base;
+    }
+  }
+
+  return best_base;
+}
+
+void bike_tune(OUT gf2x_tune_profile_t *profile)
+{
+  gf2x_ctx ctx;
+  pad_r_t  a;
+  pad_r_t  b;
+  pad_r_t  c;
+
+  tune_poly(&a, 1);
+  tune_poly(&b, 2);
+
+  // The candidates are timed with the default choices of gf2x_ctx_init
+  bike_set_tune_profile(&tune_defaults);
+  gf2x_ctx_init(&ctx);
+
+  profile->cpu_sig   = cpu_signature();
+  profile->r_bits    = R_BITS;
+  profile->k_sqr_thr = tune_k_sqr_thr(&ctx, &a, &c);
+  profile->mul_base  = tune_mul_base(&a, &b, &c);
+
+  bike_set_tune_profile(profile);
+}
@@ -0,0 +1,12 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ */
+
+// The stored tuning profiles (see gf2x_tune.h), one per line:
+//   GF2X_TUNE_PROFILE(cpu_sig, r_bits, k_sqr_thr, mul_base)
+// This file is included by gf2x_tune.c inside the initializer of the table.
+// New lines are appended by "bike-tune -o <this file>"; when several lines
+// match the current CPU and R, the last one is used.
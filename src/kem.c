@@ -11,6 +11,10 @@
 #include "sampling.h"
 #include "sha.h"
 
+#if defined(BIKE_PREFIX)
+#  include "bike_kem.h"
+#endif
+
 // m_t and seed_t have the same size and thus can be considered
 // to be of the same type. However, for security reasons we distinguish
 // these types, even on the costs of small extra complexity.
@@ -295,3 +299,28 @@ int crypto_kem_dec(OUT unsigned char *     ss,
 
   return SUCCESS;
 }
+
+#if defined(BIKE_PREFIX)
+#  if defined(BIND_PK_AND_M)
+#    define VARIANT_BIND BIKE_VARIANT_BIND_PK_AND_M
+#  else
+#    define VARIANT_BIND 0
+#  endif
+
+#  if defined(USE_SHA3_AND_SHAKE)
+#    define VARIANT_HASH 0
+#  else
+#    define VARIANT_HASH BIKE_VARIANT_USE_AES_AND_SHA2
+#  endif
+
+// The instance of MULTI_LEVEL builds, see bike_kem_get
+const bike_kem_t kem_instance = {LEVEL,
+                                 (VARIANT_BIND | VARIANT_HASH),
+                                 sizeof(pk_t),
+                                 sizeof(sk_t),
+                                 sizeof(ct_t),
+                                 sizeof(ss_t),
+                                 crypto_kem_keypair,
+                                 crypto_kem_enc,
+                                 crypto_kem_dec};
+#endif
@@ -0,0 +1,43 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ *
+ * The front end of MULTI_LEVEL builds. It is compiled once (without a
+ * BIKE_PREFIX), and it reaches the instances through their prefixed symbols.
+ * bike_instances.h is generated by cmake/multi-level.cmake, and defines
+ * BIKE_INSTANCES(X) as X(prefix) for the prefix of every instance.
+ */
+
+#include "bike_instances.h"
+#include "bike_kem.h"
+#include "cpu_features.h"
+
+#define DECLARE_INSTANCE(prefix)                \
+  extern const bike_kem_t prefix##kem_instance; \
+  void prefix##dispatch_resolve(void);
+
+#define INSTANCE(prefix) &prefix##kem_instance,
+
+#define RESOLVE_INSTANCE(prefix) prefix##dispatch_resolve();
+
+BIKE_INSTANCES(DECLARE_INSTANCE)
+
+static const bike_kem_t *const instances[] = {BIKE_INSTANCES(INSTANCE)};
+
+const bike_kem_t *bike_kem_get(IN const uint32_t level,
+                               IN const uint32_t variant)
+{
+  for(size_t i = 0; i < (sizeof(instances) / sizeof(instances[0])); i++) {
+    if((instances[i]->level == level) && (instances[i]->variant == variant)) {
+      return instances[i];
+    }
+  }
+
+  return NULL;
+}
+
+// cpu_features_init resolves the methods of all the instances, for the same
+// features (the ISA policy of isa_policy.c is shared by the instances)
+void dispatch_resolve(void) { BIKE_INSTANCES(RESOLVE_INSTANCE) }
@@ -0,0 +1,78 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ */
+
+#include <assert.h>
+
+#include "utilities.h"
+#include "sampling_internal.h"
+
+#define NEON_INTERNAL
+#include "aarch64_intrinsic.h"
+
+// For improved performance, we process NUM_REGS amount of data in parallel.
+#define NUM_REGS    (4)
+#define REGS_QWORDS (QWORDS_IN_NEON * NUM_REGS)
+
+void secure_set_bits_neon(OUT pad_r_t *   r,
+                          IN const size_t first_pos,
+                          IN const idx_t *wlist,
+                          IN const size_t w_size)
+{
+  // The function assumes that the size of r is a multiple
+  // of the cumulative size of used NEON registers.
+  assert((sizeof(*r) / sizeof(uint64_t)) % REGS_QWORDS == 0);
+
+  // The algorithm is the same as in secure_set_bits_avx2:
+  // va vectors hold the bits of the output array "r", va_pos_qw vectors hold
+  // the qw position indices of "r". For every w in wlist, the bit of w is set
+  // in the qword of va whose position equals the qw position of w.
+  REG_T va[NUM_REGS], va_pos_qw[NUM_REGS], va_mask;
+  REG_T w_pos_qw, w_pos_bit;
+  REG_T inc;
+
+  uint64_t *r64 = (uint64_t *)r;
+
+  // 1. Initialize
+  const uint64_t first_qws[QWORDS_IN_NEON] = {0, 1};
+  va_pos_qw[0]                             = LOAD(first_qws);
+
+  inc = SET1_I64(QWORDS_IN_NEON);
+  for(size_t i = 1; i < NUM_REGS; i++) {
+    va_pos_qw[i] = ADD_I64(va_pos_qw[i - 1], inc);
+  }
+
+  // va_pos_qw vectors hold qw positions 0 .. (REGS_QWORDS - 1)
+  // Therefore, we set the increment vector inc such that by adding it to
+  // va_pos_qw vectors, they hold the next REGS_QWORDS qw positions.
+  inc = SET1_I64(REGS_QWORDS);
+
+  for(size_t i = 0; i < (sizeof(*r) / sizeof(uint64_t)); i += REGS_QWORDS) {
+    for(size_t va_iter = 0; va_iter < NUM_REGS; va_iter++) {
+      va[va_iter] = SET_ZERO;
+    }
+
+    for(size_t w_iter = 0; w_iter < w_size; w_iter++) {
+      int32_t w = wlist[w_iter] - first_pos;
+      w_pos_qw  = SET1_I64(w >> 6);
+      w_pos_bit = SET1_I64(BIT(w & MASK(6)));
+
+      // Compare the positions in va_pos_qw with w_pos_qw
+      // and set the appropriate bit in va
+      for(size_t va_iter = 0; va_iter < NUM_REGS; va_iter++) {
+        va_mask = CMPEQ_I64(va_pos_qw[va_iter], w_pos_qw);
+        va[va_iter] |= (va_mask & w_pos_bit);
+      }
+    }
+
+    // Set the va_pos_qw to the next qw positions of r
+    // and store the previously computed data in r
+    for(size_t va_iter = 0; va_iter < NUM_REGS; va_iter++) {
+      STORE(&r64[i + (va_iter * QWORDS_IN_NEON)], va[va_iter]);
+      va_pos_qw[va_iter] = ADD_I64(va_pos_qw[va_iter], inc);
+    }
+  }
+}
@@ -0,0 +1,666 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ *
+ * Compares the variants of the gf2x and the decode functions with their
+ * reference (gf2x_mod_mul and decode) on random inputs, under every cap of
+ * the ISA policy (see bike_set_isa_policy). The test is run by CTest, and it
+ * returns a non-zero value if any comparison fails.
+ */
+
+// Required for fork and waitpid (see test_fork)
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
+#include "cleanup.h"
+#include "cpu_features.h"
+#include "decode.h"
+#include "decode_internal.h"
+#include "gf2x.h"
+#include "gf2x_tune.h"
+#include "kem.h"
+#include "sampling.h"
+#include "utilities.h"
+
+#if !defined(NUM_OF_TRIALS)
+#  define NUM_OF_TRIALS 8
+#endif
+
+static uint32_t failures;
+
+static void report(IN const char *name, IN const int ok)
+{
+  printf("%s: %s\n", name, ok ? "Success!" : "Failure!");
+  failures += !ok;
+}
+
+// A random polynomial of R_BITS bits (with a zero padding)
+static void random_pad_r(OUT pad_r_t *a)
+{
+  bike_memset(a, 0, sizeof(*a));
+
+  for(size_t i = 0; i < R_BYTES; i++) {
+    a->val.raw[i] = (uint8_t)rand();
+  }
+  a->val.raw[R_BYTES - 1] &= LAST_R_BYTE_MASK;
+}
+
+static int pad_r_eq(IN const pad_r_t *a, IN const pad_r_t *b)
+{
+  return memcmp(a->val.raw, b->val.raw, R_BYTES) == 0;
+}
+
+// gf2x_mod_mul_x2/x4 against gf2x_mod_mul, also when the outputs alias
+// the inputs of other products
+static void test_mod_mul_xn(void)
+{
+  pad_r_t a[4], b[4], c[4], ref[4];
+  int     ok_x2 = 1, ok_x4 = 1, ok_alias = 1;
+
+  for(size_t t = 0; t < NUM_OF_TRIALS; t++) {
+    for(size_t i = 0; i < 4; i++) {
+      random_pad_r(&a[i]);
+      random_pad_r(&b[i]);
+      gf2x_mod_mul(&ref[i], &a[i], &b[i]);
+    }
+
+    pad_r_t *const       c_ptr[4] = {&c[0], &c[1], &c[2], &c[3]};
+    const pad_r_t *const a_ptr[4] = {&a[0], &a[1], &a[2], &a[3]};
+    const pad_r_t *const b_ptr[4] = {&b[0], &b[1], &b[2], &b[3]};
+
+    gf2x_mod_mul_x2(c_ptr, a_ptr, b_ptr);
+    ok_x2 &= pad_r_eq(&c[0], &ref[0]) && pad_r_eq(&c[1], &ref[1]);
+
+    gf2x_mod_mul_x4(c_ptr, a_ptr, b_ptr);
+    for(size_t i = 0; i < 4; i++) {
+      ok_x4 &= pad_r_eq(&c[i], &ref[i]);
+    }
+
+    // c[0] = a[1], c[1] = b[0], c[2] = a[2], c[3] = b[1]
+    pad_r_t *const alias[4] = {&a[1], &b[0], &a[2], &b[1]};
+    gf2x_mod_mul_x4(alias, a_ptr, b_ptr);
+    for(size_t i = 0; i < 4; i++) {
+      ok_alias &= pad_r_eq(alias[i], &ref[i]);
+    }
+  }
+
+  report("gf2x_mod_mul_x2", ok_x2);
+  report("gf2x_mod_mul_x4", ok_x4);
+  report("gf2x_mod_mul_x4 (aliased)", ok_alias);
+}
+
+// The maximal number of products of the sums in test_mod_mul_acc
+#define MAX_TERMS (5)
+
+// The prepared operands are large (about 93 KB at Level 5)
+static gf2x_prepared_t prepared[MAX_TERMS];
+
+// gf2x_mod_mul_prepared(_x2) against gf2x_mod_mul, also when c aliases b
+static void test_mod_mul_prepared(void)
+{
+  pad_r_t a[2], b[2], c[2], ref[2];
+  int     ok = 1, ok_x2 = 1, ok_alias = 1;
+
+  for(size_t t = 0; t < NUM_OF_TRIALS; t++) {
+    for(size_t i = 0; i < 2; i++) {
+      random_pad_r(&a[i]);
+      random_pad_r(&b[i]);
+      gf2x_mod_mul(&ref[i], &a[i], &b[i]);
+      gf2x_prepare(&a[i], &prepared[i]);
+    }
+
+    gf2x_mod_mul_prepared(&c[0], &prepared[0], &b[0]);
+    ok &= pad_r_eq(&c[0], &ref[0]);
+
+    pad_r_t *const               c_ptr[2] = {&c[0], &c[1]};
+    const gf2x_prepared_t *const p_ptr[2] = {&prepared[0], &prepared[1]};
+    const pad_r_t *const         b_ptr[2] = {&b[0], &b[1]};
+
+    gf2x_mod_mul_prepared_x2(c_ptr, p_ptr, b_ptr);
+    ok_x2 &= pad_r_eq(&c[0], &ref[0]) && pad_r_eq(&c[1], &ref[1]);
+
+    // c[0] = b[1], c[1] = b[0]
+    pad_r_t *const alias[2] = {&b[1], &b[0]};
+    gf2x_mod_mul_prepared_x2(alias, p_ptr, b_ptr);
+    ok_alias &= pad_r_eq(&b[1], &ref[0]) && pad_r_eq(&b[0], &ref[1]);
+  }
+
+  secure_clean((uint8_t *)prepared, sizeof(prepared));
+
+  report("gf2x_mod_mul_prepared", ok);
+  report("gf2x_mod_mul_prepared_x2", ok_x2);
+  report("gf2x_mod_mul_prepared_x2 (aliased)", ok_alias);
+}
+
+// gf2x_mod_mul_acc and gf2x_mod_mul_prepared_acc against the sum of the
+// products of gf2x_mod_mul, for 0 to MAX_TERMS products, also when c
+// aliases a[0]
+static void test_mod_mul_acc(void)
+{
+  pad_r_t a[MAX_TERMS], b[MAX_TERMS], c, prod, ref;
+  int     ok = 1, ok_prepared = 1, ok_alias = 1;
+
+  const pad_r_t *        a_ptr[MAX_TERMS];
+  const pad_r_t *        b_ptr[MAX_TERMS];
+  const gf2x_prepared_t *p_ptr[MAX_TERMS];
+
+  for(size_t t = 0; t < NUM_OF_TRIALS; t++) {
+    for(size_t n = 0; n <= MAX_TERMS; n++) {
+      bike_memset(&ref, 0, sizeof(ref));
+
+      for(size_t i = 0; i < n; i++) {
+        random_pad_r(&a[i]);
+        random_pad_r(&b[i]);
+        gf2x_prepare(&a[i], &prepared[i]);
+
+        gf2x_mod_mul(&prod, &a[i], &b[i]);
+        gf2x_mod_add(&ref, &ref, &prod);
+
+        a_ptr[i] = &a[i];
+        b_ptr[i] = &b[i];
+        p_ptr[i] = &prepared[i];
+      }
+
+      // An output that is not zero, for the empty sum
+      random_pad_r(&c);
+      gf2x_mod_mul_acc(&c, a_ptr, b_ptr, n);
+      ok &= pad_r_eq(&c, &ref);
+
+      random_pad_r(&c);
+      gf2x_mod_mul_prepared_acc(&c, p_ptr, b_ptr, n);
+      ok_prepared &= pad_r_eq(&c, &ref);
+
+      if(n > 0) {
+        gf2x_mod_mul_acc(&a[0], a_ptr, b_ptr, n);
+        ok_alias &= pad_r_eq(&a[0], &ref);
+      }
+    }
+  }
+
+  secure_clean((uint8_t *)prepared, sizeof(prepared));
+
+  report("gf2x_mod_mul_acc", ok);
+  report("gf2x_mod_mul_prepared_acc", ok_prepared);
+  report("gf2x_mod_mul_acc (aliased)", ok_alias);
+}
+
+// The number of ciphertexts of the tests of the decoders (more than a group
+// of decode_multi), and the number of them that the slower tests (of the UPC
+// engines, the plans, and the decoders) decode under every ISA cap
+#define NUM_OF_CTS     (DECODE_MULTI_MAX + 3)
+#define NUM_OF_FEW_CTS (2)
+
+// The key pair, and the ciphertexts of random errors (and the errors)
+typedef struct decode_inputs_s {
+  aligned_sk_t sk;
+  pk_t         pk;
+  ct_t         ct[NUM_OF_CTS];
+  pad_e_t      e[NUM_OF_CTS];
+} decode_inputs_t;
+
+static decode_inputs_t inputs;
+
+// Generate a random error e and the ciphertext c0 = e0 + pk*e1
+static int generate_ct(OUT ct_t *ct, OUT pad_e_t *e, IN const pk_t *pk)
+{
+  seeds_t seeds;
+  pad_r_t p_pk = {0};
+  pad_r_t c0   = {0};
+
+  get_seeds(&seeds);
+  if(generate_error_vector(e, &seeds.seed[0]) != SUCCESS) {
+    return 0;
+  }
+
+  p_pk.val = *pk;
+  gf2x_mod_mul(&c0, &e->val[1], &p_pk);
+  gf2x_mod_add(&c0, &c0, &e->val[0]);
+  ct->c0 = c0.val;
+
+  return 1;
+}
+
+static int init_decode_inputs(void)
+{
+  if(crypto_kem_keypair((uint8_t *)&inputs.pk, (uint8_t *)&inputs.sk) != 0) {
+    return 0;
+  }
+
+  for(size_t i = 0; i < NUM_OF_CTS; i++) {
+    if(!generate_ct(&inputs.ct[i], &inputs.e[i], &inputs.pk)) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+static int e_eq(IN const e_t *a, IN const e_t *b)
+{
+  return memcmp(a, b, sizeof(*a)) == 0;
+}
+
+// The decoded error is also compared with the error of the ciphertext (the
+// decoding failure rate of the decoders is negligible)
+static int e_eq_pad(IN const e_t *a, IN const pad_e_t *b)
+{
+  for(size_t i = 0; i < N0; i++) {
+    if(memcmp(a->val[i].raw, b->val[i].val.raw, R_BYTES) != 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+// The syndrome s = c0*h0 of a ciphertext, triplicated by ctx->dup
+static void syndrome_of_ct(OUT syndrome_t *s,
+                           IN const ct_t *ct,
+                           IN const decode_ctx *ctx)
+{
+  pad_r_t c0 = {0}, h0 = {0}, c0h0 = {0};
+
+  c0.val = ct->c0;
+  h0.val = inputs.sk.bin[0];
+  gf2x_mod_mul(&c0h0, &c0, &h0);
+
+  bike_memset(s, 0, sizeof(*s));
+  bike_memcpy((uint8_t *)s->qw, c0h0.val.raw, R_BYTES);
+  ctx->dup(s);
+
+  secure_clean((uint8_t *)&c0h0, sizeof(c0h0));
+}
+
+// The rotation plans of all the indices of the secret key
+static decode_plan_t plan;
+
+// The UPC engines of decode_ctx_set_upc_engine against upc_bit_slice, on the
+// syndromes of the ciphertexts, for every other threshold, with and without
+// the rotation plans. The decoders also decode the ciphertexts with every engine
+// as decode does.
+static void test_upc_engines(void)
+{
+  static const struct {
+    const char *name;
+    const char *decode_name;
+    uint32_t    engine;
+  } engines[] = {
+    {"upc_bytes", "decode (upc_bytes)", DECODE_UPC_BYTES},
+    {"upc_bit_slice_tiled", "decode (upc_bit_slice_tiled)", DECODE_UPC_TILED},
+    {"upc_joint_tiled", "decode (upc_joint_tiled)", DECODE_UPC_JOINT},
+  };
+
+  decode_ctx ref_ctx;
+  decode_ctx_init(&ref_ctx);
+  decode_ctx_set_upc_engine(&ref_ctx, DECODE_UPC_BIT_SLICE);
+
+  syndrome_t s;
+  pad_r_t    ref_thr, ref_delta, ge_thr, ge_delta;
+  pad_e_t    ref_e_thr, ref_e_delta, e_thr, e_delta;
+  e_t        ref_e, e;
+
+  for(size_t u = 0; u < sizeof(engines) / sizeof(engines[0]); u++) {
+    decode_ctx ctx;
+    int        ok = 1, ok_decode = 1;
+
+    decode_ctx_init(&ctx);
+    ok &= decode_ctx_set_upc_engine(&ctx, engines[u].engine);
+
+    for(size_t i = 0; i < N0; i++) {
+      for(size_t j = 0; j < D; j++) {
+        ctx.rotate_plan(&plan.rot[i][j], inputs.sk.wlist[i].val[j]);
+      }
+    }
+
+    for(size_t c = 0; ok && (c < NUM_OF_FEW_CTS); c++) {
+      syndrome_of_ct(&s, &inputs.ct[c], &ctx);
+
+      for(uint8_t thr = DELTA; thr <= D; thr += 2) {
+        for(size_t p = 0; p < 2; p++) {
+          const rotate_plan_t *rot = (p == 0) ? NULL : plan.rot[0];
+
+          for(size_t i = 0; i < N0; i++) {
+            const rotate_plan_t *rot_i = (rot == NULL) ? NULL : plan.rot[i];
+
+            ref_ctx.count_upc(&ref_thr, &ref_delta, &s, &inputs.sk.wlist[i],
+                              rot_i, thr, &ref_ctx);
+            ctx.count_upc(&ge_thr, &ge_delta, &s, &inputs.sk.wlist[i], rot_i,
+                          thr, &ctx);
+            ok &= pad_r_eq(&ge_thr, &ref_thr) && pad_r_eq(&ge_delta, &ref_delta);
+
+            ref_e_thr.val[i]   = ref_thr;
+            ref_e_delta.val[i] = ref_delta;
+          }
+
+          if(ctx.count_upc_joint != NULL) {
+            ctx.count_upc_joint(&e_thr, &e_delta, &s, inputs.sk.wlist, rot,
+                                thr, &ctx);
+            for(size_t i = 0; i < N0; i++) {
+              ok &= pad_r_eq(&e_thr.val[i], &ref_e_thr.val[i]) &&
+                    pad_r_eq(&e_delta.val[i], &ref_e_delta.val[i]);
+            }
+          }
+        }
+      }
+
+      decode(&ref_e, &inputs.ct[c], &inputs.sk);
+      decode_with_ctx(&e, &inputs.ct[c], &inputs.sk, &ctx);
+      ok_decode &= e_eq(&e, &ref_e) && e_eq_pad(&e, &inputs.e[c]);
+    }
+
+    report(engines[u].name, ok);
+    report(engines[u].decode_name, ok_decode);
+  }
+
+  secure_clean((uint8_t *)&plan, sizeof(plan));
+  secure_clean((uint8_t *)&s, sizeof(s));
+}
+
+// decode_multi against decode, for no ciphertexts, one ciphertext, up to one
+// group, and more than one group
+static void test_decode_multi(void)
+{
+  static const size_t sizes[] = {0, 1, DECODE_MULTI_MAX - 1, DECODE_MULTI_MAX,
+                                 DECODE_MULTI_MAX + 1, NUM_OF_CTS};
+
+  // e[n] is a guard that decode_multi must not write
+  static e_t ref[NUM_OF_CTS], e[NUM_OF_CTS + 1];
+  e_t        guard;
+  int        ok = 1;
+
+  for(size_t i = 0; i < NUM_OF_CTS; i++) {
+    decode(&ref[i], &inputs.ct[i], &inputs.sk);
+  }
+  bike_memset(&guard, 0xff, sizeof(guard));
+
+  for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    const size_t n = sizes[s];
+
+    bike_memset(e, 0xff, sizeof(e));
+    decode_multi(e, inputs.ct, n, &inputs.sk);
+
+    for(size_t i = 0; i < n; i++) {
+      ok &= e_eq(&e[i], &ref[i]);
+    }
+    ok &= e_eq(&e[n], &guard);
+  }
+
+  secure_clean((uint8_t *)ref, sizeof(ref));
+  secure_clean((uint8_t *)e, sizeof(e));
+
+  report("decode_multi", ok);
+}
+
+// decode_with_plan against decode, with the plan of the secret key, without
+// a plan, and with a plan of other rotate functions (that is recomputed)
+static void test_decode_with_plan(void)
+{
+  e_t ref, e;
+  int ok = 1, ok_null = 1, ok_other = 1;
+
+  decode_plan_init(&plan, &inputs.sk);
+
+  for(size_t i = 0; i < NUM_OF_FEW_CTS; i++) {
+    decode(&ref, &inputs.ct[i], &inputs.sk);
+
+    decode_with_plan(&e, &inputs.ct[i], &inputs.sk, &plan);
+    ok &= e_eq(&e, &ref);
+
+    decode_with_plan(&e, &inputs.ct[i], &inputs.sk, NULL);
+    ok_null &= e_eq(&e, &ref);
+  }
+
+  // The rotations of a plan of other block size are all wrong
+  bike_memset(plan.rot, 0xff, sizeof(plan.rot));
+  plan.block_bits += 1;
+
+  for(size_t i = 0; i < NUM_OF_FEW_CTS; i++) {
+    decode(&ref, &inputs.ct[i], &inputs.sk);
+    decode_with_plan(&e, &inputs.ct[i], &inputs.sk, &plan);
+    ok_other &= e_eq(&e, &ref);
+  }
+
+  secure_clean((uint8_t *)&plan, sizeof(plan));
+
+  report("decode_with_plan", ok);
+  report("decode_with_plan (NULL plan)", ok_null);
+  report("decode_with_plan (other plan)", ok_other);
+}
+
+// The decoders of the registry (BGF, BG, and Backflip) with every UPC engine
+// against the errors of the ciphertexts, and against the same decoder with
+// the bit-sliced counters
+static void test_decoders(void)
+{
+  static const uint32_t engines[] = {DECODE_UPC_BIT_SLICE, DECODE_UPC_BYTES,
+                                     DECODE_UPC_TILED, DECODE_UPC_JOINT};
+
+  e_t ref, e;
+
+  for(uint32_t d = 0; d < DECODER_NUM; d++) {
+    decode_ctx ctx;
+    int        ok = 1;
+
+    decode_ctx_init(&ctx);
+    ok &= decode_ctx_set_decoder(&ctx, d);
+
+    for(size_t i = 0; ok && (i < NUM_OF_FEW_CTS); i++) {
+      decode_ctx_set_upc_engine(&ctx, DECODE_UPC_BIT_SLICE);
+      decode_with_ctx(&ref, &inputs.ct[i], &inputs.sk, &ctx);
+      ok &= e_eq_pad(&ref, &inputs.e[i]);
+
+      for(size_t u = 1; u < sizeof(engines) / sizeof(engines[0]); u++) {
+        decode_ctx_set_upc_engine(&ctx, engines[u]);
+        decode_with_ctx(&e, &inputs.ct[i], &inputs.sk, &ctx);
+        ok &= e_eq(&e, &ref);
+      }
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "decode_with_ctx (%s)", decoders[d].name);
+    report(name, ok);
+  }
+}
+
+// The results of gf2x_mod_mul, gf2x_mod_inv, and decode on the inputs
+typedef struct isa_results_s {
+  pad_r_t prod[NUM_OF_FEW_CTS];
+  pad_r_t inv;
+  e_t     e[NUM_OF_FEW_CTS];
+} isa_results_t;
+
+// The results of the first ISA cap (BIKE_ISA_AUTO), and of the current one
+static isa_results_t auto_results, results;
+
+// The results of the ISA cap against those of BIKE_ISA_AUTO
+static void test_isa_cap(IN const int first)
+{
+  pad_r_t c0 = {0}, h0 = {0};
+  int     ok = 1;
+
+  h0.val = inputs.sk.bin[0];
+  gf2x_mod_inv(&results.inv, &h0);
+
+  for(size_t i = 0; i < NUM_OF_FEW_CTS; i++) {
+    c0.val = inputs.ct[i].c0;
+    gf2x_mod_mul(&results.prod[i], &c0, &h0);
+    decode(&results.e[i], &inputs.ct[i], &inputs.sk);
+  }
+
+  if(first) {
+    auto_results = results;
+    return;
+  }
+
+  ok &= pad_r_eq(&results.inv, &auto_results.inv);
+  for(size_t i = 0; i < NUM_OF_FEW_CTS; i++) {
+    ok &= pad_r_eq(&results.prod[i], &auto_results.prod[i]);
+    ok &= e_eq(&results.e[i], &auto_results.e[i]);
+  }
+
+  report("gf2x_mod_mul, gf2x_mod_inv, and decode (against auto)", ok);
+}
+
+// The caps of the ISA policy of the architecture
+// gf2x_mod_mul and gf2x_mod_inv under every mul_base and several thresholds
+// of the tuning profile, against the results of the auto cap
+static void test_tune_profiles(void)
+{
+  static const uint32_t thrs[] = {0, GF2X_DEFAULT_K_SQR_THR, UINT32_MAX};
+  gf2x_tune_profile_t   saved, p, q;
+  pad_r_t               c0 = {0}, h0 = {0}, prod, inv;
+  int                   ok = 1, ok_get = 1;
+
+  gf2x_tune_profile(&saved);
+  h0.val = inputs.sk.bin[0];
+  c0.val = inputs.ct[0].c0;
+
+  for(uint32_t base = 0; base <= GF2X_MUL_BASE_NUM; base++) {
+    for(size_t t = 0; t < sizeof(thrs) / sizeof(thrs[0]); t++) {
+      p           = saved;
+      p.k_sqr_thr = thrs[t];
+      p.mul_base  = base;
+      bike_set_tune_profile(&p);
+
+      // An unknown mul_base is replaced, and a threshold above every k is
+      // clamped
+      gf2x_tune_profile(&q);
+      ok_get &= (q.mul_base == ((base < GF2X_MUL_BASE_NUM) ? base : 0));
+      ok_get &= (thrs[t] == UINT32_MAX) ? (q.k_sqr_thr >= R_BITS)
+                                        : (q.k_sqr_thr == thrs[t]);
+
+      gf2x_mod_mul(&prod, &c0, &h0);
+      gf2x_mod_inv(&inv, &h0);
+      ok &= pad_r_eq(&prod, &auto_results.prod[0]);
+      ok &= pad_r_eq(&inv, &auto_results.inv);
+    }
+  }
+
+  bike_set_tune_profile(&saved);
+  report("gf2x_tune_profile (after bike_set_tune_profile)", ok_get);
+  report("gf2x_mod_mul and gf2x_mod_inv (tuning profiles, against auto)", ok);
+}
+
+static const uint32_t isa_caps[] = {
+  BIKE_ISA_AUTO,
+  BIKE_ISA_PORTABLE,
+#if defined(X86_64)
+  BIKE_ISA_AVX2,
+  BIKE_ISA_AVX512,
+#elif defined(AARCH64)
+  BIKE_ISA_NEON,
+#endif
+};
+
+#if defined(__unix__) || defined(__APPLE__)
+// The time (in seconds) that the child process of test_fork may take
+#  define FORK_TIMEOUT (20)
+
+// The KEM in a child process, after the parent ran it (and created the
+// helper threads of LATENCY_MODE, that the child does not inherit)
+static void test_fork(void)
+{
+  ct_t ct;
+  ss_t ss_enc, ss_dec;
+
+  // Encapsulate once in the parent, so every operation ran before the fork
+  if(crypto_kem_enc((uint8_t *)&ct, (uint8_t *)&ss_enc,
+                    (const uint8_t *)&inputs.pk) != 0) {
+    report("crypto_kem_enc and crypto_kem_dec after fork", 0);
+    return;
+  }
+
+  fflush(stdout);
+  const pid_t pid = fork();
+  if(pid == 0) {
+    // The child is killed (and the test fails) if an operation hangs
+    alarm(FORK_TIMEOUT);
+
+    const int ok =
+      (crypto_kem_enc((uint8_t *)&ct, (uint8_t *)&ss_enc,
+                      (const uint8_t *)&inputs.pk) == 0) &&
+      (crypto_kem_dec((uint8_t *)&ss_dec, (const uint8_t *)&ct,
+                      (const uint8_t *)&inputs.sk) == 0) &&
+      (memcmp(&ss_enc, &ss_dec, sizeof(ss_enc)) == 0);
+    _exit(ok ? 0 : 1);
+  }
+
+  int status = 0;
+  const int ok = (pid > 0) && (waitpid(pid, &status, 0) == pid) &&
+                 WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+
+  secure_clean((uint8_t *)&ss_enc, sizeof(ss_enc));
+  report("crypto_kem_enc and crypto_kem_dec after fork", ok);
+}
+#endif
+
+int main(void)
+{
+  // Initialize the CPU features flags
+  cpu_features_init();
+
+#if defined(AARCH64)
+  // Checked by tests/test_aarch64_qemu.sh
+  printf("PMULL: %s\n", is_pmull_enabled() ? "yes" : "no");
+#endif
+
+#if defined(FIXED_SEED)
+  srand(0);
+#else
+  srand(time(NULL));
+#endif
+
+  if(!init_decode_inputs()) {
+    printf("The generation of the decoding inputs failed\n");
+    return 1;
+  }
+
+  for(size_t c = 0; c < sizeof(isa_caps) / sizeof(isa_caps[0]); c++) {
+    const bike_isa_policy_t policy = {isa_caps[c], isa_caps[c], isa_caps[c]};
+
+    // BIKE_TARGET_ISA builds have no policy, so only their kernels are tested
+    if(!bike_set_isa_policy(&policy) && (isa_caps[c] != BIKE_ISA_AUTO)) {
+      continue;
+    }
+
+    bike_isa_policy_t tiers;
+    bike_get_isa_tiers(&tiers);
+    printf("ISA cap %s (tiers: gf2x %s, decode %s, sampling %s)\n",
+           bike_isa_name(isa_caps[c]), bike_isa_name(tiers.gf2x),
+           bike_isa_name(tiers.decode), bike_isa_name(tiers.sampling));
+
+    test_mod_mul_xn();
+    test_mod_mul_prepared();
+    test_mod_mul_acc();
+    test_upc_engines();
+    test_decode_multi();
+    test_decode_with_plan();
+    test_decoders();
+    test_isa_cap(c == 0);
+    test_tune_profiles();
+  }
+
+  const bike_isa_policy_t auto_policy = {BIKE_ISA_AUTO, BIKE_ISA_AUTO,
+                                         BIKE_ISA_AUTO};
+  bike_set_isa_policy(&auto_policy);
+
+#if defined(__unix__) || defined(__APPLE__)
+  test_fork();
+#endif
+
+  secure_clean((uint8_t *)&inputs, sizeof(inputs));
+  secure_clean((uint8_t *)&auto_results, sizeof(auto_results));
+  secure_clean((uint8_t *)&results, sizeof(results));
+
+  return (failures == 0) ? 0 : 1;
+}
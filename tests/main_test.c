@@ -16,6 +16,10 @@
 #include "utilities.h"
 #include "cpu_features.h"
 
+#if defined(BIKE_PREFIX)
+#  include "bike_kem.h"
+#endif
+
 #if !defined(NUM_OF_TESTS)
 #  define NUM_OF_TESTS 1
 #endif
@@ -37,6 +41,50 @@ typedef struct magic_number_s {
     printf("Magic is incorrect for param\n");                       \
   }
 
+#if defined(BIKE_PREFIX)
+// A round trip with every instance of the MULTI_LEVEL library,
+// through the front end. Returns the number of instances that failed.
+static uint32_t test_instances(void)
+{
+  const uint32_t levels[] = {1, 3, 5};
+  uint32_t       failures = 0;
+
+  for(size_t l = 0; l < (sizeof(levels) / sizeof(levels[0])); l++) {
+    for(uint32_t variant = 0; variant < 4; variant++) {
+      const bike_kem_t *kem = bike_kem_get(levels[l], variant);
+      if(kem == NULL) {
+        continue;
+      }
+
+      unsigned char *pk    = malloc(kem->pk_bytes);
+      unsigned char *sk    = malloc(kem->sk_bytes);
+      unsigned char *ct    = malloc(kem->ct_bytes);
+      unsigned char *k_enc = malloc(kem->ss_bytes);
+      unsigned char *k_dec = malloc(kem->ss_bytes);
+
+      const int res = (pk == NULL) || (sk == NULL) || (ct == NULL) ||
+                      (k_enc == NULL) || (k_dec == NULL) ||
+                      (kem->keypair(pk, sk) != 0) ||
+                      (kem->enc(ct, k_enc, pk) != 0) ||
+                      (kem->dec(k_dec, ct, sk) != 0) ||
+                      (memcmp(k_enc, k_dec, kem->ss_bytes) != 0);
+
+      printf("Instance of level %u variant %u: %s\n", kem->level,
+             kem->variant, res ? "Failure!" : "Success!");
+      failures += res;
+
+      free(pk);
+      free(sk);
+      free(ct);
+      free(k_enc);
+      free(k_dec);
+    }
+  }
+
+  return failures;
+}
+#endif
+
 ////////////////////////////////////////////////////////////////
 //                 Main function for testing
 ////////////////////////////////////////////////////////////////
@@ -51,6 +99,13 @@ int main(void)
   srand(time(NULL));
 #endif
 
+  // The tiers of the kernels (see bike_set_isa_policy)
+  bike_isa_policy_t tiers;
+  bike_get_isa_tiers(&tiers);
+  printf("ISA tiers: gf2x %s, decode %s, sampling %s\n",
+         bike_isa_name(tiers.gf2x), bike_isa_name(tiers.decode),
+         bike_isa_name(tiers.sampling));
+
   magic_number_t magic = {0xa1234567b1234567, 0xc1234567d1234567,
                           0xe1234567f1234567, 0x0123456711234567};
 
@@ -111,5 +166,12 @@ int main(void)
           SIZEOF_BITS(k_enc.val));
   }
 
+#if defined(BIKE_PREFIX)
+  // Run by CTest in MULTI_LEVEL builds
+  if(test_instances() != 0) {
+    return 1;
+  }
+#endif
+
   return 0;
 }
@@ -48,6 +48,7 @@ source $(dirname $0)/test_kats.sh
 source $(dirname $0)/test_sanitizers.sh
 source $(dirname $0)/test_format.sh
 source $(dirname $0)/test_clang_tidy.sh
+source $(dirname $0)/test_aarch64_qemu.sh
 
 # Create a clean build directory
 rm -rf build/
@@ -80,6 +81,7 @@ if [ "${test_num}" -lt "3" ]; then
   test_sanitizers 2 # Test the round3 + binded pk and m version
   test_sanitizers 3 # Test the round3 + sha3 and shake version
   test_sanitizers 4 # Test the round3 + binded pk and m and sha3 version
+  test_aarch64_qemu # Test the AArch64 code in qemu, with and without PMULL
 fi
 
 cd ${basedir}
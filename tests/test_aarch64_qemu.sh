@@ -0,0 +1,46 @@
+#!/bin/bash
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0"
+
+# Cross-compiles the package for AArch64 and runs CTest (the kernels and the
+# KATs) in qemu-aarch64, see cmake/toolchain-aarch64-qemu.cmake. Every level
+# is tested on an emulated CPU with PMULL (max) and on one without it (a64fx,
+# which does not implement the cryptographic extension).
+# Requires the gcc-aarch64-linux-gnu, qemu-user and libssl-dev:arm64
+# (Debian multiarch) packages, and is skipped if the tools are not found.
+aarch64_triplet=aarch64-linux-gnu
+aarch64_cpus="max:yes a64fx:no"
+
+function test_aarch64_qemu {
+  if ! command -v ${aarch64_triplet}-gcc &> /dev/null ||
+     ! command -v qemu-aarch64 &> /dev/null
+  then
+    >&2 echo "${aarch64_triplet}-gcc or qemu-aarch64 could not be found"
+    return
+  fi
+
+  # The OpenSSL headers of the multiarch package are searched after the
+  # headers of the sysroot, so they do not shadow the C library of AArch64
+  openssl_flags=(
+    "-DOPENSSL_CRYPTO_LIBRARY=/usr/lib/${aarch64_triplet}/libcrypto.so"
+    "-DOPENSSL_INCLUDE_DIR=/usr/include/${aarch64_triplet}"
+    "-DCMAKE_C_FLAGS=-idirafter /usr/include")
+
+  for level in "1" "3" "5"; do
+    cmake -DCMAKE_TOOLCHAIN_FILE=../cmake/toolchain-aarch64-qemu.cmake \
+          -DCMAKE_BUILD_TYPE=Release -DLEVEL=${level} -DUSE_NIST_RAND=1 \
+          "${openssl_flags[@]}" ..;
+    make -j
+
+    for cpu_pmull in ${aarch64_cpus}; do
+      cpu=${cpu_pmull%:*}
+      pmull=${cpu_pmull#*:}
+
+      # Check that the emulated CPU takes the expected code path
+      QEMU_CPU=${cpu} qemu-aarch64 -L /usr/${aarch64_triplet} \
+        tests/bike-kernels-test | grep "PMULL: ${pmull}"
+      QEMU_CPU=${cpu} ctest --output-on-failure
+    done
+    rm -rf *
+  done
+}
@@ -0,0 +1,144 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ *
+ * Decodes the same random errors with all the decoders of the registry
+ * (see decode_ctx_set_decoder), and prints their average cycles and their
+ * observed decoding failure rate (DFR) side by side, e.g.:
+ *   ./bike-decoders -n 10000
+ * A new key pair is generated every KEY_TRIALS trials. Note that the DFR of
+ * the decoders is far below what can be observed, so a few failures (or none)
+ * only bound the DFR of the weaker schedules.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cleanup.h"
+#include "cpu_features.h"
+#include "decode.h"
+#include "decode_internal.h"
+#include "gf2x.h"
+#include "kem.h"
+#include "measurements.h"
+#include "sampling.h"
+
+#define KEY_TRIALS (100)
+
+typedef struct decoder_stats_s {
+  uint64_t cycles;
+  uint64_t failures;
+} decoder_stats_t;
+
+static void usage(IN const char *name)
+{
+  fprintf(stderr,
+          "Usage: %s [-n TRIALS]\n"
+          "  -n  the number of errors to decode (default: 1000)\n",
+          name);
+}
+
+// Generate a random error e and the ciphertext c0 = e0 + pk*e1
+static int generate_ct(OUT ct_t *ct, OUT pad_e_t *e, IN const pk_t *pk)
+{
+  seeds_t seeds;
+  pad_r_t p_pk = {0};
+  pad_r_t c0   = {0};
+
+  get_seeds(&seeds);
+  if(generate_error_vector(e, &seeds.seed[0]) != SUCCESS) {
+    return 0;
+  }
+
+  p_pk.val = *pk;
+  gf2x_mod_mul(&c0, &e->val[1], &p_pk);
+  gf2x_mod_add(&c0, &c0, &e->val[0]);
+  ct->c0 = c0.val;
+
+  return 1;
+}
+
+int main(int argc, char *argv[])
+{
+  size_t trials = 1000;
+
+  if(argc == 3 && (strcmp(argv[1], "-n") == 0)) {
+    trials = strtoul(argv[2], NULL, 10);
+  } else if(argc != 1) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  if(trials == 0) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  cpu_features_init();
+
+#if defined(FIXED_SEED)
+  srand(0);
+#else
+  srand(time(NULL));
+#endif
+
+  decode_ctx ctx[DECODER_NUM];
+  for(uint32_t d = 0; d < DECODER_NUM; d++) {
+    decode_ctx_init(&ctx[d]);
+    decode_ctx_set_decoder(&ctx[d], d);
+  }
+
+  decoder_stats_t stats[DECODER_NUM] = {0};
+  aligned_sk_t    sk                 = {0};
+  pk_t            pk                 = {0};
+  ct_t            ct                 = {0};
+  pad_e_t         e                  = {0};
+  e_t             dec_e              = {0};
+
+  for(size_t t = 0; t < trials; t++) {
+    if((t % KEY_TRIALS) == 0) {
+      if(crypto_kem_keypair((uint8_t *)&pk, (uint8_t *)&sk) != 0) {
+        fprintf(stderr, "Keypair failed\n");
+        return 1;
+      }
+    }
+
+    if(!generate_ct(&ct, &e, &pk)) {
+      fprintf(stderr, "Error generation failed\n");
+      return 1;
+    }
+
+    for(uint32_t d = 0; d < DECODER_NUM; d++) {
+      const uint64_t start = get_cycles();
+      decode_with_ctx(&dec_e, &ct, &sk, &ctx[d]);
+      stats[d].cycles += get_cycles() - start;
+
+      for(size_t i = 0; i < N0; i++) {
+        if(memcmp(dec_e.val[i].raw, e.val[i].val.raw, R_BYTES) != 0) {
+          stats[d].failures++;
+          break;
+        }
+      }
+    }
+  }
+
+  printf("Level %d, %zu trials\n", LEVEL, trials);
+  printf("%-10s %10s %14s %10s %12s\n", "decoder", "iterations", "cycles",
+         "failures", "DFR");
+  for(uint32_t d = 0; d < DECODER_NUM; d++) {
+    printf("%-10s %10" PRIu32 " %14" PRIu64 " %10" PRIu64 " %12.3e\n",
+           decoders[d].name, decoders[d].max_it, stats[d].cycles / trials,
+           stats[d].failures, (double)stats[d].failures / (double)trials);
+  }
+
+  secure_clean((uint8_t *)&sk, sizeof(sk));
+  secure_clean((uint8_t *)&e, sizeof(e));
+  secure_clean((uint8_t *)&dec_e, sizeof(dec_e));
+
+  return 0;
+}
@@ -0,0 +1,654 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ *
+ * Monte-Carlo estimation of the decoding failure rate (DFR) of the decoder
+ * of the build (or of another decoder of the registry, see -d).
+ *
+ * Every trial generates a key pair and an errors vector from seeds that are
+ * derived from the seed of the run (-S) and from the index of the trial, and
+ * computes the ciphertext as in encapsulation (c0 = e0 + pk*e1). The
+ * ciphertext is decoded with a traced decode context, which records the
+ * weight of the syndrome at the start of every iteration and at the end.
+ * The trial fails if the final syndrome is not zero, or if the decoded
+ * errors vector differs from the generated one. The key pair is replaced
+ * every -k trials.
+ *
+ * The trials run on -t threads (default: all the cores). The run can be
+ * sharded over processes with -s INDEX/COUNT, where shard INDEX runs the
+ * trials INDEX, INDEX + COUNT, INDEX + 2*COUNT, ..., so shards of the same
+ * seed never repeat a trial, and their counters can be summed.
+ *
+ * The counters, the convergence distribution (the number of iterations after
+ * which the syndrome is zero for the first time) and the histograms of the
+ * syndrome weight per iteration are written to the checkpoint file (-c)
+ * every -i seconds, at the end, and on SIGINT/SIGTERM. A run with an existing
+ * checkpoint file resumes from it. With -o, a line per failed trial (as soon
+ * as it is found) and a progress line per checkpoint are appended to the
+ * given file. A run that fails to generate a trial stops, and its checkpoint
+ * holds the trials before the failed one. The failed trials after the last
+ * checkpoint are appended again when a run is resumed, and every failed trial
+ * can be reproduced with -x TRIAL, e.g.:
+ *   ./bike-dfr -n 1000000000 -S 7 -s 0/4 -c dfr0.ckpt -o dfr0.log
+ *   ./bike-dfr -S 7 -x 123456
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cleanup.h"
+#include "cpu_features.h"
+#include "decode.h"
+#include "decode_internal.h"
+#include "gf2x.h"
+#include "sampling.h"
+
+// The width of the buckets of the syndrome weight histograms
+#define HIST_WIDTH   (32)
+#define HIST_BUCKETS (DIVIDE_AND_CEIL(R_BITS + 1, HIST_WIDTH))
+
+// The domains of the seeds of a trial
+#define DOMAIN_KEY   (0)
+#define DOMAIN_ERROR (1)
+
+#define CKPT_VERSION (1)
+
+typedef struct dfr_config_s {
+  uint64_t    trials;
+  uint64_t    seed;
+  uint64_t    shard;
+  uint64_t    shards;
+  uint64_t    key_trials;
+  uint64_t    chunk;
+  uint64_t    interval;
+  uint32_t    threads;
+  uint32_t    decoder;
+  const char *ckpt_path;
+  const char *out_path;
+} dfr_config_t;
+
+typedef struct dfr_stats_s {
+  uint64_t trials;
+  uint64_t failures;
+  // converged[k] counts the trials whose syndrome is zero for the first time
+  // after k iterations, the other trials did not converge.
+  uint64_t converged[DECODER_MAX_IT + 1];
+  // hist[k] is the histogram of the syndrome weight at the start of
+  // iteration k, and after the last iteration (k = max_it).
+  uint64_t hist[DECODER_MAX_IT + 1][HIST_BUCKETS];
+} dfr_stats_t;
+
+typedef struct dfr_worker_s {
+  pthread_t           thread;
+  const dfr_config_t *cfg;
+  // The log of the failed trials (-o), or NULL
+  FILE *out;
+  // The (local) trials [first, last) of the round. On an error, last is
+  // set to the trial that failed to run.
+  uint64_t    first;
+  uint64_t    last;
+  uint32_t    error;
+  dfr_stats_t stats;
+} dfr_worker_t;
+
+// Serializes the lines of the workers in the log
+static pthread_mutex_t out_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static volatile sig_atomic_t stop_requested;
+
+static void on_signal(int sig)
+{
+  (void)sig;
+  stop_requested = 1;
+}
+
+_INLINE_ uint64_t mix64(IN uint64_t x)
+{
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+// Derive the seed of the given domain and index from the seed of the run
+// (with splitmix64). The seeds are expanded by the PRF of the library,
+// so they only have to be distinct.
+static void derive_seed(OUT seed_t *s,
+                        IN const uint64_t run_seed,
+                        IN const uint64_t domain,
+                        IN const uint64_t idx)
+{
+  uint64_t state = mix64(run_seed + mix64((2 * idx) + domain));
+
+  for(size_t i = 0; i < sizeof(s->raw); i += sizeof(uint64_t)) {
+    state += 0x9e3779b97f4a7c15ULL;
+    const uint64_t v = mix64(state);
+    bike_memcpy(&s->raw[i], &v, sizeof(v));
+  }
+}
+
+// Generate the key pair of the given index, as in crypto_kem_keypair
+static int generate_key(OUT sk_t *sk,
+                        IN const uint64_t run_seed,
+                        IN const uint64_t idx)
+{
+  DEFER_CLEANUP(seed_t seed, seed_cleanup);
+  DEFER_CLEANUP(pad_r_t h0 = {0}, pad_r_cleanup);
+  DEFER_CLEANUP(pad_r_t h1 = {0}, pad_r_cleanup);
+  DEFER_CLEANUP(pad_r_t h0inv = {0}, pad_r_cleanup);
+  DEFER_CLEANUP(pad_r_t h = {0}, pad_r_cleanup);
+
+  derive_seed(&seed, run_seed, DOMAIN_KEY, idx);
+  if(generate_secret_key(&h0, &h1, sk->wlist[0].val, sk->wlist[1].val,
+                         &seed) != SUCCESS) {
+    return 0;
+  }
+
+  gf2x_mod_inv(&h0inv, &h0);
+  gf2x_mod_mul(&h, &h1, &h0inv);
+
+  sk->bin[0] = h0.val;
+  sk->bin[1] = h1.val;
+  sk->pk     = h.val;
+
+  return 1;
+}
+
+// Run the trial g (a global index) with the key sk, and return 1 if the
+// decoding failed (and 0 if it succeeded, or -1 on an error).
+static int run_trial(OUT decode_trace_t *trace,
+                     IN const sk_t *sk,
+                     IN const uint64_t    run_seed,
+                     IN const uint64_t    g,
+                     IN const decode_ctx *ctx)
+{
+  DEFER_CLEANUP(seed_t seed, seed_cleanup);
+  DEFER_CLEANUP(pad_e_t e = {0}, pad_e_cleanup);
+  DEFER_CLEANUP(e_t dec_e = {0}, e_cleanup);
+  DEFER_CLEANUP(pad_r_t c0 = {0}, pad_r_cleanup);
+  DEFER_CLEANUP(pad_r_t p_pk = {0}, pad_r_cleanup);
+  DEFER_CLEANUP(ct_t ct = {0}, ct_cleanup);
+
+  derive_seed(&seed, run_seed, DOMAIN_ERROR, g);
+  if(generate_error_vector(&e, &seed) != SUCCESS) {
+    return -1;
+  }
+
+  p_pk.val = sk->pk;
+  gf2x_mod_mul(&c0, &e.val[1], &p_pk);
+  gf2x_mod_add(&c0, &c0, &e.val[0]);
+  ct.c0 = c0.val;
+
+  decode_with_ctx(&dec_e, &ct, sk, ctx);
+
+  if(trace->weight[ctx->decoder->max_it] != 0) {
+    return 1;
+  }
+
+  for(size_t i = 0; i < N0; i++) {
+    if(memcmp(dec_e.val[i].raw, e.val[i].val.raw, R_BYTES) != 0) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+static void add_trace(OUT dfr_stats_t *stats,
+                      IN const decode_trace_t *trace,
+                      IN const uint32_t        max_it)
+{
+  uint32_t converged = 0;
+
+  for(uint32_t k = 0; k <= max_it; k++) {
+    stats->hist[k][trace->weight[k] / HIST_WIDTH]++;
+
+    if(!converged && (trace->weight[k] == 0)) {
+      stats->converged[k]++;
+      converged = 1;
+    }
+  }
+}
+
+static void *dfr_worker(void *arg)
+{
+  dfr_worker_t *      w   = (dfr_worker_t *)arg;
+  const dfr_config_t *cfg = w->cfg;
+
+  decode_trace_t trace = {0};
+  decode_ctx     ctx;
+  decode_ctx_init(&ctx);
+  decode_ctx_set_decoder(&ctx, cfg->decoder);
+  ctx.trace = &trace;
+
+  DEFER_CLEANUP(aligned_sk_t sk = {0}, sk_cleanup);
+  uint64_t key      = 0;
+  uint32_t key_init = 0;
+
+  for(uint64_t t = w->first; t < w->last; t++) {
+    const uint64_t g = (t * cfg->shards) + cfg->shard;
+
+    if(!key_init || ((g / cfg->key_trials) != key)) {
+      key      = g / cfg->key_trials;
+      key_init = 1;
+      if(!generate_key(&sk, cfg->seed, key)) {
+        w->error = 1;
+        w->last  = t;
+        return NULL;
+      }
+    }
+
+    const int res = run_trial(&trace, &sk, cfg->seed, g, &ctx);
+    if(res < 0) {
+      w->error = 1;
+      w->last  = t;
+      return NULL;
+    }
+
+    w->stats.trials++;
+    add_trace(&w->stats, &trace, ctx.decoder->max_it);
+
+    // Every failed trial is logged as soon as it is found
+    if(res == 1) {
+      w->stats.failures++;
+      if(w->out != NULL) {
+        pthread_mutex_lock(&out_lock);
+        fprintf(w->out, "fail trial %" PRIu64 " weight %" PRIu32 "\n", g,
+                trace.weight[ctx.decoder->max_it]);
+        fflush(w->out);
+        pthread_mutex_unlock(&out_lock);
+      }
+    }
+  }
+
+  return NULL;
+}
+
+static void add_stats(IN OUT dfr_stats_t *total, IN const dfr_stats_t *s)
+{
+  total->trials += s->trials;
+  total->failures += s->failures;
+
+  for(size_t k = 0; k <= DECODER_MAX_IT; k++) {
+    total->converged[k] += s->converged[k];
+    for(size_t b = 0; b < HIST_BUCKETS; b++) {
+      total->hist[k][b] += s->hist[k][b];
+    }
+  }
+}
+
+static void write_state(OUT FILE *f,
+                        IN const dfr_config_t *cfg,
+                        IN const uint64_t      next,
+                        IN const dfr_stats_t *stats)
+{
+  const uint32_t max_it = decoders[cfg->decoder].max_it;
+
+  fprintf(f, "bike-dfr-checkpoint %d\n", CKPT_VERSION);
+  fprintf(f, "level %d\n", LEVEL);
+  fprintf(f, "decoder %s\n", decoders[cfg->decoder].name);
+  fprintf(f, "seed %" PRIu64 "\n", cfg->seed);
+  fprintf(f, "shard %" PRIu64 " %" PRIu64 "\n", cfg->shard, cfg->shards);
+  fprintf(f, "key_trials %" PRIu64 "\n", cfg->key_trials);
+  fprintf(f, "next %" PRIu64 "\n", next);
+  fprintf(f, "trials %" PRIu64 "\n", stats->trials);
+  fprintf(f, "failures %" PRIu64 "\n", stats->failures);
+
+  fprintf(f, "converged");
+  for(uint32_t k = 0; k <= max_it; k++) {
+    fprintf(f, " %" PRIu64, stats->converged[k]);
+  }
+  fprintf(f, "\n");
+
+  fprintf(f, "hist_width %d\n", HIST_WIDTH);
+  for(uint32_t k = 0; k <= max_it; k++) {
+    fprintf(f, "hist %" PRIu32, k);
+    for(size_t b = 0; b < HIST_BUCKETS; b++) {
+      fprintf(f, " %" PRIu64, stats->hist[k][b]);
+    }
+    fprintf(f, "\n");
+  }
+}
+
+// Read a checkpoint of the same run (level, decoder, seed, shard and key
+// trials) into next and stats. Returns 0 if it is invalid or of another run.
+static int read_state(IN FILE *f,
+                      IN const dfr_config_t *cfg,
+                      OUT uint64_t *         next,
+                      OUT dfr_stats_t *stats)
+{
+  const uint32_t max_it = decoders[cfg->decoder].max_it;
+
+  char     name[64];
+  uint32_t version;
+  uint32_t level;
+  uint32_t width;
+  uint64_t seed;
+  uint64_t shard;
+  uint64_t shards;
+  uint64_t key_trials;
+
+  if(fscanf(f,
+            " bike-dfr-checkpoint %" SCNu32 " level %" SCNu32 " decoder %63s"
+            " seed %" SCNu64 " shard %" SCNu64 " %" SCNu64
+            " key_trials %" SCNu64 " next %" SCNu64 " trials %" SCNu64
+            " failures %" SCNu64 " converged",
+            &version, &level, name, &seed, &shard, &shards, &key_trials, next,
+            &stats->trials, &stats->failures) != 10) {
+    return 0;
+  }
+
+  if((version != CKPT_VERSION) || (level != LEVEL) ||
+     (strcmp(name, decoders[cfg->decoder].name) != 0) || (seed != cfg->seed) ||
+     (shard != cfg->shard) || (shards != cfg->shards) ||
+     (key_trials != cfg->key_trials)) {
+    return 0;
+  }
+
+  for(uint32_t k = 0; k <= max_it; k++) {
+    if(fscanf(f, " %" SCNu64, &stats->converged[k]) != 1) {
+      return 0;
+    }
+  }
+
+  if((fscanf(f, " hist_width %" SCNu32, &width) != 1) ||
+     (width != HIST_WIDTH)) {
+    return 0;
+  }
+
+  for(uint32_t k = 0; k <= max_it; k++) {
+    uint32_t idx;
+    if((fscanf(f, " hist %" SCNu32, &idx) != 1) || (idx != k)) {
+      return 0;
+    }
+    for(size_t b = 0; b < HIST_BUCKETS; b++) {
+      if(fscanf(f, " %" SCNu64, &stats->hist[k][b]) != 1) {
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+// Write the checkpoint to a temporary file, and rename it over the
+// checkpoint file, so a restart always finds a complete checkpoint.
+static int write_checkpoint(IN const dfr_config_t *cfg,
+                            IN const uint64_t      next,
+                            IN const dfr_stats_t *stats)
+{
+  char tmp_path[4096];
+  snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", cfg->ckpt_path);
+
+  FILE *f = fopen(tmp_path, "w");
+  if(f == NULL) {
+    perror(tmp_path);
+    return 0;
+  }
+
+  write_state(f, cfg, next, stats);
+  if(fclose(f) != 0) {
+    perror(tmp_path);
+    return 0;
+  }
+
+  if(rename(tmp_path, cfg->ckpt_path) != 0) {
+    perror(cfg->ckpt_path);
+    return 0;
+  }
+
+  return 1;
+}
+
+static void write_progress(OUT FILE *out, IN const dfr_stats_t *stats)
+{
+  fprintf(out,
+          "progress time %lld trials %" PRIu64 " failures %" PRIu64
+          " dfr %.3e\n",
+          (long long)time(NULL), stats->trials, stats->failures,
+          (double)stats->failures / (double)stats->trials);
+  fflush(out);
+}
+
+// Run the global trial g, and print its trace
+static int replay_trial(IN const dfr_config_t *cfg, IN const uint64_t g)
+{
+  decode_trace_t trace = {0};
+  decode_ctx     ctx;
+  decode_ctx_init(&ctx);
+  decode_ctx_set_decoder(&ctx, cfg->decoder);
+  ctx.trace = &trace;
+
+  DEFER_CLEANUP(aligned_sk_t sk = {0}, sk_cleanup);
+  if(!generate_key(&sk, cfg->seed, g / cfg->key_trials)) {
+    return 0;
+  }
+
+  const int res = run_trial(&trace, &sk, cfg->seed, g, &ctx);
+  if(res < 0) {
+    return 0;
+  }
+
+  printf("trial %" PRIu64 " (%s):", g, (res == 1) ? "failed" : "decoded");
+  for(uint32_t k = 0; k <= ctx.decoder->max_it; k++) {
+    printf(" %" PRIu32, trace.weight[k]);
+  }
+  printf("\n");
+
+  return 1;
+}
+
+static void usage(IN const char *name)
+{
+  fprintf(stderr,
+          "Usage: %s [-n TRIALS] [-t THREADS] [-s INDEX/COUNT] [-S SEED] "
+          "[-k KEY_TRIALS] [-d DECODER] [-c FILE] [-i SECONDS] [-o FILE] "
+          "[-b CHUNK] [-x TRIAL]\n"
+          "  -n  the number of trials of this shard (default 1000)\n"
+          "  -t  the number of threads (default: the number of cores)\n"
+          "  -s  run the shard INDEX of COUNT shards (default 0/1)\n"
+          "  -S  the seed of the run (default 0)\n"
+          "  -k  the number of trials per key pair (default 1)\n"
+          "  -d  the decoder (default %s)\n"
+          "  -c  the checkpoint file, resumed if it exists\n"
+          "  -i  the interval between checkpoints in seconds (default 60)\n"
+          "  -o  append the failed trials and the progress to FILE\n"
+          "  -b  the number of trials per thread per round (default 64)\n"
+          "  -x  replay the (global) trial TRIAL, and print its trace\n",
+          name, decoders[DECODER_DEFAULT].name);
+}
+
+int main(int argc, char *argv[])
+{
+  dfr_config_t cfg       = {0};
+  uint64_t     replay    = 0;
+  uint32_t     do_replay = 0;
+
+  cfg.trials     = 1000;
+  cfg.shards     = 1;
+  cfg.key_trials = 1;
+  cfg.chunk      = 64;
+  cfg.interval   = 60;
+  cfg.decoder    = DECODER_DEFAULT;
+
+  const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  cfg.threads      = (cores > 0) ? (uint32_t)cores : 1;
+
+  for(int i = 1; i < argc; i++) {
+    if((argv[i][0] != '-') || (strlen(argv[i]) != 2) || (i + 1 == argc)) {
+      usage(argv[0]);
+      return 1;
+    }
+
+    const char *arg = argv[++i];
+    switch(argv[i - 1][1]) {
+      case 'n': cfg.trials = strtoull(arg, NULL, 0); break;
+      case 't': cfg.threads = (uint32_t)strtoul(arg, NULL, 0); break;
+      case 'S': cfg.seed = strtoull(arg, NULL, 0); break;
+      case 'k': cfg.key_trials = strtoull(arg, NULL, 0); break;
+      case 'c': cfg.ckpt_path = arg; break;
+      case 'i': cfg.interval = strtoull(arg, NULL, 0); break;
+      case 'o': cfg.out_path = arg; break;
+      case 'b': cfg.chunk = strtoull(arg, NULL, 0); break;
+      case 'x':
+        replay    = strtoull(arg, NULL, 0);
+        do_replay = 1;
+        break;
+      case 's':
+        if(sscanf(arg, "%" SCNu64 "/%" SCNu64, &cfg.shard, &cfg.shards) != 2) {
+          usage(argv[0]);
+          return 1;
+        }
+        break;
+      case 'd':
+        cfg.decoder = DECODER_NUM;
+        for(uint32_t d = 0; d < DECODER_NUM; d++) {
+          if(strcmp(arg, decoders[d].name) == 0) {
+            cfg.decoder = d;
+          }
+        }
+        break;
+      default: usage(argv[0]); return 1;
+    }
+  }
+
+  if((cfg.threads == 0) || (cfg.shards == 0) || (cfg.shard >= cfg.shards) ||
+     (cfg.key_trials == 0) || (cfg.chunk == 0) ||
+     (cfg.decoder >= DECODER_NUM)) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  cpu_features_init();
+
+  if(do_replay) {
+    return replay_trial(&cfg, replay) ? 0 : 1;
+  }
+
+  dfr_stats_t * total   = calloc(1, sizeof(*total));
+  dfr_worker_t *workers = calloc(cfg.threads, sizeof(*workers));
+  if((total == NULL) || (workers == NULL)) {
+    fprintf(stderr, "Allocation failed\n");
+    return 1;
+  }
+
+  uint64_t next = 0;
+  if(cfg.ckpt_path != NULL) {
+    FILE *f = fopen(cfg.ckpt_path, "r");
+    if(f != NULL) {
+      const int ok = read_state(f, &cfg, &next, total);
+      fclose(f);
+      if(!ok) {
+        fprintf(stderr, "%s is not a checkpoint of this run\n", cfg.ckpt_path);
+        return 1;
+      }
+      fprintf(stderr, "Resuming at trial %" PRIu64 "\n", next);
+    }
+  }
+
+  FILE *out = NULL;
+  if(cfg.out_path != NULL) {
+    out = fopen(cfg.out_path, "a");
+    if(out == NULL) {
+      perror(cfg.out_path);
+      return 1;
+    }
+  }
+
+  struct sigaction sa;
+  bike_memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_signal;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+
+  time_t last_ckpt = time(NULL);
+  int    rc        = 0;
+
+  while((next < cfg.trials) && !stop_requested) {
+    for(uint32_t i = 0; i < cfg.threads; i++) {
+      dfr_worker_t *w = &workers[i];
+      bike_memset(w, 0, sizeof(*w));
+
+      const uint64_t first = next + (i * cfg.chunk);
+      w->cfg               = &cfg;
+      w->out               = out;
+      w->first             = (first < cfg.trials) ? first : cfg.trials;
+      w->last = ((cfg.trials - w->first) < cfg.chunk) ? cfg.trials
+                                                       : (w->first + cfg.chunk);
+    }
+
+    uint32_t started = 0;
+    while(started < cfg.threads) {
+      dfr_worker_t *w = &workers[started];
+      if(pthread_create(&w->thread, NULL, dfr_worker, w) != 0) {
+        fprintf(stderr, "Thread creation failed\n");
+        rc = 1;
+        break;
+      }
+      started++;
+    }
+
+    for(uint32_t i = 0; i < started; i++) {
+      pthread_join(workers[i].thread, NULL);
+    }
+
+    // The checkpoint holds the counters of the trials [0, next), so only the
+    // workers before the first one that did not complete its trials are
+    // counted (and of that worker, the trials before its error). The rounds
+    // stop after an error, and the checkpoint is written below.
+    for(uint32_t i = 0; i < started; i++) {
+      dfr_worker_t *w = &workers[i];
+
+      add_stats(total, &w->stats);
+      next = w->last;
+
+      if(w->error) {
+        fprintf(stderr, "Trial generation failed at trial %" PRIu64 "\n",
+                (w->last * cfg.shards) + cfg.shard);
+        rc = 1;
+        break;
+      }
+    }
+
+    if(rc != 0) {
+      break;
+    }
+
+    if((cfg.ckpt_path != NULL) &&
+       ((uint64_t)(time(NULL) - last_ckpt) >= cfg.interval)) {
+      if(!write_checkpoint(&cfg, next, total)) {
+        rc = 1;
+        break;
+      }
+      last_ckpt = time(NULL);
+
+      if(out != NULL) {
+        write_progress(out, total);
+      }
+    }
+  }
+
+  if((cfg.ckpt_path != NULL) && !write_checkpoint(&cfg, next, total)) {
+    rc = 1;
+  }
+
+  if(out != NULL) {
+    write_progress(out, total);
+    fclose(out);
+  }
+
+  write_state(stdout, &cfg, next, total);
+
+  free(workers);
+  free(total);
+  return rc;
+}
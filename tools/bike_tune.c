@@ -0,0 +1,65 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ *
+ * Measures the tuning profile of the gf2x functions on the current CPU
+ * (see include/internal/gf2x_tune.h) and prints it in the format of
+ * src/gf2x/gf2x_tune_profiles.h. With -o, the profile is appended to the
+ * given file instead, e.g.:
+ *   ./bike-tune -o ../src/gf2x/gf2x_tune_profiles.h
+ * The profile is stored for the level that the tool was built for.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cpu_features.h"
+#include "gf2x_tune.h"
+
+static const char *const mul_base_names[GF2X_MUL_BASE_NUM] = {
+  "GF2X_MUL_BASE_AUTO",         "GF2X_MUL_BASE_PORT",
+  "GF2X_MUL_BASE_PCLMUL",       "GF2X_MUL_BASE_VPCLMUL_AVX2",
+  "GF2X_MUL_BASE_VPCLMUL",      "GF2X_MUL_BASE_PMULL"};
+
+static void usage(IN const char *name)
+{
+  fprintf(stderr,
+          "Usage: %s [-o FILE]\n"
+          "  -o  append the profile to FILE (default: print it to stdout)\n",
+          name);
+}
+
+int main(int argc, char *argv[])
+{
+  const char *out_path = NULL;
+
+  if(argc == 3 && (strcmp(argv[1], "-o") == 0)) {
+    out_path = argv[2];
+  } else if(argc != 1) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  cpu_features_init();
+
+  gf2x_tune_profile_t p;
+  bike_tune(&p);
+
+  FILE *out = (out_path == NULL) ? stdout : fopen(out_path, "a");
+  if(out == NULL) {
+    perror(out_path);
+    return 1;
+  }
+
+  fprintf(out,
+          "GF2X_TUNE_PROFILE(0x%08" PRIx32 ", %" PRIu32 ", %" PRIu32 ", %s)\n",
+          p.cpu_sig, p.r_bits, p.k_sqr_thr, mul_base_names[p.mul_base]);
+
+  if(out != stdout) {
+    fclose(out);
+  }
+  return 0;
+}
@@ -0,0 +1,495 @@
+/* Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0"
+ *
+ * Written by Nir Drucker, Shay Gueron and Dusan Kostic,
+ * AWS Cryptographic Algorithms Group.
+ *
+ * Generator of the exponentiation schedule used by gf2x_mod_inv.
+ *
+ * The inversion in F_2[x]/(x^r - 1) computes a^-1 = a^(2^(r-1) - 2), see:
+ * [1] Nir Drucker, Shay Gueron, and Dusan Kostic. 2020. "Fast polynomial
+ * inversion for post quantum QC-MDPC cryptography". Cryptology ePrint Archive,
+ * 2020. https://eprint.iacr.org/2020/298.pdf
+ *
+ * Denote f_e = a^(2^e - 1). Then f_(i+j) = (f_i)^(2^j) * f_j, and
+ * a^-1 = (f_(r-2))^2. Therefore, every addition chain 1 = e_0, ..., e_n = r-2
+ * gives an inversion algorithm with exactly n multiplications, where step i
+ * (e_i = e_x + e_y) requires an exponentiation by 2^min(e_x, e_y). The
+ * exponentiation is computed either by repeated squaring or by a single
+ * k-squaring (a bit permutation), whichever is cheaper.
+ *
+ * This tool searches (Brauer/star) addition chains of minimal length for r-2
+ * and picks the chain that minimizes the weighted cost:
+ *   sum_i (MUL + min(k_i * SQR, K_SQR)) + SQR,
+ * subject to a limit on the number of polynomials that are alive at the same
+ * time. The result is written as a C header that gf2x_inv.c consumes.
+ * The left-to-right binary chain (equivalent to [1](Algorithm 2)) is always
+ * evaluated first, so the output is never worse than the binary schedule.
+ */
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bike_defs.h"
+#include "gf2x_tune.h"
+
+#define MAX_CHAIN_LEN (64)
+#define MAX_REGS      (16)
+
+// Default weights (in units of a single squaring). The k-squaring weight
+// matches the default threshold for switching from repeated squaring to
+// k-squaring in gf2x_inv.c.
+#define DEFAULT_MUL_COST    (64)
+#define DEFAULT_SQR_COST    (1)
+#define DEFAULT_K_SQR_COST  (64)
+#define DEFAULT_MAX_REGS    (4)
+#define DEFAULT_NODE_BUDGET (200000000ULL)
+
+// gf2x_mod_inv precomputes the permutation maps of the k-squarings only for
+// the steps with k above this threshold (see GF2X_INV_MAP_SLOTS)
+#define DEFAULT_MAP_THR (GF2X_DEFAULT_K_SQR_THR)
+
+// The map slot of the steps that have no map
+#define NO_MAP_SLOT (0xff)
+
+typedef struct step_s {
+  uint32_t dst;
+  uint32_t src;
+  uint32_t mul;
+  uint32_t k;
+  uint32_t l;
+} step_t;
+
+typedef struct search_s {
+  // Parameters
+  uint32_t r;
+  uint32_t n;
+  uint64_t mul_cost;
+  uint64_t sqr_cost;
+  uint64_t k_sqr_cost;
+  uint32_t max_regs;
+  uint64_t budget;
+  uint32_t map_thr;
+
+  // Current state of the depth-first search
+  uint32_t chain[MAX_CHAIN_LEN + 1];
+  uint32_t len;
+  uint64_t nodes;
+  uint64_t found;
+
+  // Best chain found so far
+  uint32_t best[MAX_CHAIN_LEN + 1];
+  uint32_t best_len;
+  uint64_t best_cost;
+  uint32_t best_regs;
+} search_t;
+
+static uint64_t exp_cost(IN const search_t *s, IN const uint32_t k)
+{
+  const uint64_t sqr_cost = (uint64_t)k * s->sqr_cost;
+  return (sqr_cost <= s->k_sqr_cost) ? sqr_cost : s->k_sqr_cost;
+}
+
+// Find the indices x >= y such that chain[i] = chain[x] + chain[y].
+// Star chains always satisfy x = i - 1, but we keep it general.
+static int find_operands(OUT uint32_t *x,
+                         OUT uint32_t *y,
+                         IN const uint32_t *chain,
+                         IN const uint32_t  i)
+{
+  for(uint32_t a = i; a-- > 0;) {
+    for(uint32_t b = a + 1; b-- > 0;) {
+      if(chain[a] + chain[b] == chain[i]) {
+        *x = a;
+        *y = b;
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+// Translate a chain into a sequence of steps with register allocation.
+// Return the number of registers that are required, or 0 on failure.
+static uint32_t chain_to_steps(OUT step_t *steps,
+                               OUT uint32_t *result_reg,
+                               IN const uint32_t *chain,
+                               IN const uint32_t  len)
+{
+  uint32_t reg_of[MAX_CHAIN_LEN + 1];
+  uint32_t last_use[MAX_CHAIN_LEN + 1];
+  uint32_t ops[MAX_CHAIN_LEN + 1][2];
+  uint32_t reg_busy[MAX_REGS] = {0};
+  uint32_t num_regs           = 1;
+
+  for(uint32_t i = 0; i <= len; i++) {
+    last_use[i] = i;
+  }
+
+  for(uint32_t i = 1; i <= len; i++) {
+    if(!find_operands(&ops[i][0], &ops[i][1], chain, i)) {
+      return 0;
+    }
+    last_use[ops[i][0]] = i;
+    last_use[ops[i][1]] = i;
+  }
+
+  // The input polynomial (f_1 = a) is in register 0.
+  reg_of[0]   = 0;
+  reg_busy[0] = 1;
+
+  for(uint32_t i = 1; i <= len; i++) {
+    const uint32_t x = ops[i][0];
+    const uint32_t y = ops[i][1];
+
+    // Exponentiate the larger element by 2^(smaller element), so that the
+    // exponent k (and therefore, the cost of the exponentiation) is minimal.
+    steps[i - 1].src = reg_of[x];
+    steps[i - 1].mul = reg_of[y];
+    steps[i - 1].k   = chain[y];
+
+    // Release the registers of operands that are not needed anymore.
+    // The output can overwrite them because the exponentiation is computed
+    // into a temporary buffer, and the multiplication supports in-place output.
+    if(last_use[x] == i) {
+      reg_busy[reg_of[x]] = 0;
+    }
+    if(last_use[y] == i) {
+      reg_busy[reg_of[y]] = 0;
+    }
+
+    uint32_t dst = 0;
+    while((dst < MAX_REGS) && reg_busy[dst]) {
+      dst++;
+    }
+    if(dst == MAX_REGS) {
+      return 0;
+    }
+
+    reg_busy[dst]    = 1;
+    reg_of[i]        = dst;
+    steps[i - 1].dst = dst;
+    num_regs         = (dst + 1 > num_regs) ? (dst + 1) : num_regs;
+  }
+
+  *result_reg = reg_of[len];
+  return num_regs;
+}
+
+static uint64_t chain_cost(IN const search_t *s,
+                           IN const uint32_t *chain,
+                           IN const uint32_t  len)
+{
+  uint64_t cost = s->sqr_cost;
+
+  for(uint32_t i = 1; i <= len; i++) {
+    uint32_t x = 0, y = 0;
+    find_operands(&x, &y, chain, i);
+    cost += s->mul_cost + exp_cost(s, chain[y]);
+  }
+
+  return cost;
+}
+
+static void consider_chain(IN OUT search_t *s,
+                           IN const uint32_t *chain,
+                           IN const uint32_t  len)
+{
+  step_t   steps[MAX_CHAIN_LEN];
+  uint32_t result_reg;
+
+  const uint32_t regs = chain_to_steps(steps, &result_reg, chain, len);
+  if((regs == 0) || (regs > s->max_regs)) {
+    return;
+  }
+
+  const uint64_t cost = chain_cost(s, chain, len);
+  if((s->best_len != 0) &&
+     ((cost > s->best_cost) ||
+      ((cost == s->best_cost) && (regs >= s->best_regs)))) {
+    return;
+  }
+
+  memcpy(s->best, chain, (len + 1) * sizeof(chain[0]));
+  s->best_len  = len;
+  s->best_cost = cost;
+  s->best_regs = regs;
+}
+
+// Depth first search over star chains of length s->len. The search visits
+// the larger candidates first, and prunes a branch when doubling the last
+// element in every remaining step cannot reach n.
+static void dfs(IN OUT search_t *s, IN const uint32_t i)
+{
+  if(++s->nodes > s->budget) {
+    return;
+  }
+
+  const uint32_t last = s->chain[i - 1];
+  if(last == s->n) {
+    s->found++;
+    consider_chain(s, s->chain, i - 1);
+    return;
+  }
+
+  if(((i - 1) == s->len) || (((uint64_t)last << (s->len - (i - 1))) < s->n)) {
+    return;
+  }
+
+  for(uint32_t j = i; j-- > 0;) {
+    const uint32_t next = last + s->chain[j];
+    if(next > s->n) {
+      continue;
+    }
+    s->chain[i] = next;
+    dfs(s, i + 1);
+  }
+}
+
+// The left-to-right binary chain for n.
+static uint32_t binary_chain(OUT uint32_t *chain, IN const uint32_t n)
+{
+  uint32_t len = 0;
+  int      top = 31;
+
+  while(((n >> top) & 1) == 0) {
+    top--;
+  }
+
+  chain[0] = 1;
+  for(int b = top - 1; b >= 0; b--) {
+    chain[len + 1] = 2 * chain[len];
+    len++;
+    if((n >> b) & 1) {
+      chain[len + 1] = chain[len] + 1;
+      len++;
+    }
+  }
+
+  return len;
+}
+
+static uint32_t mod_pow2(IN uint32_t k, IN const uint32_t r)
+{
+  uint64_t res = 1;
+  uint64_t b   = 2 % r;
+
+  while(k != 0) {
+    if(k & 1) {
+      res = (res * b) % r;
+    }
+    b = (b * b) % r;
+    k >>= 1;
+  }
+
+  return (uint32_t)res;
+}
+
+static uint32_t mod_inv(IN const uint32_t v, IN const uint32_t r)
+{
+  int64_t t = 0, new_t = 1;
+  int64_t q, tmp;
+  int64_t rr = r, new_rr = v;
+
+  while(new_rr != 0) {
+    q      = rr / new_rr;
+    tmp    = t - (q * new_t);
+    t      = new_t;
+    new_t  = tmp;
+    tmp    = rr - (q * new_rr);
+    rr     = new_rr;
+    new_rr = tmp;
+  }
+
+  return (uint32_t)((t < 0) ? (t + r) : t);
+}
+
+// Assigns a map slot to every step with k > map_thr. Steps with the same k
+// share the slot. Returns the number of the slots.
+static uint32_t map_slots(OUT uint32_t *slots,
+                          IN const step_t *steps,
+                          IN const uint32_t len,
+                          IN const uint32_t map_thr)
+{
+  uint32_t num_maps = 0;
+
+  for(uint32_t i = 0; i < len; i++) {
+    slots[i] = NO_MAP_SLOT;
+    if(steps[i].k <= map_thr) {
+      continue;
+    }
+
+    for(uint32_t j = 0; j < i; j++) {
+      if((steps[j].k == steps[i].k) && (slots[j] != NO_MAP_SLOT)) {
+        slots[i] = slots[j];
+        break;
+      }
+    }
+
+    if(slots[i] == NO_MAP_SLOT) {
+      slots[i] = num_maps++;
+    }
+  }
+
+  return num_maps;
+}
+
+static void print_header(OUT FILE *out, IN const search_t *s)
+{
+  step_t   steps[MAX_CHAIN_LEN];
+  uint32_t slots[MAX_CHAIN_LEN];
+  uint32_t result_reg;
+
+  chain_to_steps(steps, &result_reg, s->best, s->best_len);
+  const uint32_t num_maps = map_slots(slots, steps, s->best_len, s->map_thr);
+
+  fprintf(out, "/* Copyright Amazon.com, Inc. or its affiliates. "
+               "All Rights Reserved.\n");
+  fprintf(out, " * SPDX-License-Identifier: Apache-2.0\"\n");
+  fprintf(out, " *\n");
+  fprintf(out, " * This file is generated by bike-inv-chain, do not edit.\n");
+  fprintf(out, " *\n");
+  fprintf(out, " * Addition chain for r - 2 = %" PRIu32 " (%" PRIu32 " steps):\n",
+          s->n, s->best_len);
+  fprintf(out, " *  ");
+  for(uint32_t i = 0; i <= s->best_len; i++) {
+    fprintf(out, " %" PRIu32, s->best[i]);
+    if(((i % 10) == 9) && (i != s->best_len)) {
+      fprintf(out, "\n *  ");
+    }
+  }
+  fprintf(out, "\n *\n");
+  fprintf(out,
+          " * Cost weights: mul = %" PRIu64 ", sqr = %" PRIu64
+          ", k_sqr = %" PRIu64 " (total cost %" PRIu64 ").\n",
+          s->mul_cost, s->sqr_cost, s->k_sqr_cost, s->best_cost);
+  fprintf(out, " */\n\n");
+  fprintf(out, "#pragma once\n\n");
+  fprintf(out,
+          "bike_static_assert((R_BITS == %" PRIu32
+          "), gf2x_inv_schedule_doesnt_match_r);\n\n",
+          s->r);
+  fprintf(out, "#define GF2X_INV_NUM_REGS   (%" PRIu32 ")\n", s->best_regs);
+  fprintf(out, "#define GF2X_INV_NUM_STEPS  (%" PRIu32 ")\n", s->best_len);
+  fprintf(out, "#define GF2X_INV_RESULT_REG (%" PRIu32 ")\n", result_reg);
+  fprintf(out, "#define GF2X_INV_NUM_MAPS   (%" PRIu32 ")\n", num_maps);
+  fprintf(out, "#define GF2X_INV_NO_MAP     (%d)\n\n", NO_MAP_SLOT);
+  fprintf(out, "// Every step is {dst, src, mul, k, l} and computes\n");
+  fprintf(out, "//   reg[dst] = reg[src]^(2^k) * reg[mul] mod (x^r - 1),\n");
+  fprintf(out, "// where l = (2^-k) %% r is the k-squaring parameter.\n");
+  fprintf(out, "#define GF2X_INV_SCHEDULE_VALS");
+  for(uint32_t i = 0; i < s->best_len; i++) {
+    const uint32_t l = mod_inv(mod_pow2(steps[i].k, s->r), s->r);
+    fprintf(out,
+            " \\\n  {%" PRIu32 ", %" PRIu32 ", %" PRIu32 ", %" PRIu32
+            ", %" PRIu32 "}%s",
+            steps[i].dst, steps[i].src, steps[i].mul, steps[i].k, l,
+            (i + 1 == s->best_len) ? "" : ",");
+  }
+  fprintf(out, "\n\n");
+  fprintf(out,
+          "// The slot of the k-squaring map of every step with k > %" PRIu32
+          ",\n// or GF2X_INV_NO_MAP.\n",
+          s->map_thr);
+  fprintf(out, "#define GF2X_INV_MAP_SLOTS");
+  for(uint32_t i = 0; i < s->best_len; i++) {
+    fprintf(out, "%s%" PRIu32 "%s", ((i % 10) == 0) ? " \\\n  " : " ",
+            slots[i], (i + 1 == s->best_len) ? "" : ",");
+  }
+  fprintf(out, "\n");
+}
+
+static void usage(IN const char *name)
+{
+  fprintf(stderr,
+          "Usage: %s [-o FILE] [-r R] [-m MUL] [-s SQR] [-k K_SQR] [-g REGS] "
+          "[-b NODES] [-t THR]\n"
+          "  -o  the output file (default stdout)\n"
+          "  -r  the block size r (default %d)\n"
+          "  -m  the weight of a multiplication (default %d)\n"
+          "  -s  the weight of a squaring (default %d)\n"
+          "  -k  the weight of a k-squaring (default %d)\n"
+          "  -g  the maximal number of live polynomials (default %d)\n"
+          "  -b  the search budget in nodes per chain length (default %llu)\n"
+          "  -t  the steps with k > THR get a k-squaring map (default %d)\n",
+          name, R_BITS, DEFAULT_MUL_COST, DEFAULT_SQR_COST, DEFAULT_K_SQR_COST,
+          DEFAULT_MAX_REGS, DEFAULT_NODE_BUDGET, DEFAULT_MAP_THR);
+}
+
+int main(int argc, char *argv[])
+{
+  search_t    s        = {0};
+  const char *out_path = NULL;
+
+  s.r          = R_BITS;
+  s.mul_cost   = DEFAULT_MUL_COST;
+  s.sqr_cost   = DEFAULT_SQR_COST;
+  s.k_sqr_cost = DEFAULT_K_SQR_COST;
+  s.max_regs   = DEFAULT_MAX_REGS;
+  s.budget     = DEFAULT_NODE_BUDGET;
+  s.map_thr    = DEFAULT_MAP_THR;
+
+  for(int i = 1; i < argc; i++) {
+    if((argv[i][0] != '-') || (strlen(argv[i]) != 2) || (i + 1 == argc)) {
+      usage(argv[0]);
+      return 1;
+    }
+
+    if(argv[i][1] == 'o') {
+      out_path = argv[++i];
+      continue;
+    }
+
+    const unsigned long long val = strtoull(argv[++i], NULL, 0);
+    switch(argv[i - 1][1]) {
+      case 'r': s.r = (uint32_t)val; break;
+      case 'm': s.mul_cost = val; break;
+      case 's': s.sqr_cost = val; break;
+      case 'k': s.k_sqr_cost = val; break;
+      case 'g': s.max_regs = (uint32_t)val; break;
+      case 'b': s.budget = val; break;
+      case 't': s.map_thr = (uint32_t)val; break;
+      default: usage(argv[0]); return 1;
+    }
+  }
+
+  if((s.r < 4) || (s.max_regs < 2) || (s.max_regs > MAX_REGS)) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  s.n = s.r - 2;
+
+  // The binary chain is the baseline, and it requires only two registers.
+  s.best_len  = binary_chain(s.best, s.n);
+  s.best_cost = chain_cost(&s, s.best, s.best_len);
+  s.best_regs = 2;
+
+  // Iterative deepening: find the minimal length of a star chain for n
+  // (within the budget), and consider all the chains of that length.
+  s.chain[0] = 1;
+  for(s.len = 1; s.len <= s.best_len; s.len++) {
+    s.nodes = 0;
+    s.found = 0;
+    dfs(&s, 1);
+    if(s.found != 0) {
+      break;
+    }
+  }
+
+  FILE *out = (out_path == NULL) ? stdout : fopen(out_path, "w");
+  if(out == NULL) {
+    perror(out_path);
+    return 1;
+  }
+
+  print_header(out, &s);
+
+  if(out != stdout) {
+    fclose(out);
+  }
+  return 0;
+}